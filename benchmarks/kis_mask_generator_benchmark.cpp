@@ -37,6 +37,11 @@
 
 #include "kis_circle_mask_generator.h"
 #include "kis_rect_mask_generator.h"
+#include "kis_gauss_circle_mask_generator.h"
+#include "kis_gauss_rect_mask_generator.h"
+#include "kis_curve_circle_mask_generator.h"
+#include "kis_curve_rect_mask_generator.h"
+#include "kis_cubic_curve.h"
 
 void KisMaskGeneratorBenchmark::benchmarkCircle()
 {
@@ -60,7 +65,7 @@ void KisMaskGeneratorBenchmark::benchmarkCircle()
 #include "krita_utils.h"
 
 
-void benchmarkSIMD(qreal fade) {
+void benchmarkSIMD(KisMaskGenerator *gen) {
     const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
     KisFixedPaintDeviceSP dev = new KisFixedPaintDevice(cs);
     dev->setRect(QRect(0, 0, 1000, 1000));
@@ -70,9 +75,7 @@ void benchmarkSIMD(qreal fade) {
                             0.0, 1.0,
                             500, 500, 0);
 
-    KisCircleMaskGenerator gen(1000, 1.0, fade, fade, 2, false);
-
-    KisBrushMaskApplicatorBase *applicator = gen.applicator();
+    KisBrushMaskApplicatorBase *applicator = gen->applicator();
     applicator->initializeData(&data);
 
     QVector<QRect> rects = KritaUtils::splitRectIntoPatches(dev->bounds(), QSize(63, 63));
@@ -86,12 +89,44 @@ void benchmarkSIMD(qreal fade) {
 
 void KisMaskGeneratorBenchmark::benchmarkSIMD_SharpBrush()
 {
-    benchmarkSIMD(1.0);
+    KisCircleMaskGenerator gen(1000, 1.0, 1.0, 1.0, 2, false);
+    benchmarkSIMD(&gen);
 }
 
 void KisMaskGeneratorBenchmark::benchmarkSIMD_FadedBrush()
 {
-    benchmarkSIMD(0.5);
+    KisCircleMaskGenerator gen(1000, 1.0, 0.5, 0.5, 2, false);
+    benchmarkSIMD(&gen);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkSIMD_RectBrush()
+{
+    KisRectangleMaskGenerator gen(1000, 1.0, 0.5, 0.5, 2, true);
+    benchmarkSIMD(&gen);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkSIMD_GaussCircleBrush()
+{
+    KisGaussCircleMaskGenerator gen(1000, 1.0, 0.5, 0.5, 2, true);
+    benchmarkSIMD(&gen);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkSIMD_GaussRectBrush()
+{
+    KisGaussRectangleMaskGenerator gen(1000, 1.0, 0.5, 0.5, 2, true);
+    benchmarkSIMD(&gen);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkSIMD_CurveCircleBrush()
+{
+    KisCurveCircleMaskGenerator gen(1000, 1.0, 0.5, 0.5, 2, KisCubicCurve(), true);
+    benchmarkSIMD(&gen);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkSIMD_CurveRectBrush()
+{
+    KisCurveRectangleMaskGenerator gen(1000, 1.0, 0.5, 0.5, 2, KisCubicCurve(), true);
+    benchmarkSIMD(&gen);
 }
 
 void KisMaskGeneratorBenchmark::benchmarkSquare()
@@ -28,6 +28,11 @@ private Q_SLOTS:
     void benchmarkCircle();
     void benchmarkSIMD_SharpBrush();
     void benchmarkSIMD_FadedBrush();
+    void benchmarkSIMD_RectBrush();
+    void benchmarkSIMD_GaussCircleBrush();
+    void benchmarkSIMD_GaussRectBrush();
+    void benchmarkSIMD_CurveCircleBrush();
+    void benchmarkSIMD_CurveRectBrush();
     void benchmarkSquare();
 
 };
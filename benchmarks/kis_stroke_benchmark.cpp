@@ -43,6 +43,7 @@ inline double drand48()
 
 #include <brushengine/kis_paint_information.h>
 #include <brushengine/kis_paintop_preset.h>
+#include <brushengine/kis_paintop_settings.h>
 
 #define GMP_IMAGE_WIDTH 3274
 #define GMP_IMAGE_HEIGHT 2067
@@ -327,6 +328,44 @@ void KisStrokeBenchmark::colorsmudgeRL()
     benchmarkStroke(presetFileName);
 }
 
+void KisStrokeBenchmark::colorsmudgeBrushSizes_data()
+{
+    QTest::addColumn<qreal>("size");
+
+    QTest::newRow("100px") << 100.0;
+    QTest::newRow("300px") << 300.0;
+    QTest::newRow("600px") << 600.0;
+    QTest::newRow("1000px") << 1000.0;
+}
+
+void KisStrokeBenchmark::colorsmudgeBrushSizes()
+{
+    QFETCH(qreal, size);
+
+    KisPaintOpPresetSP preset = new KisPaintOpPreset(m_dataPath + "colorsmudge.kpp");
+    if (!preset->load()) {
+        dbgKrita << "The preset was not loaded correctly. Done.";
+        return;
+    }
+
+    preset->settings()->setPaintOpSize(size);
+    m_painter->setPaintOpPreset(preset, m_layer, m_image);
+
+    QPointF startPoint(0.10 * TEST_IMAGE_WIDTH, 0.5 * TEST_IMAGE_HEIGHT);
+    QPointF endPoint(0.90 * TEST_IMAGE_WIDTH, 0.5 * TEST_IMAGE_HEIGHT);
+
+    QBENCHMARK{
+        KisDistanceInformation currentDistance;
+        m_painter->paintLine(KisPaintInformation(startPoint, 1.0),
+                             KisPaintInformation(endPoint, 1.0),
+                             &currentDistance);
+    }
+
+#ifdef SAVE_OUTPUT
+    m_layer->paintDevice()->convertToQImage(0).save(m_outputPath + QString("colorsmudge_%1px").arg(size) + OUTPUT_FORMAT);
+#endif
+}
+
 /*
 void KisStrokeBenchmark::predefinedBrush()
 {
@@ -120,6 +120,8 @@ private Q_SLOTS:
 
     void colorsmudge();
     void colorsmudgeRL();
+    void colorsmudgeBrushSizes_data();
+    void colorsmudgeBrushSizes();
 /*
     void predefinedBrush();
     void predefinedBrushRL();
@@ -33,7 +33,6 @@
 #include <klocalizedstring.h>
 
 #include <KoColor.h>
-#include <KoColorSpaceMaths.h>
 #include <KoColorSpaceRegistry.h>
 
 #include "kis_datamanager.h"
@@ -476,13 +475,13 @@ void KisBrush::generateMaskAndApplyMaskOrCreateDab(KisFixedPaintDeviceSP dst,
     Q_UNUSED(softnessFactor);
 
     prepareBrushPyramid();
-    QImage outputImage = d->brushPyramid->createImage(KisDabShape(
+    const KisQImagePyramid::Mask outputMask = d->brushPyramid->createMask(KisDabShape(
             shape.scale() * d->scale, shape.ratio(),
             -normalizeAngle(shape.rotation() + d->angle)),
-        subPixelX, subPixelY);
+        subPixelX, subPixelY, hasColor());
 
-    qint32 maskWidth = outputImage.width();
-    qint32 maskHeight = outputImage.height();
+    qint32 maskWidth = outputMask.size.width();
+    qint32 maskHeight = outputMask.size.height();
 
     dst->setRect(QRect(0, 0, maskWidth, maskHeight));
     dst->initialize();
@@ -499,11 +498,8 @@ void KisBrush::generateMaskAndApplyMaskOrCreateDab(KisFixedPaintDeviceSP dst,
     qint32 pixelSize = cs->pixelSize();
     quint8 *dabPointer = dst->data();
     quint8 *rowPointer = dabPointer;
-    quint8 *alphaArray = new quint8[maskWidth];
-    bool hasColor = this->hasColor();
 
     for (int y = 0; y < maskHeight; y++) {
-        const quint8* maskPointer = outputImage.constScanLine(y);
         if (coloringInformation) {
             for (int x = 0; x < maskWidth; x++) {
                 if (color) {
@@ -517,30 +513,7 @@ void KisBrush::generateMaskAndApplyMaskOrCreateDab(KisFixedPaintDeviceSP dst,
             }
         }
 
-        if (hasColor) {
-            const quint8 *src = maskPointer;
-            quint8 *dst = alphaArray;
-            for (int x = 0; x < maskWidth; x++) {
-                const QRgb *c = reinterpret_cast<const QRgb*>(src);
-
-                *dst = KoColorSpaceMaths<quint8>::multiply(255 - qGray(*c), qAlpha(*c));
-                src += 4;
-                dst++;
-            }
-        }
-        else {
-            const quint8 *src = maskPointer;
-            quint8 *dst = alphaArray;
-            for (int x = 0; x < maskWidth; x++) {
-                const QRgb *c = reinterpret_cast<const QRgb*>(src);
-
-                *dst = KoColorSpaceMaths<quint8>::multiply(255 - *src, qAlpha(*c));
-                src += 4;
-                dst++;
-            }
-        }
-
-        cs->applyAlphaU8Mask(rowPointer, alphaArray, maskWidth);
+        cs->applyAlphaU8Mask(rowPointer, outputMask.row(y), maskWidth);
         rowPointer += maskWidth * pixelSize;
         dabPointer = rowPointer;
 
@@ -548,8 +521,6 @@ void KisBrush::generateMaskAndApplyMaskOrCreateDab(KisFixedPaintDeviceSP dst,
             coloringInformation->nextRow();
         }
     }
-
-    delete[] alphaArray;
 }
 
 KisFixedPaintDeviceSP KisBrush::paintDevice(const KoColorSpace * colorSpace,
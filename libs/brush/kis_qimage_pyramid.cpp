@@ -19,7 +19,9 @@
 #include "kis_qimage_pyramid.h"
 
 #include <limits>
+#include <QMutexLocker>
 #include <QPainter>
+#include <KoColorSpaceMaths.h>
 #include <kis_debug.h>
 
 #define MIPMAP_SIZE_THRESHOLD 512
@@ -27,6 +29,14 @@
 
 #define QPAINTER_WORKAROUND_BORDER 1
 
+/**
+ * The number of the transformed masks kept by the pyramid. The brushes
+ * with fixed angle or with a few discrete sizes generate the same masks
+ * over and over, and the rest of the brushes won't benefit from a
+ * bigger cache anyway.
+ */
+#define MAX_CACHED_MASKS 8
+
 
 KisQImagePyramid::KisQImagePyramid(const QImage &baseImage)
 {
@@ -316,3 +326,239 @@ QImage KisQImagePyramid::createImage(KisDabShape const& shape,
     return dstImage;
 }
 
+
+const QVector<quint8>& KisQImagePyramid::alphaLevel(int level, bool hasColor) const
+{
+    QVector<quint8> &alpha = m_levels[level].alphaLevels[hasColor];
+
+    if (alpha.isEmpty()) {
+        const QImage &image = m_levels[level].image;
+        const int width = image.width();
+        const int height = image.height();
+
+        alpha.resize(width * height);
+        quint8 *dst = alpha.data();
+
+        for (int y = 0; y < height; y++) {
+            const QRgb *src = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+
+            if (hasColor) {
+                for (int x = 0; x < width; x++, src++, dst++) {
+                    *dst = KoColorSpaceMaths<quint8>::multiply(255 - qGray(*src), qAlpha(*src));
+                }
+            } else {
+                for (int x = 0; x < width; x++, src++, dst++) {
+                    *dst = KoColorSpaceMaths<quint8>::multiply(255 - qBlue(*src), qAlpha(*src));
+                }
+            }
+        }
+    }
+
+    return alpha;
+}
+
+KisQImagePyramid::Mask KisQImagePyramid::createMask(KisDabShape const& shape,
+                                                   qreal subPixelX, qreal subPixelY,
+                                                   bool hasColor) const
+{
+    qreal baseScale = -1.0;
+    int level = findNearestLevel(shape.scale(), &baseScale);
+
+    QTransform transform;
+    QSize dstSize;
+
+    calculateParams(shape, subPixelX, subPixelY,
+                    m_originalSize, baseScale, m_levels[level].size,
+                    &transform, &dstSize);
+
+    QVector<quint8> src;
+
+    {
+        QMutexLocker l(&m_mutex);
+
+        for (int i = 0; i < m_cachedMasks.size(); i++) {
+            const CachedMask &cached = m_cachedMasks[i];
+
+            if (cached.level == level &&
+                cached.hasColor == hasColor &&
+                cached.transform == transform &&
+                cached.mask.size == dstSize) {
+
+                m_cachedMasks.move(i, 0);
+                return m_cachedMasks.first().mask;
+            }
+        }
+
+        // the data is implicitly shared, so it can be used without the lock
+        src = alphaLevel(level, hasColor);
+    }
+
+    const QSize srcSize = m_levels[level].image.size();
+
+    CachedMask cached;
+    cached.level = level;
+    cached.hasColor = hasColor;
+    cached.transform = transform;
+    cached.mask.size = dstSize;
+    cached.mask.data.resize(dstSize.width() * dstSize.height());
+
+    if (transform.isIdentity()) {
+        const int dstWidth = dstSize.width();
+        const int width = qMin(dstWidth, srcSize.width() - 2 * QPAINTER_WORKAROUND_BORDER);
+        const int height = qMin(dstSize.height(), srcSize.height() - 2 * QPAINTER_WORKAROUND_BORDER);
+        const int srcOffset = QPAINTER_WORKAROUND_BORDER * srcSize.width() + QPAINTER_WORKAROUND_BORDER;
+
+        for (int y = 0; y < height; y++) {
+            memcpy(cached.mask.data.data() + y * dstWidth,
+                   src.constData() + srcOffset + y * srcSize.width(),
+                   width);
+        }
+    } else {
+        resampleMask(src.constData(), srcSize,
+                     QTransform::fromTranslate(-QPAINTER_WORKAROUND_BORDER,
+                                               -QPAINTER_WORKAROUND_BORDER) * transform,
+                     &cached.mask);
+    }
+
+    QMutexLocker l(&m_mutex);
+
+    m_cachedMasks.prepend(cached);
+    while (m_cachedMasks.size() > MAX_CACHED_MASKS) {
+        m_cachedMasks.removeLast();
+    }
+
+    return cached.mask;
+}
+
+namespace {
+
+/**
+ * Positions are handled in 16.16 fixed point, the bilinear
+ * weights are 8-bit
+ */
+const int fixedPointShift = 16;
+const qreal fixedPointOne = qreal(1 << fixedPointShift);
+
+inline int toFixed(qreal value) {
+    return qRound(value * fixedPointOne);
+}
+
+/**
+ * The pixels outside the source are transparent. Since every level
+ * has a transparent border, a sample that touches a pixel outside the
+ * level involves only transparent pixels, so it is just zero.
+ */
+inline quint8 sampleBilinear(const quint8 *src, int width, int height, int sx, int sy)
+{
+    const int ix = sx >> fixedPointShift;
+    const int iy = sy >> fixedPointShift;
+
+    if (uint(ix) >= uint(width - 1) || uint(iy) >= uint(height - 1)) {
+        return 0;
+    }
+
+    const int wx = (sx >> 8) & 0xff;
+    const int wy = (sy >> 8) & 0xff;
+
+    const quint8 *p = src + iy * width + ix;
+
+    const int top = p[0] * (256 - wx) + p[1] * wx;
+    const int bottom = p[width] * (256 - wx) + p[width + 1] * wx;
+
+    return quint8((top * (256 - wy) + bottom * wy + (1 << 15)) >> 16);
+}
+
+}
+
+void KisQImagePyramid::resampleMask(const quint8 *src, const QSize &srcSize,
+                                    const QTransform &transform, Mask *dst)
+{
+    const QTransform inverted = transform.inverted();
+
+    if (qFuzzyIsNull(inverted.m12()) && qFuzzyIsNull(inverted.m21())) {
+        resampleMaskScaled(src, srcSize, inverted, dst);
+        return;
+    }
+
+    const int srcWidth = srcSize.width();
+    const int srcHeight = srcSize.height();
+    const int dstWidth = dst->size.width();
+    const int dstHeight = dst->size.height();
+
+    const int dxx = toFixed(inverted.m11());
+    const int dxy = toFixed(inverted.m12());
+
+    quint8 *dstPtr = dst->data.data();
+
+    for (int y = 0; y < dstHeight; y++) {
+        /**
+         * The row start is recalculated in floating point to avoid
+         * accumulating the fixed point error. The sampling is done
+         * at the centers of the pixels.
+         */
+        const QPointF start = inverted.map(QPointF(0.5, y + 0.5)) - QPointF(0.5, 0.5);
+        int sx = toFixed(start.x());
+        int sy = toFixed(start.y());
+
+        for (int x = 0; x < dstWidth; x++, dstPtr++) {
+            *dstPtr = sampleBilinear(src, srcWidth, srcHeight, sx, sy);
+            sx += dxx;
+            sy += dxy;
+        }
+    }
+}
+
+void KisQImagePyramid::resampleMaskScaled(const quint8 *src, const QSize &srcSize,
+                                          const QTransform &inverted, Mask *dst)
+{
+    const int srcWidth = srcSize.width();
+    const int srcHeight = srcSize.height();
+    const int dstWidth = dst->size.width();
+    const int dstHeight = dst->size.height();
+
+    /**
+     * Without rotation the filter is separable: the source columns and
+     * weights are calculated once per destination column, which leaves
+     * the inner loop with a few table lookups and integer multiplications
+     */
+    QVector<int> columnOffsets(dstWidth);
+    QVector<int> columnWeights(dstWidth);
+    QVector<bool> columnValid(dstWidth);
+
+    for (int x = 0; x < dstWidth; x++) {
+        const int sx = toFixed(inverted.m11() * (x + 0.5) + inverted.dx() - 0.5);
+        const int ix = sx >> fixedPointShift;
+
+        columnValid[x] = uint(ix) < uint(srcWidth - 1);
+        columnOffsets[x] = columnValid[x] ? ix : 0;
+        columnWeights[x] = (sx >> 8) & 0xff;
+    }
+
+    quint8 *dstPtr = dst->data.data();
+
+    for (int y = 0; y < dstHeight; y++) {
+        const int sy = toFixed(inverted.m22() * (y + 0.5) + inverted.dy() - 0.5);
+        const int iy = sy >> fixedPointShift;
+
+        if (uint(iy) >= uint(srcHeight - 1)) {
+            memset(dstPtr, 0, dstWidth);
+            dstPtr += dstWidth;
+            continue;
+        }
+
+        const int wy = (sy >> 8) & 0xff;
+        const quint8 *row0 = src + iy * srcWidth;
+        const quint8 *row1 = row0 + srcWidth;
+
+        for (int x = 0; x < dstWidth; x++, dstPtr++) {
+            const int ix = columnOffsets[x];
+            const int wx = columnWeights[x];
+
+            const int top = row0[ix] * (256 - wx) + row0[ix + 1] * wx;
+            const int bottom = row1[ix] * (256 - wx) + row1[ix + 1] * wx;
+            const quint8 value = quint8((top * (256 - wy) + bottom * wy + (1 << 15)) >> 16);
+
+            *dstPtr = columnValid[x] ? value : 0;
+        }
+    }
+}
@@ -20,6 +20,9 @@
 #define __KIS_QIMAGE_PYRAMID_H
 
 #include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QTransform>
 #include <QVector>
 #include <kis_dab_shape.h>
 #include <kritabrush_export.h>
@@ -27,6 +30,20 @@
 
 class BRUSH_EXPORT KisQImagePyramid
 {
+public:
+    /**
+     * An 8-bit mask of the transformed brush tip, stored
+     * contiguously row by row
+     */
+    struct Mask {
+        QSize size;
+        QVector<quint8> data;
+
+        inline const quint8* row(int y) const {
+            return data.constData() + y * size.width();
+        }
+    };
+
 public:
     KisQImagePyramid(const QImage &baseImage);
     ~KisQImagePyramid();
@@ -40,6 +57,19 @@ public:
     QImage createImage(KisDabShape const&,
                        qreal subPixelX, qreal subPixelY) const;
 
+    /**
+     * Creates a mask of the same size and placement as createImage()
+     * does, but resamples the 8-bit alpha levels of the pyramid
+     * directly, without QPainter.
+     *
+     * If \p hasColor is true, the mask is calculated from the lightness
+     * of a colored tip, otherwise the tip is considered to be grayscale.
+     * The alpha levels of each kind are generated on the first request.
+     */
+    Mask createMask(KisDabShape const&,
+                    qreal subPixelX, qreal subPixelY,
+                    bool hasColor) const;
+
 private:
     friend class KisGbrBrushTest;
     int findNearestLevel(qreal scale, qreal *baseScale) const;
@@ -66,9 +96,33 @@ private:
 
         QImage image;
         QSize size;
+
+        // the alpha versions of the (bordered) image, for the
+        // grayscale and the colored tips correspondingly
+        mutable QVector<quint8> alphaLevels[2];
     };
 
+    struct CachedMask {
+        int level;
+        bool hasColor;
+        QTransform transform;
+        Mask mask;
+    };
+
+    // should be called with m_mutex held
+    const QVector<quint8>& alphaLevel(int level, bool hasColor) const;
+
+    static void resampleMask(const quint8 *src, const QSize &srcSize,
+                             const QTransform &transform, Mask *dst);
+
+    static void resampleMaskScaled(const quint8 *src, const QSize &srcSize,
+                                   const QTransform &inverted, Mask *dst);
+
+private:
     QVector<PyramidLevel> m_levels;
+
+    mutable QMutex m_mutex;
+    mutable QList<CachedMask> m_cachedMasks;
 };
 
 #endif /* __KIS_QIMAGE_PYRAMID_H */
@@ -258,6 +258,25 @@ void KisGbrBrushTest::benchmarkMaskScaling()
     }
 }
 
+void KisGbrBrushTest::benchmarkMaskRotation()
+{
+    KisGbrBrush* brush = new KisGbrBrush(QString(FILES_DATA_DIR) + QDir::separator() + "testing_brush_512_bars.gbr");
+    brush->load();
+    QVERIFY(!brush->brushTipImage().isNull());
+    brush->prepareBrushPyramid();
+    qsrand(1);
+
+    const KoColorSpace* cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintInformation info(QPointF(100.0, 100.0), 0.5);
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+
+    QBENCHMARK {
+        KoColor c(Qt::black, cs);
+        qreal rotation = qreal(qrand()) / RAND_MAX * 2 * M_PI;
+        brush->mask(dab, c, KisDabShape(0.5, 1.0, rotation), info, 0.0, 0.0, 1.0);
+    }
+}
+
 void KisGbrBrushTest::testPyramidLevelRounding()
 {
     QSize imageSize(41, 41);
@@ -310,6 +329,62 @@ void KisGbrBrushTest::testPyramidDabTransform()
     QCOMPARE(dabTransformHelper(KisDabShape(1.0, 0.5, M_PI / 4)), QSize(160, 160));
 }
 
+void KisGbrBrushTest::testPyramidMaskResampling()
+{
+    QImage image(40, 30, QImage::Format_ARGB32);
+    image.fill(qRgba(0, 0, 0, 0));
+
+    {
+        QPainter gc(&image);
+        gc.setRenderHints(QPainter::Antialiasing);
+        gc.setPen(Qt::NoPen);
+        gc.setBrush(Qt::black);
+        gc.drawEllipse(QRectF(5, 5, 30, 20));
+        gc.setBrush(Qt::gray);
+        gc.drawRect(QRectF(15, 10, 10, 10));
+    }
+
+    KisQImagePyramid pyramid(image);
+
+    QList<KisDabShape> shapes;
+    shapes << KisDabShape(1.0, 1.0, 0.0)
+           << KisDabShape(0.7, 1.0, 0.0)
+           << KisDabShape(1.3, 0.5, 0.0)
+           << KisDabShape(1.0, 1.0, M_PI / 6)
+           << KisDabShape(0.4, 0.8, 2.0);
+
+    Q_FOREACH (const KisDabShape &shape, shapes) {
+        const qreal subPixel = 0.3;
+
+        QImage reference = pyramid.createImage(shape, subPixel, subPixel);
+        KisQImagePyramid::Mask mask = pyramid.createMask(shape, subPixel, subPixel, false);
+
+        QCOMPARE(mask.size, reference.size());
+
+        /**
+         * QPainter does its own rounding, so the masks are compared
+         * by the average difference only
+         */
+        qint64 totalDifference = 0;
+
+        for (int y = 0; y < reference.height(); y++) {
+            const QRgb *refPixel = reinterpret_cast<const QRgb*>(reference.constScanLine(y));
+            const quint8 *maskPixel = mask.row(y);
+
+            for (int x = 0; x < reference.width(); x++) {
+                const int expected = (255 - qBlue(refPixel[x])) * qAlpha(refPixel[x]) / 255;
+                totalDifference += qAbs(expected - int(maskPixel[x]));
+            }
+        }
+
+        QVERIFY(totalDifference <= 2 * reference.width() * reference.height());
+
+        // the second request is served from the cache
+        KisQImagePyramid::Mask cachedMask = pyramid.createMask(shape, subPixel, subPixel, false);
+        QCOMPARE(cachedMask.data.constData(), mask.data.constData());
+    }
+}
+
 // see comment in KisQImagePyramid::appendPyramidLevel
 void KisGbrBrushTest::testQPainterTransformationBorder()
 {
@@ -609,6 +609,58 @@ bool KUndo2QStack::checkUndoLimit()
     return true;
 }
 
+/*!
+    Returns true if purgeOldestCommand() can delete a command now: no
+    macro is being composed and there is at least one undoable command
+    besides the most recent one.
+
+    \sa purgeOldestCommand()
+*/
+
+bool KUndo2QStack::canPurgeOldestCommand() const
+{
+    return m_macro_stack.isEmpty() && m_index > 1;
+}
+
+/*!
+    Deletes the command at the bottom of the stack, so that it cannot
+    be undone anymore. The most recent command is never deleted, as
+    well as the commands that can be redone. It lets the owner of the
+    stack limit the history by the memory it consumes, not only by the
+    number of commands.
+
+    Returns true if a command was deleted.
+
+    \sa setUndoLimit(), canPurgeOldestCommand()
+*/
+
+bool KUndo2QStack::purgeOldestCommand()
+{
+    if (!canPurgeOldestCommand())
+        return false;
+
+    delete m_command_list.takeFirst();
+
+    m_index--;
+
+    if (m_lastMergedIndex > 0) {
+        m_lastMergedIndex--;
+    } else {
+        // the merge destination is deleted, the next command of the set takes its place
+        m_lastMergedSetCount = qMax(0, m_lastMergedSetCount - 1);
+    }
+
+    if (m_clean_index != -1) {
+        if (m_clean_index < 1)
+            m_clean_index = -1; // we've deleted the clean command
+        else
+            m_clean_index--;
+    }
+
+    emit indexChanged(m_index);
+    return true;
+}
+
 /*!
     Constructs an empty undo stack with the parent \a parent. The
     stack will initially be in the clean state. If \a parent is a
@@ -201,6 +201,9 @@ public:
     void setUndoLimit(int limit);
     int undoLimit() const;
 
+    bool canPurgeOldestCommand() const;
+    bool purgeOldestCommand();
+
     const KUndo2Command *command(int index) const;
 
     void setUseCumulativeUndoRedo(bool value);
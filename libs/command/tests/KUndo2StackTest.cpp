@@ -0,0 +1,166 @@
+/*
+ *  Copyright (c) 2026 agent <agent@local>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KUndo2StackTest.h"
+
+#include <QTest>
+
+#include "kundo2stack.h"
+
+
+namespace {
+
+KUndo2Command* createCommand(const QString &name, int timedId = -1)
+{
+    KUndo2Command *cmd = new KUndo2Command(kundo2_noi18n(name));
+    cmd->setTimedID(timedId);
+    return cmd;
+}
+
+}
+
+void KUndo2StackTest::testPurgeOldestCommand()
+{
+    KUndo2QStack stack;
+
+    stack.push(createCommand("a"));
+    stack.push(createCommand("b"));
+    stack.push(createCommand("c"));
+
+    QVERIFY(stack.canPurgeOldestCommand());
+    QVERIFY(stack.purgeOldestCommand());
+
+    QCOMPARE(stack.count(), 2);
+    QCOMPARE(stack.index(), 2);
+    QCOMPARE(stack.text(0), QString("b"));
+    QCOMPARE(stack.text(1), QString("c"));
+
+    stack.undo();
+    stack.undo();
+    QCOMPARE(stack.index(), 0);
+    QVERIFY(!stack.canUndo());
+}
+
+void KUndo2StackTest::testPurgeKeepsLastAndRedoCommands()
+{
+    KUndo2QStack stack;
+
+    stack.push(createCommand("a"));
+    QVERIFY(!stack.canPurgeOldestCommand());
+    QVERIFY(!stack.purgeOldestCommand());
+
+    stack.push(createCommand("b"));
+    stack.push(createCommand("c"));
+    stack.undo();
+
+    QVERIFY(stack.purgeOldestCommand());
+    QCOMPARE(stack.count(), 2);
+    QCOMPARE(stack.index(), 1);
+    QCOMPARE(stack.undoText(), QString("b"));
+    QCOMPARE(stack.redoText(), QString("c"));
+
+    // "b" is the only undoable command now
+    QVERIFY(!stack.purgeOldestCommand());
+
+    stack.redo();
+    stack.beginMacro(kundo2_noi18n("macro"));
+    QVERIFY(!stack.canPurgeOldestCommand());
+    QVERIFY(!stack.purgeOldestCommand());
+    stack.endMacro();
+
+    QVERIFY(stack.purgeOldestCommand());
+    QCOMPARE(stack.count(), 2);
+    QCOMPARE(stack.text(0), QString("c"));
+    QCOMPARE(stack.text(1), QString("macro"));
+}
+
+void KUndo2StackTest::testPurgeCleanIndex()
+{
+    {
+        KUndo2QStack stack;
+
+        // the clean state is the empty stack
+        stack.push(createCommand("a"));
+        stack.push(createCommand("b"));
+        stack.push(createCommand("c"));
+        QCOMPARE(stack.cleanIndex(), 0);
+
+        QVERIFY(stack.purgeOldestCommand());
+        QCOMPARE(stack.cleanIndex(), -1);
+
+        stack.undo();
+        stack.undo();
+        QVERIFY(!stack.isClean());
+    }
+
+    {
+        KUndo2QStack stack;
+
+        stack.push(createCommand("a"));
+        stack.push(createCommand("b"));
+        stack.setClean();
+        stack.push(createCommand("c"));
+        QCOMPARE(stack.cleanIndex(), 2);
+
+        QVERIFY(stack.purgeOldestCommand());
+        QCOMPARE(stack.cleanIndex(), 1);
+        QVERIFY(!stack.isClean());
+
+        stack.undo();
+        QVERIFY(stack.isClean());
+        QCOMPARE(stack.undoText(), QString("b"));
+    }
+}
+
+void KUndo2StackTest::testPurgeMergeIndex()
+{
+    KUndo2QStack stack;
+
+    stack.setUseCumulativeUndoRedo(true);
+    stack.setStrokesN(2);
+    // all the commands belong to one set and the T1 rule never triggers
+    stack.setTimeT1(1000);
+    stack.setTimeT2(1000);
+
+    stack.push(createCommand("p0"));
+    stack.push(createCommand("p1"));
+
+    KUndo2Command *t0 = createCommand("t0", 1);
+    stack.push(t0);
+    stack.push(createCommand("t1", 1));
+
+    // the N rule merges "t1" into "t0"
+    stack.push(createCommand("t2", 1));
+    QCOMPARE(stack.count(), 4);
+    QVERIFY(stack.command(2) == t0);
+    QCOMPARE(t0->mergeCommandsVector().size(), 1);
+
+    QVERIFY(stack.purgeOldestCommand());
+    QCOMPARE(stack.count(), 3);
+    QVERIFY(stack.command(1) == t0);
+
+    // "t2" should be merged into the same destination, which has moved
+    stack.push(createCommand("t3", 1));
+    QCOMPARE(stack.count(), 3);
+    QVERIFY(stack.command(1) == t0);
+    QCOMPARE(t0->mergeCommandsVector().size(), 2);
+    QCOMPARE(stack.text(2), QString("t3"));
+    QCOMPARE(stack.index(), 3);
+}
+
+QTEST_GUILESS_MAIN(KUndo2StackTest)
@@ -18,6 +18,12 @@
 
 #include "kis_generator_layer.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegion>
+#include <QtConcurrent>
+#include <QtMath>
+
 #include <klocalizedstring.h>
 #include "kis_debug.h"
 
@@ -32,20 +38,64 @@
 #include "kis_processing_visitor.h"
 #include "kis_thread_safe_signal_compressor.h"
 #include "kis_recalculate_generator_layer_job.h"
+#include "kis_image.h"
 
 
 #define UPDATE_DELAY 100 /*ms */
 
+/**
+ * The generated area is split into chunks of this size, which are
+ * generated in parallel. It is a multiple of the tile size, so the
+ * threads never write into the same tile.
+ */
+#define GENERATOR_CHUNK_SIZE 256
+
 struct Q_DECL_HIDDEN KisGeneratorLayer::Private
 {
     Private()
-        : updateSignalCompressor(UPDATE_DELAY, KisSignalCompressor::FIRST_INACTIVE)
+        : updateSignalCompressor(UPDATE_DELAY, KisSignalCompressor::FIRST_INACTIVE),
+          needsFullRegeneration(true)
     {
     }
 
     KisThreadSafeSignalCompressor updateSignalCompressor;
+
+    /**
+     * The generated pixels depend only on the configuration of the
+     * generator (the patterns are anchored to the image origin), so
+     * the area which has already been generated is kept until the
+     * configuration changes. Updates then generate only the area
+     * the layer has grown to.
+     */
+    QMutex generatedRegionLock;
+    QRegion generatedRegion;
+    bool needsFullRegeneration;
+
+    static QVector<QRect> splitIntoChunks(const QRegion &region);
 };
 
+QVector<QRect> KisGeneratorLayer::Private::splitIntoChunks(const QRegion &region)
+{
+    QVector<QRect> chunks;
+
+    Q_FOREACH (const QRect &rc, region.rects()) {
+        const int firstColumn = qFloor(qreal(rc.left()) / GENERATOR_CHUNK_SIZE);
+        const int lastColumn = qFloor(qreal(rc.right()) / GENERATOR_CHUNK_SIZE);
+        const int firstRow = qFloor(qreal(rc.top()) / GENERATOR_CHUNK_SIZE);
+        const int lastRow = qFloor(qreal(rc.bottom()) / GENERATOR_CHUNK_SIZE);
+
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int column = firstColumn; column <= lastColumn; column++) {
+                const QRect chunk(column * GENERATOR_CHUNK_SIZE, row * GENERATOR_CHUNK_SIZE,
+                                  GENERATOR_CHUNK_SIZE, GENERATOR_CHUNK_SIZE);
+                chunks << (chunk & rc);
+            }
+        }
+    }
+
+    return chunks;
+}
+
 
 KisGeneratorLayer::KisGeneratorLayer(KisImageWSP image,
                                      const QString &name,
@@ -63,6 +113,11 @@ KisGeneratorLayer::KisGeneratorLayer(const KisGeneratorLayer& rhs)
       m_d(new Private)
 {
     connect(&m_d->updateSignalCompressor, SIGNAL(timeout()), SLOT(slotDelayedStaticUpdate()));
+
+    // the pixels are copied together with the layer
+    QMutexLocker l(&rhs.m_d->generatedRegionLock);
+    m_d->generatedRegion = rhs.m_d->generatedRegion;
+    m_d->needsFullRegeneration = rhs.m_d->needsFullRegeneration;
 }
 
 KisGeneratorLayer::~KisGeneratorLayer()
@@ -72,6 +127,12 @@ KisGeneratorLayer::~KisGeneratorLayer()
 void KisGeneratorLayer::setFilter(KisFilterConfigurationSP filterConfig)
 {
     KisSelectionBasedLayer::setFilter(filterConfig);
+
+    {
+        QMutexLocker l(&m_d->generatedRegionLock);
+        m_d->needsFullRegeneration = true;
+    }
+
     update();
 }
 
@@ -103,22 +164,55 @@ void KisGeneratorLayer::update()
     KisGeneratorSP f = KisGeneratorRegistry::instance()->value(filterConfig->name());
     if (!f) return;
 
+    KisImageSP imageSP = image().toStrongRef();
+    if (!imageSP) return;
+
     QRect processRect = exactBounds();
+    QRegion regionToGenerate;
+
+    {
+        QMutexLocker l(&m_d->generatedRegionLock);
 
-    resetCache();
+        KisPaintDeviceSP originalDevice = original();
 
-    KisPaintDeviceSP originalDevice = original();
+        // the device is recreated when the image changes its color space
+        if (m_d->needsFullRegeneration ||
+            !originalDevice ||
+            *originalDevice->colorSpace() != *imageSP->colorSpace()) {
+
+            resetCache();
+            m_d->generatedRegion = QRegion();
+            m_d->needsFullRegeneration = false;
+        }
 
-    KisProcessingInformation dstCfg(originalDevice,
-                                    processRect.topLeft(),
-                                    KisSelectionSP());
+        regionToGenerate = QRegion(processRect) - m_d->generatedRegion;
+        m_d->generatedRegion += processRect;
+    }
 
-    f->generate(dstCfg, processRect.size(), filterConfig.data());
+    if (regionToGenerate.isEmpty()) return;
 
+    KisPaintDeviceSP originalDevice = original();
+    QVector<QRect> chunks = Private::splitIntoChunks(regionToGenerate);
+
+    auto generateChunk = [originalDevice, f, filterConfig] (const QRect &rc) {
+        KisProcessingInformation dstCfg(originalDevice,
+                                        rc.topLeft(),
+                                        KisSelectionSP());
+
+        f->generate(dstCfg, rc.size(), filterConfig.data());
+    };
+
+    if (f->supportsThreading() && chunks.size() > 1) {
+        QtConcurrent::blockingMap(chunks, generateChunk);
+    } else {
+        Q_FOREACH (const QRect &rc, chunks) {
+            generateChunk(rc);
+        }
+    }
 
     // hack alert!
     // this avoids cyclic loop with KisRecalculateGeneratorLayerJob::run()
-    KisSelectionBasedLayer::setDirty(extent());
+    KisSelectionBasedLayer::setDirty(regionToGenerate.boundingRect());
 }
 
 bool KisGeneratorLayer::accept(KisNodeVisitor & v)
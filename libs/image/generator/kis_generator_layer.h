@@ -33,7 +33,10 @@ class KisFilterConfiguration;
  *
  * It is not possible to destructively paint on a generator layer.
  *
- * XXX: what about threadedness?
+ * The layer is generated in chunks in parallel (unless the generator
+ * doesn't support threading). The generated pixels are kept until
+ * the configuration of the generator changes, so that the updates of
+ * the layer regenerate only the area that hasn't been generated yet.
  */
 class KRITAIMAGE_EXPORT KisGeneratorLayer : public KisSelectionBasedLayer
 {
@@ -63,7 +66,8 @@ public:
 
     /**
      * re-run the generator. This happens over the bounds
-     * of the associated selection.
+     * of the associated selection, excluding the area that
+     * has already been generated with the current configuration.
      */
     void update();
 
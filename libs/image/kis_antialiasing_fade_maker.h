@@ -21,6 +21,8 @@
 
 #include "kis_global.h"
 
+#include <compositeops/KoVcMultiArchBuildSupport.h>
+
 template <class BaseFade>
 class KisAntialiasingFadeMaker1D
 {
@@ -83,6 +85,38 @@ public:
         return false;
     }
 
+#if defined HAVE_VC
+    /**
+     * Vectorized version of needFade(). The values of the lanes that
+     * need fading are written into \p dist in normalized form (1.0
+     * means fully transparent).
+     *
+     * @return the mask of the lanes that have been processed
+     */
+    Vc::float_m needFade(Vc::float_v &dist) const {
+        const Vc::float_v vOne(Vc::One);
+        const Vc::float_v vValMax(255.f);
+
+        const Vc::float_v vRadius(m_radius);
+        const Vc::float_v vFadeStartValue(float(m_fadeStartValue));
+        const Vc::float_v vAntialiasingFadeStart(m_antialiasingFadeStart);
+        const Vc::float_v vAntialiasingFadeCoeff(m_antialiasingFadeCoeff);
+
+        Vc::float_m outsideMask = dist > vRadius;
+        Vc::float_m fadeMask(false);
+
+        if (m_enableAntialiasing) {
+            fadeMask = !outsideMask && dist > vAntialiasingFadeStart;
+            dist(fadeMask) = (vFadeStartValue +
+                              (dist - vAntialiasingFadeStart) * vAntialiasingFadeCoeff) / vValMax;
+        }
+
+        dist(outsideMask) = vOne;
+
+        return outsideMask || fadeMask;
+    }
+#endif /* defined HAVE_VC */
+
 private:
     qreal m_radius;
     quint8 m_fadeStartValue;
@@ -174,6 +208,42 @@ public:
         return false;
     }
 
+#if defined HAVE_VC
+    /**
+     * @return the mask of the lanes lying outside the limits
+     */
+    Vc::float_m outsideMask(Vc::float_v::AsArg x, Vc::float_v::AsArg y) const {
+        return Vc::abs(x) > Vc::float_v(m_xLimit) ||
+               Vc::abs(y) > Vc::float_v(m_yLimit);
+    }
+
+    /**
+     * Vectorized version of needFade(). Unlike the scalar version, it
+     * accepts the already calculated base value of the mask in \p value
+     * (in normalized form, 1.0 means fully transparent) and applies the
+     * antialiasing fade and the limits to it.
+     */
+    void applyFade(Vc::float_v::AsArg x, Vc::float_v::AsArg y, Vc::float_v &value) const {
+        const Vc::float_v vOne(Vc::One);
+
+        const Vc::float_v xa = Vc::abs(x);
+        const Vc::float_v ya = Vc::abs(y);
+
+        if (m_enableAntialiasing) {
+            const Vc::float_v vXFadeLimitStart(m_xFadeLimitStart);
+            const Vc::float_v vYFadeLimitStart(m_yFadeLimitStart);
+
+            Vc::float_m xFadeMask = xa > vXFadeLimitStart;
+            value(xFadeMask) += (vOne - value) * (xa - vXFadeLimitStart) * Vc::float_v(m_xFadeCoeff);
+
+            Vc::float_m yFadeMask = ya > vYFadeLimitStart;
+            value(yFadeMask) += (vOne - value) * (ya - vYFadeLimitStart) * Vc::float_v(m_yFadeCoeff);
+        }
+
+        value(outsideMask(x, y)) = vOne;
+    }
+#endif /* defined HAVE_VC */
+
 private:
     qreal m_xLimit;
     qreal m_yLimit;
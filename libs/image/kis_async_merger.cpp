@@ -40,6 +40,7 @@
 #include "kis_clone_layer.h"
 #include "kis_processing_information.h"
 #include "kis_busy_progress_indicator.h"
+#include "kis_below_stack_cache.h"
 
 
 #include "kis_merge_walker.h"
@@ -207,11 +208,48 @@ private:
 /*                     KisAsyncMerger                                */
 /*********************************************************************/
 
+namespace {
+
+KisBelowStackCache* belowStackCacheForLeaf(KisProjectionLeafSP leaf)
+{
+    KisProjectionLeafSP parent = leaf->parent();
+    if (!parent) return 0;
+
+    KisGroupLayer *group = dynamic_cast<KisGroupLayer*>(parent->node().data());
+    return group ? group->belowStackCache() : 0;
+}
+
+/**
+ * The below-stack cache keeps LoD0 data, so the rects of
+ * the LoD walks should be mapped back into LoD0 space
+ */
+QRect lod0CacheRect(const QRect &rc, int levelOfDetail)
+{
+    if (levelOfDetail <= 0) return rc;
+
+    return QRect(rc.x() << levelOfDetail, rc.y() << levelOfDetail,
+                 rc.width() << levelOfDetail, rc.height() << levelOfDetail);
+}
+
+}
+
 void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
     KisMergeWalker::LeafStack &leafStack = walker.leafStack();
 
     const bool useTempProjections = walker.needRectVaries();
 
+    /**
+     * The below-stack cache stores the data in the coordinates of
+     * the original of the group, so it can be used only when the
+     * merger writes directly into it.
+     */
+    const bool canUseBelowStackCache =
+        !useTempProjections && walker.levelOfDetail() == 0;
+
+    KisBelowStackCache *pendingCache = 0;
+    QVector<KisNodeSP> pendingCacheLeaves;
+    KisProjectionLeafSP pendingCacheLastLeaf;
+
     while(!leafStack.isEmpty()) {
         KisMergeWalker::JobItem item = leafStack.pop();
         KisProjectionLeafSP currentLeaf = item.m_leaf;
@@ -223,6 +261,30 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
 
         QRect applyRect = item.m_applyRect;
 
+        /**
+         * Every node that is not below the filthy one may get its
+         * projection changed, so the cached stack becomes outdated
+         */
+        if (!(item.m_position & KisMergeWalker::N_BELOW_FILTHY)) {
+            KisBelowStackCache *cache = belowStackCacheForLeaf(currentLeaf);
+            if (cache) {
+                cache->invalidate(currentLeaf->node(),
+                                  lod0CacheRect(applyRect, walker.levelOfDetail()));
+            }
+        }
+
+        if (canUseBelowStackCache &&
+            !pendingCache &&
+            !m_currentProjection &&
+            (item.m_position & KisMergeWalker::N_BELOW_FILTHY)) {
+
+            if (tryUseBelowStackCache(leafStack, item, useTempProjections,
+                                      &pendingCache, &pendingCacheLeaves,
+                                      &pendingCacheLastLeaf)) {
+                continue;
+            }
+        }
+
         if(item.m_position & KisMergeWalker::N_EXTRA) {
             // The type of layers that will not go to projection.
 
@@ -273,6 +335,15 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
 
         compositeWithProjection(currentLeaf, applyRect);
 
+        if (pendingCache && currentLeaf == pendingCacheLastLeaf) {
+            if (m_currentProjection) {
+                pendingCache->store(pendingCacheLeaves, m_currentProjection, applyRect);
+            }
+            pendingCache = 0;
+            pendingCacheLeaves.clear();
+            pendingCacheLastLeaf = 0;
+        }
+
         if(item.m_position & KisMergeWalker::N_TOPMOST) {
             writeProjection(currentLeaf, useTempProjections, applyRect);
             resetProjection();
@@ -297,6 +368,73 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
     }
 }
 
+bool KisAsyncMerger::tryUseBelowStackCache(KisMergeWalker::LeafStack &leafStack,
+                                           const KisMergeWalker::JobItem &firstItem,
+                                           bool useTempProjection,
+                                           KisBelowStackCache **pendingCache,
+                                           QVector<KisNodeSP> *pendingLeaves,
+                                           KisProjectionLeafSP *pendingLastLeaf)
+{
+    KisBelowStackCache *cache = belowStackCacheForLeaf(firstItem.m_leaf);
+    if (!cache) return false;
+
+    KisProjectionLeafSP parent = firstItem.m_leaf->parent();
+
+    /**
+     * Collect the whole run of the below-filthy siblings. The items are
+     * popped from the top of the stack, so we walk the stack backwards.
+     */
+    QVector<KisNodeSP> leaves;
+    leaves << firstItem.m_leaf->node();
+
+    KisProjectionLeafSP lastLeaf = firstItem.m_leaf;
+    QRect lastRect = firstItem.m_applyRect;
+
+    int i = leafStack.size() - 1;
+    for (; i >= 0; i--) {
+        const KisMergeWalker::JobItem &item = leafStack[i];
+
+        if (!(item.m_position & KisMergeWalker::N_BELOW_FILTHY) ||
+            item.m_leaf->parent() != parent) {
+
+            break;
+        }
+
+        leaves << item.m_leaf->node();
+        lastLeaf = item.m_leaf;
+        lastRect = item.m_applyRect;
+    }
+
+    /**
+     * The run must be followed by the filthy sibling, otherwise the
+     * stack has some unexpected structure and it is safer to do
+     * nothing.
+     */
+    if (i < 0 || leafStack[i].m_leaf->parent() != parent) {
+        return false;
+    }
+
+    setupProjection(firstItem.m_leaf, firstItem.m_applyRect, useTempProjection);
+
+    // obligeChild mechanism is active, nothing to cache
+    if (!m_currentProjection) return false;
+
+    if (cache->tryFetch(leaves, m_currentProjection, lastRect)) {
+        DEBUG_NODE_ACTION("Fetching from cache", "N_BELOW_FILTHY", firstItem.m_leaf, lastRect);
+
+        for (int j = 1; j < leaves.size(); j++) {
+            leafStack.pop();
+        }
+        return true;
+    }
+
+    *pendingCache = cache;
+    *pendingLeaves = leaves;
+    *pendingLastLeaf = lastLeaf;
+
+    return false;
+}
+
 void KisAsyncMerger::resetProjection() {
     m_currentProjection = 0;
     m_finalProjection = 0;
@@ -19,11 +19,14 @@
 #ifndef __KIS_ASYNC_MERGER_H
 #define __KIS_ASYNC_MERGER_H
 
+#include <QVector>
+
 #include "kritaimage_export.h"
 #include "kis_types.h"
+#include "kis_base_rects_walker.h"
 
 class QRect;
-class KisBaseRectsWalker;
+class KisBelowStackCache;
 
 class KRITAIMAGE_EXPORT KisAsyncMerger
 {
@@ -37,6 +40,13 @@ private:
     inline bool compositeWithProjection(KisProjectionLeafSP leaf, const QRect &rect);
     inline void doNotifyClones(KisBaseRectsWalker &walker);
 
+    bool tryUseBelowStackCache(KisBaseRectsWalker::LeafStack &leafStack,
+                               const KisBaseRectsWalker::JobItem &firstItem,
+                               bool useTempProjection,
+                               KisBelowStackCache **pendingCache,
+                               QVector<KisNodeSP> *pendingLeaves,
+                               KisProjectionLeafSP *pendingLastLeaf);
+
 private:
     /**
      * The place where intermediate results of layer's merge
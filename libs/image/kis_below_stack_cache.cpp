@@ -0,0 +1,127 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_below_stack_cache.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegion>
+
+#include "kis_node.h"
+#include "kis_paint_device.h"
+#include "kis_painter.h"
+
+
+struct KisBelowStackCache::Private
+{
+    QMutex mutex;
+
+    QVector<KisNodeWSP> leaves;
+    KisPaintDeviceSP device;
+    QRegion validRegion;
+
+    bool sameLeaves(const QVector<KisNodeSP> &rhs) const {
+        if (leaves.size() != rhs.size()) return false;
+
+        for (int i = 0; i < leaves.size(); i++) {
+            // the weak pointer returns null if the node is already dead
+            const KisNode *node = leaves[i];
+            if (!node || node != rhs[i].data()) return false;
+        }
+
+        return true;
+    }
+
+    bool compatibleDevice(KisPaintDeviceSP rhs) const {
+        return device &&
+            *device->colorSpace() == *rhs->colorSpace() &&
+            device->offset() == rhs->offset();
+    }
+};
+
+KisBelowStackCache::KisBelowStackCache()
+    : m_d(new Private)
+{
+}
+
+KisBelowStackCache::~KisBelowStackCache()
+{
+}
+
+bool KisBelowStackCache::tryFetch(const QVector<KisNodeSP> &leaves, KisPaintDeviceSP dst, const QRect &rect)
+{
+    KisPaintDeviceSP device;
+
+    {
+        QMutexLocker l(&m_d->mutex);
+
+        if (!m_d->sameLeaves(leaves) ||
+            !m_d->compatibleDevice(dst) ||
+            !QRegion(rect).subtracted(m_d->validRegion).isEmpty()) {
+
+            return false;
+        }
+
+        device = m_d->device;
+    }
+
+    // the device is never modified in the cached area, so copy without the lock
+    KisPainter::copyAreaOptimized(rect.topLeft(), device, dst, rect);
+
+    return true;
+}
+
+void KisBelowStackCache::store(const QVector<KisNodeSP> &leaves, KisPaintDeviceSP src, const QRect &rect)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    if (!m_d->sameLeaves(leaves) || !m_d->compatibleDevice(src)) {
+        m_d->leaves.clear();
+        Q_FOREACH (KisNodeSP node, leaves) {
+            m_d->leaves.append(node);
+        }
+
+        m_d->device = new KisPaintDevice(src->colorSpace());
+        m_d->device->prepareClone(src);
+        m_d->validRegion = QRegion();
+    }
+
+    KisPainter::copyAreaOptimized(rect.topLeft(), src, m_d->device, rect);
+    m_d->validRegion += rect;
+}
+
+void KisBelowStackCache::invalidate(KisNodeSP node, const QRect &rect)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    Q_FOREACH (const KisNodeWSP &leaf, m_d->leaves) {
+        const KisNode *leafNode = leaf;
+
+        if (leafNode == node.data()) {
+            m_d->validRegion -= rect;
+            break;
+        }
+    }
+}
+
+void KisBelowStackCache::clear()
+{
+    QMutexLocker l(&m_d->mutex);
+
+    m_d->leaves.clear();
+    m_d->device = 0;
+    m_d->validRegion = QRegion();
+}
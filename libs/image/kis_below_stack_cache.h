@@ -0,0 +1,84 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_BELOW_STACK_CACHE_H
+#define __KIS_BELOW_STACK_CACHE_H
+
+#include <QScopedPointer>
+#include <QVector>
+
+#include "kritaimage_export.h"
+#include "kis_types.h"
+
+class QRect;
+
+/**
+ * KisBelowStackCache stores the composition of the children of a group
+ * layer that lay below the currently filthy child. When the user paints
+ * on a layer in the middle of a big stack, KisAsyncMerger fetches the
+ * merged "below" part from the cache with a single copy operation instead
+ * of compositing every sibling one by one.
+ *
+ * The cache is bound to the exact list of the leaves it was composed
+ * from. If the list changes (a layer is added, removed, moved or hidden),
+ * the cache is rebuilt. When any of the cached leaves is recalculated by
+ * the merger, the corresponding rect is invalidated, so the validity of
+ * the cache is driven by the same dirty rects as the rest of the
+ * projection.
+ *
+ * Please note that only the "below" part of the stack is cached. The
+ * composition is not associative for arbitrary blending modes, so the
+ * layers above the filthy one still have to be composited one by one.
+ *
+ * The class is thread-safe, several merge jobs may access the cache
+ * concurrently.
+ */
+class KRITAIMAGE_EXPORT KisBelowStackCache
+{
+public:
+    KisBelowStackCache();
+    ~KisBelowStackCache();
+
+    /**
+     * Tries to copy the composition of \p leaves in \p rect into \p dst.
+     * @return true if the cached data was valid and has been copied
+     */
+    bool tryFetch(const QVector<KisNodeSP> &leaves, KisPaintDeviceSP dst, const QRect &rect);
+
+    /**
+     * Stores the contents of \p src in \p rect as the composition of \p leaves.
+     * If the leaves differ from the currently cached ones, the whole cache
+     * is reset.
+     */
+    void store(const QVector<KisNodeSP> &leaves, KisPaintDeviceSP src, const QRect &rect);
+
+    /**
+     * Notifies the cache that \p node has been recalculated in \p rect. If
+     * the node is a part of the cached stack, the area becomes invalid.
+     */
+    void invalidate(KisNodeSP node, const QRect &rect);
+
+    /**
+     * Drops all the cached data
+     */
+    void clear();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_BELOW_STACK_CACHE_H */
@@ -18,8 +18,21 @@
 
 #include "kis_brush_mask_applicator_factories.h"
 
+#include "vc_extra_math.h"
+
 #include "kis_circle_mask_generator.h"
 #include "kis_circle_mask_generator_p.h"
+#include "kis_rect_mask_generator.h"
+#include "kis_rect_mask_generator_p.h"
+#include "kis_gauss_circle_mask_generator.h"
+#include "kis_gauss_circle_mask_generator_p.h"
+#include "kis_gauss_rect_mask_generator.h"
+#include "kis_gauss_rect_mask_generator_p.h"
+#include "kis_curve_circle_mask_generator.h"
+#include "kis_curve_circle_mask_generator_p.h"
+#include "kis_curve_rect_mask_generator.h"
+#include "kis_curve_rect_mask_generator_p.h"
+
 #include "kis_brush_mask_applicators.h"
 #include "kis_brush_mask_applicator_base.h"
 
@@ -42,6 +55,46 @@ MaskApplicatorFactory<KisCircleMaskGenerator, KisBrushMaskVectorApplicator>::cre
     return new KisBrushMaskVectorApplicator<KisCircleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
 }
 
+template<>
+template<>
+MaskApplicatorFactory<KisRectangleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisRectangleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisRectangleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
+template<>
+template<>
+MaskApplicatorFactory<KisGaussCircleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisGaussCircleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisGaussCircleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
+template<>
+template<>
+MaskApplicatorFactory<KisGaussRectangleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisGaussRectangleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisGaussRectangleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
+template<>
+template<>
+MaskApplicatorFactory<KisCurveCircleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisCurveCircleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisCurveCircleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
+template<>
+template<>
+MaskApplicatorFactory<KisCurveRectangleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisCurveRectangleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisCurveRectangleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
 #if defined HAVE_VC
 
 struct KisCircleMaskGenerator::FastRowProcessor
@@ -134,4 +187,391 @@ FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, i
     }
 }
 
+struct KisRectangleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisRectangleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d.data()),
+          antialiasEdges(maskGenerator->antialiasEdges()) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisRectangleMaskGenerator::Private *d;
+    bool antialiasEdges;
+};
+
+template<> void KisRectangleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    Vc::float_v vXCoeff(d->xcoeff);
+    Vc::float_v vYCoeff(d->ycoeff);
+
+    Vc::float_v vTransformedFadeX(d->transformedFadeX);
+    Vc::float_v vTransformedFadeY(d->transformedFadeY);
+
+    Vc::float_v vOne(Vc::One);
+    Vc::float_v vZero(Vc::Zero);
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = Vc::abs(x_ * vCosa - vSinaY_);
+        Vc::float_v yr = Vc::abs(x_ * vSina + vCosaY_);
+
+        Vc::float_v nxr = xr * vXCoeff;
+        Vc::float_v nyr = yr * vYCoeff;
+
+        Vc::float_m outsideMask = (nxr > vOne) || (nyr > vOne);
+
+        if (!outsideMask.isFull()) {
+            if (antialiasEdges) {
+                xr += vOne;
+                yr += vOne;
+            }
+
+            Vc::float_v fxr = xr * vTransformedFadeX;
+            Vc::float_v fyr = yr * vTransformedFadeY;
+
+            Vc::float_m xFadeMask = (fxr > vOne) && ((fxr > fyr) || (fyr < vOne));
+            Vc::float_m yFadeMask = !xFadeMask && (fyr > vOne) && ((fyr > fxr) || (fxr < vOne));
+
+            Vc::float_v vFade(vZero);
+            vFade(yFadeMask) = nyr * (fyr - vOne) / (fyr - nyr);
+            vFade(xFadeMask) = nxr * (fxr - vOne) / (fxr - nxr);
+
+            // Mask out the outer area of the mask
+            vFade(outsideMask) = vOne;
+
+            vFade.store(bufferPointer, Vc::Aligned);
+        } else {
+            // Mask out everything outside the rectangle
+            vOne.store(bufferPointer, Vc::Aligned);
+        }
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
+struct KisGaussCircleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisGaussCircleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d.data()) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisGaussCircleMaskGenerator::Private *d;
+};
+
+template<> void KisGaussCircleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    Vc::float_v vYCoeff(d->ycoef);
+    Vc::float_v vDistfactor(d->distfactor);
+    Vc::float_v vCenter(d->center);
+    Vc::float_v vAlphafactor(d->alphafactor / 255.0);
+
+    Vc::float_v vOne(Vc::One);
+    Vc::float_v vZero(Vc::Zero);
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = x_ * vCosa - vSinaY_;
+        Vc::float_v yr = (x_ * vSina + vCosaY_) * vYCoeff;
+
+        Vc::float_v dist = Vc::sqrt(xr * xr + yr * yr);
+
+        // the fade maker writes the values of the faded lanes into 'dist'
+        Vc::float_m excludeMask = d->fadeMaker.needFade(dist);
+
+        if (!excludeMask.isFull()) {
+            Vc::float_v valDist = dist * vDistfactor;
+            Vc::float_v vFade = vOne - vAlphafactor *
+                (VcExtraMath::erf(valDist + vCenter) - VcExtraMath::erf(valDist - vCenter));
+
+            // the value must be in the range [0, 1]
+            vFade(vFade < vZero) = vZero;
+            vFade(vFade > vOne) = vOne;
+
+            dist(!excludeMask) = vFade;
+        }
+
+        dist.store(bufferPointer, Vc::Aligned);
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
+struct KisGaussRectangleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisGaussRectangleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d.data()) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisGaussRectangleMaskGenerator::Private *d;
+};
+
+template<> void KisGaussRectangleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    Vc::float_v vXFade(d->xfade);
+    Vc::float_v vYFade(d->yfade);
+    Vc::float_v vHalfWidth(d->halfWidth);
+    Vc::float_v vHalfHeight(d->halfHeight);
+    Vc::float_v vAlphafactor(d->alphafactor / 255.0);
+
+    Vc::float_v vOne(Vc::One);
+    Vc::float_v vZero(Vc::Zero);
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = x_ * vCosa - vSinaY_;
+        Vc::float_v yr = Vc::abs(x_ * vSina + vCosaY_);
+
+        if (!d->fadeMaker.outsideMask(xr, yr).isFull()) {
+            Vc::float_v vFade = vOne - vAlphafactor *
+                (VcExtraMath::erf((vHalfWidth + xr) * vXFade) + VcExtraMath::erf((vHalfWidth - xr) * vXFade)) *
+                (VcExtraMath::erf((vHalfHeight + yr) * vYFade) + VcExtraMath::erf((vHalfHeight - yr) * vYFade));
+
+            // the value must be in the range [0, 1]
+            vFade(vFade < vZero) = vZero;
+            vFade(vFade > vOne) = vOne;
+
+            d->fadeMaker.applyFade(xr, yr, vFade);
+
+            vFade.store(bufferPointer, Vc::Aligned);
+        } else {
+            // Mask out everything outside the rectangle
+            vOne.store(bufferPointer, Vc::Aligned);
+        }
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
+struct KisCurveCircleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisCurveCircleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d.data()) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisCurveCircleMaskGenerator::Private *d;
+};
+
+template<> void KisCurveCircleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    const float *curveDataPointer = d->curveDataFloat.constData();
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    Vc::float_v vXCoeff(d->xcoef);
+    Vc::float_v vYCoeff(d->ycoef);
+    Vc::float_v vCurveResolution(d->curveResolution);
+
+    Vc::float_v vOne(Vc::One);
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = (x_ * vCosa - vSinaY_) * vXCoeff;
+        Vc::float_v yr = (x_ * vSina + vCosaY_) * vYCoeff;
+
+        Vc::float_v dist = xr * xr + yr * yr;
+
+        // the fade maker writes the values of the faded lanes into 'dist'
+        Vc::float_m excludeMask = d->fadeMaker.needFade(dist);
+
+        if (!excludeMask.isFull()) {
+            // the excluded lanes may point outside the curve, so clamp them
+            Vc::float_v distance = Vc::min(dist, vOne) * vCurveResolution;
+            Vc::float_v::IndexType alphaIndex = Vc::simd_cast<Vc::float_v::IndexType>(distance);
+            Vc::float_v alphaValueF = distance - Vc::simd_cast<Vc::float_v>(alphaIndex);
+
+            Vc::float_v curveValue(curveDataPointer, alphaIndex);
+            Vc::float_v curveValueNext(curveDataPointer, alphaIndex + 1);
+
+            Vc::float_v alpha = (vOne - alphaValueF) * curveValue + alphaValueF * curveValueNext;
+
+            dist(!excludeMask) = vOne - alpha;
+        }
+
+        dist.store(bufferPointer, Vc::Aligned);
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
+struct KisCurveRectangleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisCurveRectangleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisCurveRectangleMaskGenerator::Private *d;
+};
+
+template<> void KisCurveRectangleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    const float *curveDataPointer = d->curveDataFloat.constData();
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    Vc::float_v vXCoeff(d->xcoeff);
+    Vc::float_v vYCoeff(d->ycoeff);
+    Vc::float_v vCurveResolution(d->curveResolution);
+
+    Vc::float_v vOne(Vc::One);
+
+    const Vc::float_v::IndexType vCurveResolutionIndex =
+        Vc::simd_cast<Vc::float_v::IndexType>(vCurveResolution);
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = x_ * vCosa - vSinaY_;
+        Vc::float_v yr = x_ * vSina + vCosaY_;
+
+        if (!d->fadeMaker.outsideMask(xr, yr).isFull()) {
+            // the lanes outside the limits may point outside the curve, so clamp them
+            Vc::float_v nxr = Vc::min(Vc::abs(xr) * vXCoeff, vOne);
+            Vc::float_v nyr = Vc::min(Vc::abs(yr) * vYCoeff, vOne);
+
+            Vc::float_v::IndexType sIndex =
+                Vc::simd_cast<Vc::float_v::IndexType>(Vc::round(nxr * vCurveResolution));
+            Vc::float_v::IndexType tIndex =
+                Vc::simd_cast<Vc::float_v::IndexType>(Vc::round(nyr * vCurveResolution));
+
+            Vc::float_v::IndexType sIndexInverted = vCurveResolutionIndex - sIndex;
+            Vc::float_v::IndexType tIndexInverted = vCurveResolutionIndex - tIndex;
+
+            Vc::float_v blend =
+                Vc::float_v(curveDataPointer, sIndex) *
+                (vOne - Vc::float_v(curveDataPointer, sIndexInverted)) *
+                Vc::float_v(curveDataPointer, tIndex) *
+                (vOne - Vc::float_v(curveDataPointer, tIndexInverted));
+
+            Vc::float_v vFade = vOne - blend;
+            d->fadeMaker.applyFade(xr, yr, vFade);
+
+            vFade.store(bufferPointer, Vc::Aligned);
+        } else {
+            // Mask out everything outside the rectangle
+            vOne.store(bufferPointer, Vc::Aligned);
+        }
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
 #endif /* defined HAVE_VC */
@@ -83,6 +83,68 @@ const Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic>* KisConvolutionKernel
     return &(d->data);
 }
 
+bool KisConvolutionKernel::separate(QVector<qreal> *rowWeights, QVector<qreal> *columnWeights) const
+{
+    const int w = width();
+    const int h = height();
+
+    if (!w || !h) return false;
+
+    if (w == 1) {
+        // keep the weights intact, so that the result is bit-exact
+        *rowWeights = QVector<qreal>(1, 1.0);
+        columnWeights->resize(h);
+
+        for (int r = 0; r < h; r++) {
+            (*columnWeights)[r] = d->data(r, 0);
+        }
+
+        return true;
+    }
+
+    int pivotRow = 0;
+    int pivotColumn = 0;
+    qreal maxValue = 0.0;
+
+    for (int r = 0; r < h; r++) {
+        for (int c = 0; c < w; c++) {
+            const qreal value = qAbs(d->data(r, c));
+            if (value > maxValue) {
+                maxValue = value;
+                pivotRow = r;
+                pivotColumn = c;
+            }
+        }
+    }
+
+    if (maxValue == 0.0) return false;
+
+    const qreal pivot = d->data(pivotRow, pivotColumn);
+
+    rowWeights->resize(w);
+    columnWeights->resize(h);
+
+    for (int c = 0; c < w; c++) {
+        (*rowWeights)[c] = d->data(pivotRow, c);
+    }
+
+    for (int r = 0; r < h; r++) {
+        (*columnWeights)[r] = r == pivotRow ? 1.0 : d->data(r, pivotColumn) / pivot;
+    }
+
+    const qreal tolerance = 1e-6 * maxValue;
+
+    for (int r = 0; r < h; r++) {
+        for (int c = 0; c < w; c++) {
+            if (qAbs(d->data(r, c) - (*columnWeights)[r] * (*rowWeights)[c]) > tolerance) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
 KisConvolutionKernelSP KisConvolutionKernel::fromQImage(const QImage& image)
 {
     KisConvolutionKernelSP kernel = new KisConvolutionKernel(image.width(), image.height(), 0, 0);
@@ -20,6 +20,7 @@
 #define _KIS_CONVOLUTION_KERNEL_H_
 
 #include <cstddef>
+#include <QVector>
 #include <Eigen/Core>
 #include "kis_shared.h"
 #include "kritaimage_export.h"
@@ -47,6 +48,14 @@ public:
     Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic>& data();
     const Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> * data() const;
 
+    /**
+     * Checks whether the kernel is a product of a column vector and
+     * a row vector, that is, whether it can be applied as a horizontal
+     * pass followed by a vertical one. On success \p rowWeights gets
+     * width() elements and \p columnWeights gets height() elements.
+     */
+    bool separate(QVector<qreal> *rowWeights, QVector<qreal> *columnWeights) const;
+
     static KisConvolutionKernelSP fromQImage(const QImage& image);
     static KisConvolutionKernelSP fromMaskGenerator(KisMaskGenerator *, qreal angle = 0.0);
     static KisConvolutionKernelSP fromMatrix(Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix, qreal offset, qreal factor);
@@ -20,6 +20,9 @@
 #ifndef KIS_CONVOLUTION_WORKER_SPATIAL_H
 #define KIS_CONVOLUTION_WORKER_SPATIAL_H
 
+#include <algorithm>
+#include <QVector>
+
 #include "kis_convolution_worker.h"
 #include "kis_math_toolbox.h"
 
@@ -58,6 +61,20 @@ public:
 
     }
 
+    inline void loadPixelToPlanes(qreal *planes, int planeStride, const quint8 *data, int index) {
+        qreal alphaValue = m_alphaRealPos >= 0 ?
+            m_toDoubleFuncPtr[m_alphaCachePos](data, m_alphaRealPos) : 1.0;
+
+        for (quint32 k = 0; k < m_convolveChannelsNo; ++k) {
+            if (k != (quint32)m_alphaCachePos) {
+                const quint32 channelPos = m_convChannelList[k]->pos();
+                planes[k * planeStride + index] = m_toDoubleFuncPtr[k](data, channelPos) * alphaValue;
+            } else {
+                planes[k * planeStride + index] = alphaValue;
+            }
+        }
+    }
+
     void execute(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect) override {
         // store some kernel characteristics
         m_kw = kernel->width();
@@ -142,6 +159,15 @@ public:
             m_absoluteOffset[i] = (m_maxClamp[i] - m_minClamp[i]) * kernel->offset();
         }
 
+        QVector<qreal> rowWeights;
+        QVector<qreal> columnWeights;
+
+        if (m_cacheSize > 1 && kernel->separate(&rowWeights, &columnWeights)) {
+            executeSeparable(rowWeights, columnWeights, src, srcPos, dstPos, areaSize, dataRect);
+            cleanUp();
+            return;
+        }
+
         qint32 row = srcPos.y();
         qint32 col = srcPos.x();
 
@@ -250,6 +276,111 @@ public:
         cleanUp();
     }
 
+    /**
+     * The kernel is applied as a horizontal pass followed by a vertical
+     * one, that is, with kw + kh multiplications per channel instead
+     * of kw * kh. The pixels are converted into planar rows of doubles
+     * only once; the passes run over contiguous arrays with the weight
+     * in the outer loop, so the compiler can vectorize them. The last
+     * kh rows of the horizontal pass are kept in a ring buffer.
+     *
+     * The accumulation order matches convolveCache(), so the result of
+     * the one-dimensional kernels is exactly the same.
+     */
+    void executeSeparable(const QVector<qreal> &rowWeights, const QVector<qreal> &columnWeights,
+                          const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize,
+                          const QRect& dataRect) {
+
+        const int width = areaSize.width();
+        const int height = areaSize.height();
+        const int inputWidth = width + m_kw - 1;
+        const int numChannels = m_convolveChannelsNo;
+
+        QVector<qreal> inputRow(numChannels * inputWidth);
+        QVector<qreal> ringBuffer(m_kh * numChannels * width);
+        QVector<qreal> outputRow(numChannels * width);
+
+        const qreal *rowWeightsPtr = rowWeights.constData();
+        const qreal *columnWeightsPtr = columnWeights.constData();
+
+        bool hasProgressUpdater = this->m_progress;
+        if (hasProgressUpdater) {
+            this->m_progress->setRange(0, height);
+        }
+
+        typename _IteratorFactory_::HLineConstIterator inputIt = _IteratorFactory_::createHLineConstIterator(src, srcPos.x() - m_khalfWidth, srcPos.y() - m_khalfHeight, inputWidth, dataRect);
+        typename _IteratorFactory_::HLineIterator hitDst = _IteratorFactory_::createHLineIterator(this->m_painter->device(), dstPos.x(), dstPos.y(), width, dataRect);
+        typename _IteratorFactory_::HLineConstIterator hitSrc = _IteratorFactory_::createHLineConstIterator(src, srcPos.x(), srcPos.y(), width, dataRect);
+
+        for (int inputRowIndex = 0; inputRowIndex < height + int(m_kh) - 1; inputRowIndex++) {
+            // horizontal pass
+            int x = 0;
+            do {
+                loadPixelToPlanes(inputRow.data(), inputWidth, inputIt->oldRawData(), x);
+                x++;
+            } while (inputIt->nextPixel());
+            inputIt->nextRow();
+
+            qreal *hRow = ringBuffer.data() + (inputRowIndex % m_kh) * numChannels * width;
+
+            for (int k = 0; k < numChannels; k++) {
+                const qreal *srcPlane = inputRow.constData() + k * inputWidth;
+                qreal *dstPlane = hRow + k * width;
+
+                std::fill(dstPlane, dstPlane + width, 0.0);
+
+                for (quint32 kcol = 0; kcol < m_kw; kcol++) {
+                    const qreal weight = rowWeightsPtr[m_kw - kcol - 1];
+                    const qreal *srcPtr = srcPlane + kcol;
+
+                    for (int i = 0; i < width; i++) {
+                        dstPlane[i] += weight * srcPtr[i];
+                    }
+                }
+            }
+
+            const int row = inputRowIndex - int(m_kh) + 1;
+            if (row < 0) continue;
+
+            // vertical pass
+            for (int k = 0; k < numChannels; k++) {
+                qreal *dstPlane = outputRow.data() + k * width;
+
+                std::fill(dstPlane, dstPlane + width, 0.0);
+
+                for (quint32 krow = 0; krow < m_kh; krow++) {
+                    const qreal weight = columnWeightsPtr[m_kh - krow - 1];
+                    const qreal *srcPlane =
+                        ringBuffer.constData() + ((row + krow) % m_kh) * numChannels * width + k * width;
+
+                    for (int i = 0; i < width; i++) {
+                        dstPlane[i] += weight * srcPlane[i];
+                    }
+                }
+            }
+
+            x = 0;
+            do {
+                // write original channel values
+                memcpy(hitDst->rawData(), hitSrc->oldRawData(), m_pixelSize);
+                writeConvolvedPixel(hitDst->rawData(), outputRow.constData() + x, width);
+                hitSrc->nextPixel();
+                x++;
+            } while (hitDst->nextPixel());
+
+            hitDst->nextRow();
+            hitSrc->nextRow();
+
+            if (hasProgressUpdater) {
+                this->m_progress->setValue(row);
+
+                if (this->m_progress->interrupted()) {
+                    return;
+                }
+            }
+        }
+    }
+
     inline void limitValue(qreal *value, qreal lowBound, qreal highBound) {
         if (*value > highBound) {
             *value = highBound;
@@ -268,6 +399,11 @@ public:
             interimConvoResult += m_kernelData[m_cacheSize - pIndex - 1] * cacheValue;
         }
 
+        return storeChannelValue<additionalMultiplierActive>(dstPtr, channel, interimConvoResult, additionalMultiplier);
+    }
+
+    template <bool additionalMultiplierActive>
+    inline qreal storeChannelValue(quint8* dstPtr, quint32 channel, qreal interimConvoResult, qreal additionalMultiplier) {
         qreal channelPixelValue;
         if (additionalMultiplierActive) {
             channelPixelValue = (interimConvoResult * m_kernelFactor) * additionalMultiplier + m_absoluteOffset[channel];
@@ -315,6 +451,38 @@ public:
         }
     }
 
+    /**
+     * The same as convolveCache(), but the sums are already calculated,
+     * \p values points to the value of the first channel, the values
+     * of the other channels follow with \p channelStride
+     */
+    inline void writeConvolvedPixel(quint8* dstPtr, const qreal *values, int channelStride) {
+        if (m_alphaCachePos >= 0) {
+            qreal alphaValue = storeChannelValue<false>(dstPtr, m_alphaCachePos, values[m_alphaCachePos * channelStride], 0.0);
+
+            if (alphaValue != 0.0) {
+                qreal alphaValueInv = 1.0 / alphaValue;
+
+                for (quint32 k = 0; k < m_convolveChannelsNo; ++k) {
+                    if (k == (quint32)m_alphaCachePos) continue;
+                    storeChannelValue<true>(dstPtr, k, values[k * channelStride], alphaValueInv);
+                }
+            } else {
+                for (quint32 k = 0; k < m_convolveChannelsNo; ++k) {
+                    if (k == (quint32)m_alphaCachePos) continue;
+
+                    const qreal zeroValue = 0.0;
+                    const quint32 channelPos = m_convChannelList[k]->pos();
+                    m_fromDoubleFuncPtr[k](dstPtr, channelPos, zeroValue);
+                }
+            }
+        } else {
+            for (quint32 k = 0; k < m_convolveChannelsNo; ++k) {
+                storeChannelValue<false>(dstPtr, k, values[k * channelStride], 0.0);
+            }
+        }
+    }
+
     inline void moveKernelRight(typename _IteratorFactory_::VLineConstIterator& kitSrc, qreal **pixelPtrCache) {
         qreal** d = pixelPtrCache;
 
@@ -38,7 +38,8 @@ class QPointF;
  */
 class KRITAIMAGE_EXPORT KisCurveCircleMaskGenerator : public KisMaskGenerator
 {
-
+public:
+    struct FastRowProcessor;
 public:
 
     KisCurveCircleMaskGenerator(qreal radius, qreal ratio, qreal fh, qreal fv, int spikes,const KisCubicCurve& curve, bool antialiasEdges);
@@ -50,6 +51,9 @@ public:
 
     void setScale(qreal scaleX, qreal scaleY) override;
 
+    bool shouldVectorize() const override;
+    KisBrushMaskApplicatorBase* applicator() override;
+
     bool shouldSupersample() const override;
 
     void toXML(QDomDocument& , QDomElement&) const override;
@@ -92,6 +92,14 @@ public:
      */
     bool initialize(quint8 defaultValue = 0);
 
+    /**
+     * Makes sure the internal buffer is big enough to hold bounds()
+     * pixels, but does not initialize its contents. The buffer is never
+     * shrunk, so a device reused for dabs of varying size is reallocated
+     * only when the dab grows.
+     */
+    void lazyGrowBufferWithoutInitialization();
+
     /**
      * @return a pointer to the beginning of the data associated with this fixed paint device.
      */
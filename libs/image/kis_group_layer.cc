@@ -37,6 +37,8 @@
 #include "kis_selection_mask.h"
 #include "kis_psd_layer_style.h"
 #include "kis_layer_properties_icons.h"
+#include "kis_below_stack_cache.h"
+#include "kis_image_config.h"
 
 
 struct Q_DECL_HIDDEN KisGroupLayer::Private
@@ -47,6 +49,7 @@ public:
         , x(0)
         , y(0)
         , passThroughMode(false)
+        , belowStackCacheEnabled(KisImageConfig(true).enableBelowStackCache())
     {
     }
 
@@ -54,6 +57,9 @@ public:
     qint32 x;
     qint32 y;
     bool passThroughMode;
+
+    bool belowStackCacheEnabled;
+    KisBelowStackCache belowStackCache;
 };
 
 KisGroupLayer::KisGroupLayer(KisImageWSP image, const QString &name, quint8 opacity) :
@@ -73,6 +79,7 @@ KisGroupLayer::KisGroupLayer(const KisGroupLayer &rhs) :
     m_d->paintDevice->setDefaultPixel(const_cast<KisGroupLayer*>(&rhs)->m_d->paintDevice->defaultPixel());
     m_d->paintDevice->setProjectionDevice(true);
     m_d->passThroughMode = rhs.passThroughMode();
+    m_d->belowStackCacheEnabled = rhs.m_d->belowStackCacheEnabled;
 }
 
 KisGroupLayer::~KisGroupLayer()
@@ -201,6 +208,8 @@ void KisGroupLayer::resetCache(const KoColorSpace *colorSpace)
 
         m_d->paintDevice->clear();
     }
+
+    m_d->belowStackCache.clear();
 }
 
 KisLayer* KisGroupLayer::onlyMeaningfulChild() const
@@ -291,6 +300,25 @@ bool KisGroupLayer::passThroughMode() const
     return m_d->passThroughMode;
 }
 
+KisBelowStackCache* KisGroupLayer::belowStackCache() const
+{
+    return m_d->belowStackCacheEnabled ? &m_d->belowStackCache : 0;
+}
+
+void KisGroupLayer::setBelowStackCacheEnabled(bool value)
+{
+    m_d->belowStackCacheEnabled = value;
+
+    if (!value) {
+        m_d->belowStackCache.clear();
+    }
+}
+
+bool KisGroupLayer::belowStackCacheEnabled() const
+{
+    return m_d->belowStackCacheEnabled;
+}
+
 void KisGroupLayer::setPassThroughMode(bool value)
 {
     if (m_d->passThroughMode == value) return;
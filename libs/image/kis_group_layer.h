@@ -23,6 +23,7 @@
 #include "kis_types.h"
 
 class KoColorSpace;
+class KisBelowStackCache;
 
 /**
  * A KisLayer that bundles child layers into a single layer.
@@ -107,6 +108,24 @@ public:
 
     bool projectionIsValid() const;
 
+    /**
+     * The cache of the composition of the children lying below the
+     * currently updated child. It is used by KisAsyncMerger to avoid
+     * recompositing the unchanged part of the stack on every update.
+     *
+     * @return the cache or null if caching is disabled for this group
+     */
+    KisBelowStackCache* belowStackCache() const;
+
+    /**
+     * Enables or disables the below-stack cache for the group. The
+     * default value is taken from KisImageConfig::enableBelowStackCache(),
+     * which is off by default, because the cache keeps an additional
+     * full-size device for every group.
+     */
+    void setBelowStackCacheEnabled(bool value);
+    bool belowStackCacheEnabled() const;
+
 protected:
     KisLayer* onlyMeaningfulChild() const;
     KisPaintDeviceSP tryObligeChild() const;
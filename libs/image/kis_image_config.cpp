@@ -86,6 +86,17 @@ void KisImageConfig::setEnablePerfLog(bool value)
     m_config.writeEntry("enablePerfLog", value);
 }
 
+bool KisImageConfig::enableBelowStackCache(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("enableBelowStackCache", false) : false;
+}
+
+void KisImageConfig::setEnableBelowStackCache(bool value)
+{
+    m_config.writeEntry("enableBelowStackCache", value);
+}
+
 qreal KisImageConfig::transformMaskOffBoundsReadArea() const
 {
     return m_config.readEntry("transformMaskOffBoundsReadArea", 0.5);
@@ -150,6 +161,23 @@ void KisImageConfig::setMaxSwapSize(int value)
     m_config.writeEntry("maxSwapSize", value);
 }
 
+int KisImageConfig::undoMemoryLimit(bool requestDefault) const
+{
+    /**
+     * By default the history is allowed to take a half of the swap
+     * file, the rest is left for the image data
+     */
+    const int defaultLimit = maxSwapSize(true) / 2;
+
+    return !requestDefault ?
+        m_config.readEntry("undoMemoryLimit", defaultLimit) : defaultLimit; // in MiB
+}
+
+void KisImageConfig::setUndoMemoryLimit(int value)
+{
+    m_config.writeEntry("undoMemoryLimit", value);
+}
+
 int KisImageConfig::swapSlabSize() const
 {
     return m_config.readEntry("swapSlabSize", 64); // in MiB
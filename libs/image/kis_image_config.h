@@ -36,6 +36,9 @@ public:
     bool enablePerfLog(bool requestDefault = false) const;
     void setEnablePerfLog(bool value);
 
+    bool enableBelowStackCache(bool requestDefault = false) const;
+    void setEnableBelowStackCache(bool value);
+
     qreal transformMaskOffBoundsReadArea() const;
 
     int updatePatchHeight() const;
@@ -52,6 +55,14 @@ public:
     int maxSwapSize(bool requestDefault = false) const;
     void setMaxSwapSize(int value);
 
+    /**
+     * The limit for the size of the undo data of all the open images
+     * (both in memory and in the swap file). When it is exceeded, the
+     * oldest undo steps are removed. Zero means no limit.
+     */
+    int undoMemoryLimit(bool requestDefault = false) const; // MiB
+    void setUndoMemoryLimit(int value);
+
     int swapSlabSize() const;
     void setSwapSlabSize(int value);
 
@@ -156,6 +156,7 @@ KisMemoryStatisticsServer::fetchMemoryStatistics(KisImageSP image) const
     stats.poolSize = tileStats.poolSize;
 
     stats.swapSize = tileStats.swapSize;
+    stats.statisticsRevision = tileStats.statisticsRevision;
 
     KisImageConfig cfg;
 
@@ -163,6 +164,7 @@ KisMemoryStatisticsServer::fetchMemoryStatistics(KisImageSP image) const
     stats.tilesSoftLimit = cfg.tilesSoftLimit() * MiB;
     stats.tilesPoolLimit = cfg.poolLimit() * MiB;
     stats.totalMemoryLimit = stats.tilesHardLimit + stats.tilesPoolLimit;
+    stats.historicalMemoryLimit = cfg.undoMemoryLimit() * MiB;
 
     return stats;
 }
@@ -172,4 +174,10 @@ void KisMemoryStatisticsServer::notifyImageChanged()
     m_d->updateCompressor.start();
 }
 
+void KisMemoryStatisticsServer::notifyHistoryChanged()
+{
+    KisTileDataStore::instance()->kickPooler();
+    m_d->updateCompressor.start();
+}
+
 
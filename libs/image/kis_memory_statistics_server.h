@@ -49,7 +49,10 @@ public:
               totalMemoryLimit(0),
               tilesHardLimit(0),
               tilesSoftLimit(0),
-              tilesPoolLimit(0)
+              tilesPoolLimit(0),
+              historicalMemoryLimit(0),
+
+              statisticsRevision(0)
         {
         }
 
@@ -69,6 +72,10 @@ public:
         qint64 tilesHardLimit;
         qint64 tilesSoftLimit;
         qint64 tilesPoolLimit;
+        qint64 historicalMemoryLimit;
+
+        /// changes every time the tile statistics are gathered
+        int statisticsRevision;
     };
 
 
@@ -83,6 +90,13 @@ public:
 public Q_SLOTS:
     void notifyImageChanged();
 
+    /**
+     * Wakes up the pooler to gather fresh tile statistics, e.g. after
+     * some undo commands have been removed, and emits
+     * sigUpdateMemoryStatistics() after a delay
+     */
+    void notifyHistoryChanged();
+
 Q_SIGNALS:
     void sigUpdateMemoryStatistics();
 
@@ -53,6 +53,7 @@
 #include "tiles3/kis_hline_iterator.h"
 #include "tiles3/kis_vline_iterator.h"
 #include "tiles3/kis_random_accessor.h"
+#include "tiles3/kis_tile_data_deduplicator.h"
 
 #include "kis_default_bounds.h"
 
@@ -379,6 +380,20 @@ public:
         return data->dataManager()->write(store);
     }
 
+    void deduplicateFrames()
+    {
+        if (m_frames.size() < 2) return;
+
+        KisTileDataDeduplicator deduplicator(m_frames.begin().value()->dataManager()->pixelSize());
+
+        QList<int> ids = m_frames.keys();
+        std::sort(ids.begin(), ids.end());
+
+        Q_FOREACH (int frameId, ids) {
+            m_frames[frameId]->dataManager()->deduplicateTiles(&deduplicator);
+        }
+    }
+
     void setFrameDefaultPixel(const KoColor &defPixel, int frameId)
     {
         DataSP data = m_frames[frameId];
@@ -1091,6 +1106,28 @@ int KisPaintDevice::sequenceNumber() const
     return m_d->cache()->sequenceNumber();
 }
 
+qint64 KisPaintDevice::revision() const
+{
+    return m_d->dataManager()->revision();
+}
+
+bool KisPaintDevice::changedRects(qint64 revision, QVector<QRect> *rects) const
+{
+    const int startIndex = rects->size();
+
+    if (!m_d->dataManager()->changedTileRects(revision, rects)) {
+        return false;
+    }
+
+    const QPoint offset(x(), y());
+
+    for (int i = startIndex; i < rects->size(); i++) {
+        (*rects)[i].translate(offset);
+    }
+
+    return true;
+}
+
 void KisPaintDevice::estimateMemoryStats(qint64 &imageData, qint64 &temporaryData, qint64 &lodData) const
 {
     m_d->estimateMemoryStats(imageData, temporaryData, lodData);
@@ -2100,6 +2137,11 @@ bool KisPaintDeviceFramesInterface::readFrame(QIODevice *stream, int frameId)
     return q->m_d->readFrame(stream, frameId);
 }
 
+void KisPaintDeviceFramesInterface::deduplicateFrames()
+{
+    q->m_d->deduplicateFrames();
+}
+
 int KisPaintDeviceFramesInterface::currentFrameId() const
 {
     return q->m_d->currentFrameId();
@@ -761,6 +761,35 @@ public:
      */
     int sequenceNumber() const;
 
+    /**
+     * \return the revision of the pixel data of the device. In contrast
+     *         to sequenceNumber(), the revision allows fetching the
+     *         areas changed since then with changedRects()
+     *
+     * NOTE: every frame of an animated device has its own data
+     *       manager, so the revision and changedRects() refer to the
+     *       current frame only
+     *
+     * \see KisTiledDataManager::revision()
+     */
+    qint64 revision() const;
+
+    /**
+     * Adds the rects (in device coordinates) of the tiles changed after
+     * \p revision into \p rects.
+     *
+     * NOTE: moving the device doesn't change its tiles, so the move
+     *       is not reported, the rects are just translated by the
+     *       current offset. The consumers that keep the positions of
+     *       the tiles should track x() and y() themselves.
+     *
+     * \return false if the changes cannot be tracked back to \p revision,
+     *         then the whole device should be considered changed
+     *
+     * \see KisTiledDataManager::changedTileRects()
+     */
+    bool changedRects(qint64 revision, QVector<QRect> *rects) const;
+
 
     void estimateMemoryStats(qint64 &imageData, qint64 &temporaryData, qint64 &lodData) const;
 
@@ -20,6 +20,8 @@
 #define __KIS_PAINT_DEVICE_CACHE_H
 
 #include "kis_lock_free_cache.h"
+#include "kis_paint_device_thumbnail_cache.h"
+#include "kis_paint_device_tile_bounds_cache.h"
 #include <QElapsedTimer>
 
 
@@ -28,23 +30,34 @@ class KisPaintDeviceCache
 public:
     KisPaintDeviceCache(KisPaintDevice *paintDevice)
         : m_paintDevice(paintDevice),
-          m_exactBoundsCache(paintDevice),
-          m_nonDefaultPixelAreaCache(paintDevice),
+          m_tileBoundsCache(paintDevice),
+          m_exactBoundsCache(paintDevice, &m_tileBoundsCache),
+          m_nonDefaultPixelAreaCache(paintDevice, &m_tileBoundsCache),
           m_regionCache(paintDevice),
+          m_thumbnailCache(paintDevice),
           m_sequenceNumber(0)
     {
     }
 
     KisPaintDeviceCache(const KisPaintDeviceCache &rhs)
         : m_paintDevice(rhs.m_paintDevice),
-          m_exactBoundsCache(rhs.m_paintDevice),
-          m_nonDefaultPixelAreaCache(rhs.m_paintDevice),
+          m_tileBoundsCache(rhs.m_paintDevice),
+          m_exactBoundsCache(rhs.m_paintDevice, &m_tileBoundsCache),
+          m_nonDefaultPixelAreaCache(rhs.m_paintDevice, &m_tileBoundsCache),
           m_regionCache(rhs.m_paintDevice),
+          m_thumbnailCache(rhs.m_paintDevice),
           m_sequenceNumber(0)
     {
     }
 
     void setupCache() {
+        /**
+         * The data manager may have been replaced with another one,
+         * e.g. by undoing a color space conversion, so the tiles
+         * cached for the old one are meaningless now
+         */
+        m_tileBoundsCache.clear();
+        m_thumbnailCache.clear();
         invalidate();
     }
 
@@ -101,7 +114,17 @@ public:
         }
 
         if (thumbnail.isNull()) {
-            thumbnail = m_paintDevice->createThumbnail(w, h, QRect(), oversample, renderingIntent, conversionFlags);
+            /**
+             * The tile cache updates only the tiles changed since
+             * the previous request, so it is much cheaper than
+             * downsampling the whole device
+             */
+            thumbnail = m_thumbnailCache.createThumbnail(w, h, renderingIntent, conversionFlags);
+
+            if (thumbnail.isNull()) {
+                thumbnail = m_paintDevice->createThumbnail(w, h, QRect(), oversample, renderingIntent, conversionFlags);
+            }
+
             cacheThumbnail(w, h, oversample, thumbnail);
         }
 
@@ -129,23 +152,39 @@ private:
     KisPaintDevice *m_paintDevice;
 
     struct ExactBoundsCache : KisLockFreeCache<QRect> {
-        ExactBoundsCache(KisPaintDevice *paintDevice) : m_paintDevice(paintDevice) {}
+        ExactBoundsCache(KisPaintDevice *paintDevice, KisPaintDeviceTileBoundsCache *tileBoundsCache)
+            : m_paintDevice(paintDevice), m_tileBoundsCache(tileBoundsCache) {}
 
         QRect calculateNewValue() const override {
-            return m_paintDevice->calculateExactBounds(false);
+            QRect bounds;
+
+            if (!m_tileBoundsCache->exactBounds(&bounds)) {
+                bounds = m_paintDevice->calculateExactBounds(false);
+            }
+
+            return bounds;
         }
     private:
         KisPaintDevice *m_paintDevice;
+        KisPaintDeviceTileBoundsCache *m_tileBoundsCache;
     };
 
     struct NonDefaultPixelCache : KisLockFreeCache<QRect> {
-        NonDefaultPixelCache(KisPaintDevice *paintDevice) : m_paintDevice(paintDevice) {}
+        NonDefaultPixelCache(KisPaintDevice *paintDevice, KisPaintDeviceTileBoundsCache *tileBoundsCache)
+            : m_paintDevice(paintDevice), m_tileBoundsCache(tileBoundsCache) {}
 
         QRect calculateNewValue() const override {
-            return m_paintDevice->calculateExactBounds(true);
+            QRect bounds;
+
+            if (!m_tileBoundsCache->nonDefaultPixelArea(&bounds)) {
+                bounds = m_paintDevice->calculateExactBounds(true);
+            }
+
+            return bounds;
         }
     private:
         KisPaintDevice *m_paintDevice;
+        KisPaintDeviceTileBoundsCache *m_tileBoundsCache;
     };
 
     struct RegionCache : KisLockFreeCache<QRegion> {
@@ -158,9 +197,16 @@ private:
         KisPaintDevice *m_paintDevice;
     };
 
+    /**
+     * Keeps the bounds of every tile, so the exact bounds are
+     * recalculated only for the tiles changed since the last
+     * request. Should be declared before the caches using it.
+     */
+    KisPaintDeviceTileBoundsCache m_tileBoundsCache;
     ExactBoundsCache m_exactBoundsCache;
     NonDefaultPixelCache m_nonDefaultPixelAreaCache;
     RegionCache m_regionCache;
+    KisPaintDeviceThumbnailCache m_thumbnailCache;
 
     bool m_thumbnailsValid;
     QMap<int, QMap<int, QMap<qreal,QImage> > > m_thumbnails;
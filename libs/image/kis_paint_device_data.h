@@ -19,8 +19,16 @@
 #ifndef __KIS_PAINT_DEVICE_DATA_H
 #define __KIS_PAINT_DEVICE_DATA_H
 
+#include <functional>
+
+#include <QRunnable>
+#include <QThreadPool>
+
 #include "KoAlwaysInline.h"
+#include "KoColorConversionTransformation.h"
 #include "kundo2command.h"
+#include "krita_utils.h"
+#include "kis_image_config.h"
 
 
 struct DirectDataAccessPolicy {
@@ -158,25 +166,81 @@ public:
 
 
         if (!rc.isEmpty()) {
-            InternalSequentialConstIterator srcIt(DirectDataAccessPolicy(m_dataManager.data(), cacheInvalidator()), rc);
-            InternalSequentialIterator dstIt(DirectDataAccessPolicy(dstDataManager.data(), cacheInvalidator()), rc);
-
-            int nConseqPixels = 0;
+            /**
+             * Only the existing tiles are converted, so the holes inside
+             * the bounding rect do not allocate any memory in the new
+             * data manager. Big devices are distributed between a few
+             * jobs running in parallel. convertPixelsTo() takes the
+             * converters from KoColorConversionCache, so the jobs can
+             * share them safely.
+             */
+            QVector<QRect> tileRects;
+            Q_FOREACH (const QRect &rect, m_dataManager->region().rects()) {
+                tileRects += KritaUtils::splitRectIntoPatches(rect, QSize(64, 64));
+            }
 
-            do {
-                nConseqPixels = srcIt.nConseqPixels();
+            // the conversion of a few tiles is cheaper than starting a thread
+            const int minTilesPerJob = 64;
 
-                const quint8 *srcData = srcIt.rawDataConst();
-                quint8 *dstData = dstIt.rawData();
+            int numJobs = 1;
+            if (tileRects.size() >= 2 * minTilesPerJob) {
+                numJobs = qBound(1, KisImageConfig(true).maxNumberOfThreads(),
+                                 tileRects.size() / minTilesPerJob);
+            }
 
-                m_colorSpace->convertPixelsTo(srcData, dstData,
-                                              dstColorSpace,
-                                              nConseqPixels,
-                                              renderingIntent, conversionFlags);
+            QVector<QVector<QRect>> jobs(numJobs);
+            for (int i = 0; i < tileRects.size(); i++) {
+                jobs[i % numJobs].append(tileRects[i]);
+            }
 
+            KisDataManager *srcDataManager = m_dataManager.data();
+            const KoColorSpace *srcColorSpace = m_colorSpace;
+
+            /**
+             * KisPaintDeviceCache::invalidate() is not thread-safe, so the
+             * iterators of the jobs get no completion listener, and the
+             * cache is invalidated once all the jobs are done
+             */
+            auto convertTiles =
+                [srcDataManager, dstDataManager,
+                 srcColorSpace, dstColorSpace, renderingIntent, conversionFlags] (const QVector<QRect> &rects) {
+
+                Q_FOREACH (const QRect &rect, rects) {
+                    InternalSequentialConstIterator srcIt(DirectDataAccessPolicy(srcDataManager, 0), rect);
+                    InternalSequentialIterator dstIt(DirectDataAccessPolicy(dstDataManager.data(), 0), rect);
+
+                    int nConseqPixels = 0;
+
+                    do {
+                        nConseqPixels = srcIt.nConseqPixels();
+                        srcColorSpace->convertPixelsTo(srcIt.rawDataConst(), dstIt.rawData(), dstColorSpace, nConseqPixels, renderingIntent, conversionFlags);
+                    } while(srcIt.nextPixels(nConseqPixels) &&
+                            dstIt.nextPixels(nConseqPixels));
+                }
+            };
+
+            if (numJobs > 1) {
+                /**
+                 * The conversion can be requested from a stroke job, that
+                 * is from a thread of a pool itself, so the jobs are run
+                 * in a private pool instead of the global one. The current
+                 * thread takes the first job.
+                 */
+                QThreadPool pool;
+                pool.setMaxThreadCount(numJobs - 1);
+
+                for (int i = 1; i < numJobs; i++) {
+                    const QVector<QRect> &rects = jobs[i];
+                    pool.start(new ConvertTilesJob([convertTiles, &rects] () { convertTiles(rects); }));
+                }
+
+                convertTiles(jobs.first());
+                pool.waitForDone();
+            } else {
+                convertTiles(jobs.first());
+            }
 
-            } while(srcIt.nextPixels(nConseqPixels) &&
-                    dstIt.nextPixels(nConseqPixels));
+            m_cache.invalidate();
         }
 
         // becomes owned by the parent
@@ -269,6 +333,16 @@ private:
         KisPaintDeviceData *q;
     };
 
+    struct ConvertTilesJob : public QRunnable {
+        ConvertTilesJob(std::function<void()> func) : m_func(func) {}
+
+        void run() override {
+            m_func();
+        }
+    private:
+        std::function<void()> m_func;
+    };
+
 
 private:
 
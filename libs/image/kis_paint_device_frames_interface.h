@@ -106,6 +106,18 @@ public:
      */
     bool readFrame(QIODevice *stream, int frameId);
 
+    /**
+     * Makes the tiles with identical content share their data
+     * (copy-on-write) across all the frames of the device. Should be
+     * called after the frames have been loaded, since the frames read
+     * from a file do not share anything even if the user has created
+     * them as copies of each other.
+     *
+     * NOTE: the change is not registered in the undo history, so
+     *       no transaction should be open on the device!
+     */
+    void deduplicateFrames();
+
 
     /**
      * Returns frameId of the currently active frame.
@@ -0,0 +1,284 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_paint_device_thumbnail_cache.h"
+
+#include <QMutexLocker>
+#include <QSet>
+#include <QVector>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoMixColorsOp.h>
+
+#include "kis_default_bounds_base.h"
+#include "kis_paint_device.h"
+
+
+namespace {
+
+const int tileSize = 64;
+
+/**
+ * The biggest level reduces every tile 4 times. Bigger thumbnails
+ * are not cached, because the levels would take too much memory
+ * for big devices.
+ */
+const int maxBlockSize = 16;
+
+inline quint64 blockKey(qint32 col, qint32 row) {
+    return (quint64(quint32(col)) << 32) | quint32(row);
+}
+
+inline qint32 blockCol(quint64 key) {
+    return qint32(quint32(key >> 32));
+}
+
+inline qint32 blockRow(quint64 key) {
+    return qint32(quint32(key & 0xFFFFFFFF));
+}
+
+inline int divideRoundDown(int x, int y) {
+    return x >= 0 ? x / y : -((-x + y - 1) / y);
+}
+
+}
+
+KisPaintDeviceThumbnailCache::KisPaintDeviceThumbnailCache(KisPaintDevice *paintDevice)
+    : m_paintDevice(paintDevice)
+{
+}
+
+KisPaintDeviceThumbnailCache::~KisPaintDeviceThumbnailCache()
+{
+}
+
+QImage KisPaintDeviceThumbnailCache::createThumbnail(qint32 w, qint32 h,
+                                                     KoColorConversionTransformation::Intent renderingIntent,
+                                                     KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    if (w <= 0 || h <= 0) return QImage();
+    if (m_paintDevice->defaultBounds()->wrapAroundMode()) return QImage();
+
+    const QRect extent = m_paintDevice->extent();
+    if (extent.isEmpty()) return QImage();
+
+    const QPoint offset(m_paintDevice->x(), m_paintDevice->y());
+
+    // the extent consists of whole tiles
+    if ((extent.x() - offset.x()) % tileSize || (extent.y() - offset.y()) % tileSize ||
+        extent.width() % tileSize || extent.height() % tileSize) {
+
+        return QImage();
+    }
+
+    const int numColumns = extent.width() / tileSize;
+    const int numRows = extent.height() / tileSize;
+
+    int blockSize = 1;
+    while (numColumns * blockSize < w || numRows * blockSize < h) {
+        blockSize *= 2;
+    }
+
+    if (blockSize > maxBlockSize) return QImage();
+
+    QMutexLocker l(&m_mutex);
+
+    QMap<int, Level>::iterator it = m_levels.lowerBound(blockSize);
+
+    if (it == m_levels.end()) {
+        it = m_levels.insert(blockSize, Level());
+        it->blockSize = blockSize;
+    }
+
+    updateLevel(&(*it));
+
+    QImage image = composeLevel(*it, extent, renderingIntent, conversionFlags);
+
+    if (image.size() != QSize(w, h)) {
+        image = image.scaled(w, h, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    return image;
+}
+
+void KisPaintDeviceThumbnailCache::clear()
+{
+    QMutexLocker l(&m_mutex);
+    m_levels.clear();
+}
+
+void KisPaintDeviceThumbnailCache::updateLevel(Level *level)
+{
+    const qint64 revision = m_paintDevice->revision();
+    const QPoint offset(m_paintDevice->x(), m_paintDevice->y());
+    const KoColorSpace *colorSpace = m_paintDevice->colorSpace();
+    const int pixelSize = colorSpace->pixelSize();
+
+    /**
+     * The blocks are stored in the color space of the device at the
+     * moment of the update, they cannot be reused after a conversion
+     */
+    const bool sameDevice =
+        level->colorSpace == colorSpace &&
+        level->pixelSize == pixelSize;
+
+    /**
+     * The blocks are indexed by the tiles of the device, so moving the
+     * device doesn't invalidate them
+     */
+    level->offset = offset;
+
+    if (level->revision == revision && sameDevice) return;
+
+    QVector<QRect> rects;
+
+    const bool canUpdateIncrementally =
+        level->revision >= 0 && sameDevice &&
+        m_paintDevice->changedRects(level->revision, &rects);
+
+    if (!canUpdateIncrementally) {
+        level->blocks.clear();
+        rects = m_paintDevice->region().rects();
+    }
+
+    /**
+     * The revision is fetched before reading the tiles, so the changes
+     * made while the level is being updated will be caught next time
+     */
+    level->revision = revision;
+    level->colorSpace = colorSpace;
+    level->pixelSize = pixelSize;
+
+    QSet<quint64> updatedBlocks;
+
+    Q_FOREACH (const QRect &rc, rects) {
+        const int firstCol = divideRoundDown(rc.left() - offset.x(), tileSize);
+        const int lastCol = divideRoundDown(rc.right() - offset.x(), tileSize);
+        const int firstRow = divideRoundDown(rc.top() - offset.y(), tileSize);
+        const int lastRow = divideRoundDown(rc.bottom() - offset.y(), tileSize);
+
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int col = firstCol; col <= lastCol; col++) {
+                const quint64 key = blockKey(col, row);
+                if (updatedBlocks.contains(key)) continue;
+
+                updateBlock(level, col, row);
+                updatedBlocks.insert(key);
+            }
+        }
+    }
+}
+
+void KisPaintDeviceThumbnailCache::updateBlock(Level *level, qint32 col, qint32 row)
+{
+    const KoColorSpace *cs = level->colorSpace;
+    const int pixelSize = level->pixelSize;
+
+    const QRect tileRect(level->offset.x() + col * tileSize,
+                         level->offset.y() + row * tileSize,
+                         tileSize, tileSize);
+
+    QVector<quint8> buffer(tileSize * tileSize * pixelSize);
+    m_paintDevice->readBytes(buffer.data(), tileRect);
+
+    const quint64 key = blockKey(col, row);
+
+    /**
+     * Removed tiles and the tiles filled with the default pixel
+     * are not stored, the default pixel of the device is used for
+     * them instead
+     */
+    const KoColor defaultPixel = m_paintDevice->defaultPixel();
+    const quint8 *srcPtr = buffer.constData();
+    bool isDefault = true;
+
+    for (int i = 0; i < tileSize * tileSize; i++, srcPtr += pixelSize) {
+        if (memcmp(srcPtr, defaultPixel.data(), pixelSize)) {
+            isDefault = false;
+            break;
+        }
+    }
+
+    if (isDefault) {
+        level->blocks.remove(key);
+        return;
+    }
+
+    const int blockSize = level->blockSize;
+    const int cellSize = tileSize / blockSize;
+
+    QByteArray &block = level->blocks[key];
+    block.resize(blockSize * blockSize * pixelSize);
+
+    quint8 *dstPtr = reinterpret_cast<quint8*>(block.data());
+
+    QVector<const quint8*> cellPixels(cellSize * cellSize);
+    const KoMixColorsOp *mixOp = cs->mixColorsOp();
+
+    for (int by = 0; by < blockSize; by++) {
+        for (int bx = 0; bx < blockSize; bx++) {
+            const quint8 **pixelPtr = cellPixels.data();
+
+            for (int y = 0; y < cellSize; y++) {
+                const quint8 *rowPtr = buffer.constData() +
+                    ((by * cellSize + y) * tileSize + bx * cellSize) * pixelSize;
+
+                for (int x = 0; x < cellSize; x++, rowPtr += pixelSize) {
+                    *pixelPtr++ = rowPtr;
+                }
+            }
+
+            mixOp->mixColors(cellPixels.constData(), cellPixels.size(), dstPtr);
+            dstPtr += pixelSize;
+        }
+    }
+}
+
+QImage KisPaintDeviceThumbnailCache::composeLevel(const Level &level, const QRect &extent,
+                                                  KoColorConversionTransformation::Intent renderingIntent,
+                                                  KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    const int blockSize = level.blockSize;
+
+    const int firstCol = (extent.x() - level.offset.x()) / tileSize;
+    const int firstRow = (extent.y() - level.offset.y()) / tileSize;
+    const QRect levelRect(0, 0,
+                          extent.width() / tileSize * blockSize,
+                          extent.height() / tileSize * blockSize);
+
+    KisPaintDeviceSP levelDevice = new KisPaintDevice(level.colorSpace);
+    levelDevice->setDefaultPixel(m_paintDevice->defaultPixel());
+
+    for (QHash<quint64, QByteArray>::const_iterator it = level.blocks.constBegin();
+         it != level.blocks.constEnd(); ++it) {
+
+        const QRect blockRect((blockCol(it.key()) - firstCol) * blockSize,
+                              (blockRow(it.key()) - firstRow) * blockSize,
+                              blockSize, blockSize);
+
+        // the device could have grown after the extent has been fetched
+        if (!levelRect.contains(blockRect)) continue;
+
+        levelDevice->writeBytes(reinterpret_cast<const quint8*>(it.value().constData()), blockRect);
+    }
+
+    return levelDevice->convertToQImage(KoColorSpaceRegistry::instance()->rgb8()->profile(),
+                                        levelRect.x(), levelRect.y(),
+                                        levelRect.width(), levelRect.height(),
+                                        renderingIntent, conversionFlags);
+}
@@ -0,0 +1,87 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_PAINT_DEVICE_THUMBNAIL_CACHE_H
+#define __KIS_PAINT_DEVICE_THUMBNAIL_CACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QPoint>
+
+#include <KoColorConversionTransformation.h>
+
+class KisPaintDevice;
+class KoColorSpace;
+
+
+/**
+ * KisPaintDeviceThumbnailCache keeps low resolution copies (levels) of the
+ * tiles of a paint device. Every tile is reduced to a square block of
+ * averaged pixels, so a level with block size N is the device downscaled
+ * by 64 / N. When a thumbnail is requested, only the tiles changed since
+ * the last request are reduced again (see KisPaintDevice::changedRects()),
+ * and the thumbnail is scaled from the nearest level that is not smaller
+ * than the requested size.
+ *
+ * The thumbnails that are too big to be generated from a level (or the
+ * thumbnails of wrapped devices) are not handled by the cache, then
+ * createThumbnail() returns a null image.
+ */
+class KisPaintDeviceThumbnailCache
+{
+public:
+    KisPaintDeviceThumbnailCache(KisPaintDevice *paintDevice);
+    ~KisPaintDeviceThumbnailCache();
+
+    /**
+     * @return the thumbnail of the extent of the device of size \p w x \p h
+     *         or a null image if the thumbnail cannot be created from the
+     *         cache
+     */
+    QImage createThumbnail(qint32 w, qint32 h,
+                           KoColorConversionTransformation::Intent renderingIntent,
+                           KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+    void clear();
+
+private:
+    struct Level {
+        Level() : blockSize(0), revision(-1), colorSpace(0), pixelSize(0) {}
+
+        int blockSize;
+        qint64 revision;
+        QPoint offset;
+        const KoColorSpace *colorSpace;
+        int pixelSize;
+        QHash<quint64, QByteArray> blocks;
+    };
+
+    void updateLevel(Level *level);
+    void updateBlock(Level *level, qint32 col, qint32 row);
+    QImage composeLevel(const Level &level, const QRect &extent,
+                        KoColorConversionTransformation::Intent renderingIntent,
+                        KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+private:
+    KisPaintDevice *m_paintDevice;
+    QMap<int, Level> m_levels;
+    QMutex m_mutex;
+};
+
+#endif /* __KIS_PAINT_DEVICE_THUMBNAIL_CACHE_H */
@@ -0,0 +1,319 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_paint_device_tile_bounds_cache.h"
+
+#include <algorithm>
+
+#include <QMutexLocker>
+#include <QPair>
+#include <QSet>
+#include <QVector>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceConstants.h>
+
+#include "kis_default_bounds_base.h"
+#include "kis_paint_device.h"
+
+
+namespace {
+
+const int tileSize = 64;
+
+inline quint64 tileKey(qint32 col, qint32 row) {
+    return (quint64(quint32(col)) << 32) | quint32(row);
+}
+
+inline QRect tileRectByKey(quint64 key, const QPoint &offset) {
+    const qint32 col = qint32(quint32(key >> 32));
+    const qint32 row = qint32(quint32(key));
+
+    return QRect(offset.x() + col * tileSize,
+                 offset.y() + row * tileSize,
+                 tileSize, tileSize);
+}
+
+/**
+ * The distance from the tile to the nearest edge of \p rc
+ */
+inline int distanceToEdge(const QRect &tileRect, const QRect &rc) {
+    return std::min(std::min(tileRect.left() - rc.left(), rc.right() - tileRect.right()),
+                    std::min(tileRect.top() - rc.top(), rc.bottom() - tileRect.bottom()));
+}
+
+inline int divideRoundDown(int x, int y) {
+    return x >= 0 ? x / y : -((-x + y - 1) / y);
+}
+
+/**
+ * Returns the bounds of the elements of a tile that differ from the
+ * elements of \p emptyRow. The rows are compared with memcmp(), which
+ * is vectorized by the C library, so only the rows between the top and
+ * the bottom edges are checked element by element, and only up to the
+ * left and right edges found so far.
+ */
+QRect calculateTightBounds(const quint8 *data, int elementSize, const quint8 *emptyRow)
+{
+    const int rowSize = tileSize * elementSize;
+
+    int top = 0;
+    while (top < tileSize && !memcmp(data + top * rowSize, emptyRow, rowSize)) {
+        top++;
+    }
+
+    if (top >= tileSize) return QRect();
+
+    int bottom = tileSize - 1;
+    while (!memcmp(data + bottom * rowSize, emptyRow, rowSize)) {
+        bottom--;
+    }
+
+    int left = tileSize;
+    int right = -1;
+
+    for (int y = top; y <= bottom; y++) {
+        const quint8 *rowPtr = data + y * rowSize;
+
+        for (int x = 0; x < left; x++) {
+            if (memcmp(rowPtr + x * elementSize, emptyRow, elementSize)) {
+                left = x;
+                break;
+            }
+        }
+
+        for (int x = tileSize - 1; x > right; x--) {
+            if (memcmp(rowPtr + x * elementSize, emptyRow, elementSize)) {
+                right = x;
+                break;
+            }
+        }
+    }
+
+    return QRect(left, top, right - left + 1, bottom - top + 1);
+}
+
+}
+
+KisPaintDeviceTileBoundsCache::KisPaintDeviceTileBoundsCache(KisPaintDevice *paintDevice)
+    : m_paintDevice(paintDevice)
+{
+}
+
+KisPaintDeviceTileBoundsCache::~KisPaintDeviceTileBoundsCache()
+{
+}
+
+bool KisPaintDeviceTileBoundsCache::exactBounds(QRect *bounds)
+{
+    const KoColor defaultPixel = m_paintDevice->defaultPixel();
+
+    if (defaultPixel.opacityU8() == OPACITY_TRANSPARENT_U8) {
+        return calculateBounds(NonTransparent, bounds);
+    }
+
+    /**
+     * The device with non-transparent default pixel covers at least
+     * the image bounds, so only the non-default pixels outside them
+     * can extend its exact bounds
+     */
+    if (!calculateBounds(NonDefault, bounds)) return false;
+
+    *bounds |= m_paintDevice->defaultBounds()->bounds();
+    return true;
+}
+
+bool KisPaintDeviceTileBoundsCache::nonDefaultPixelArea(QRect *bounds)
+{
+    return calculateBounds(NonDefault, bounds);
+}
+
+void KisPaintDeviceTileBoundsCache::clear()
+{
+    QMutexLocker l(&m_mutex);
+
+    for (int i = 0; i < 2; i++) {
+        m_tileBounds[i] = TileBounds();
+    }
+}
+
+bool KisPaintDeviceTileBoundsCache::calculateBounds(Mode mode, QRect *bounds)
+{
+    if (m_paintDevice->defaultBounds()->wrapAroundMode()) return false;
+
+    QMutexLocker l(&m_mutex);
+
+    TileBounds &tileBounds = m_tileBounds[mode];
+    updateTiles(mode, &tileBounds);
+
+    if (!tileBounds.boundsValid) {
+        QRect result;
+
+        Q_FOREACH (const QRect &rc, tileBounds.tiles) {
+            result |= rc;
+        }
+
+        /**
+         * A tile lying inside the bounds of the other tiles cannot extend
+         * them, so it is not scanned at all. The outermost tiles are
+         * scanned first to make the bounds grow as fast as possible.
+         */
+        if (!tileBounds.unscannedTiles.isEmpty()) {
+            typedef QPair<int, quint64> Candidate;
+
+            QRect totalRect = result;
+            Q_FOREACH (quint64 key, tileBounds.unscannedTiles) {
+                totalRect |= tileRectByKey(key, tileBounds.offset);
+            }
+
+            QVector<Candidate> candidates;
+            candidates.reserve(tileBounds.unscannedTiles.size());
+
+            Q_FOREACH (quint64 key, tileBounds.unscannedTiles) {
+                const QRect tileRect = tileRectByKey(key, tileBounds.offset);
+                candidates << Candidate(distanceToEdge(tileRect, totalRect), key);
+            }
+
+            std::sort(candidates.begin(), candidates.end());
+
+            const quint8 *defaultPixel =
+                reinterpret_cast<const quint8*>(tileBounds.defaultPixel.constData());
+
+            Q_FOREACH (const Candidate &candidate, candidates) {
+                const quint64 key = candidate.second;
+                const QRect tileRect = tileRectByKey(key, tileBounds.offset);
+
+                if (result.contains(tileRect)) continue;
+
+                const QRect bounds = calculateTileBounds(mode, tileRect, defaultPixel);
+                tileBounds.unscannedTiles.remove(key);
+
+                if (!bounds.isEmpty()) {
+                    tileBounds.tiles.insert(key, bounds);
+                    result |= bounds;
+                }
+            }
+        }
+
+        tileBounds.bounds = result;
+        tileBounds.boundsValid = true;
+    }
+
+    *bounds = tileBounds.bounds;
+    return true;
+}
+
+void KisPaintDeviceTileBoundsCache::updateTiles(Mode mode, TileBounds *tileBounds)
+{
+    const qint64 revision = m_paintDevice->revision();
+    const QPoint offset(m_paintDevice->x(), m_paintDevice->y());
+    const KoColorSpace *colorSpace = m_paintDevice->colorSpace();
+    const KoColor defaultPixelColor = m_paintDevice->defaultPixel();
+    const QByteArray defaultPixel(reinterpret_cast<const char*>(defaultPixelColor.data()),
+                                  colorSpace->pixelSize());
+
+    const bool sameDevice =
+        tileBounds->colorSpace == colorSpace &&
+        tileBounds->defaultPixel == defaultPixel;
+
+    /**
+     * Moving the device doesn't change its tiles, so the cached bounds
+     * are just moved with them (e.g. on every step of the Move tool)
+     */
+    if (tileBounds->revision >= 0 && sameDevice && tileBounds->offset != offset) {
+        const QPoint delta = offset - tileBounds->offset;
+
+        for (QHash<quint64, QRect>::iterator it = tileBounds->tiles.begin();
+             it != tileBounds->tiles.end(); ++it) {
+
+            it->translate(delta);
+        }
+
+        tileBounds->bounds.translate(delta);
+        tileBounds->offset = offset;
+    }
+
+    if (tileBounds->revision == revision && sameDevice) return;
+
+    QVector<QRect> rects;
+
+    const bool canUpdateIncrementally =
+        tileBounds->revision >= 0 && sameDevice &&
+        m_paintDevice->changedRects(tileBounds->revision, &rects);
+
+    if (!canUpdateIncrementally) {
+        tileBounds->tiles.clear();
+        tileBounds->unscannedTiles.clear();
+        rects = m_paintDevice->region().rects();
+    }
+
+    /**
+     * The revision is fetched before reading the tiles, so the changes
+     * made while the tiles are being scanned will be caught next time.
+     * The changed tiles are only marked here, they are scanned by
+     * calculateBounds() when needed.
+     */
+    tileBounds->revision = revision;
+    tileBounds->offset = offset;
+    tileBounds->colorSpace = colorSpace;
+    tileBounds->defaultPixel = defaultPixel;
+    tileBounds->boundsValid = false;
+
+    Q_FOREACH (const QRect &rc, rects) {
+        const int firstCol = divideRoundDown(rc.left() - offset.x(), tileSize);
+        const int lastCol = divideRoundDown(rc.right() - offset.x(), tileSize);
+        const int firstRow = divideRoundDown(rc.top() - offset.y(), tileSize);
+        const int lastRow = divideRoundDown(rc.bottom() - offset.y(), tileSize);
+
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int col = firstCol; col <= lastCol; col++) {
+                const quint64 key = tileKey(col, row);
+
+                tileBounds->tiles.remove(key);
+                tileBounds->unscannedTiles.insert(key);
+            }
+        }
+    }
+}
+
+QRect KisPaintDeviceTileBoundsCache::calculateTileBounds(Mode mode, const QRect &tileRect, const quint8 *defaultPixel)
+{
+    const KoColorSpace *cs = m_paintDevice->colorSpace();
+    const int pixelSize = cs->pixelSize();
+
+    QVector<quint8> buffer(tileSize * tileSize * pixelSize);
+    m_paintDevice->readBytes(buffer.data(), tileRect);
+
+    QRect bounds;
+
+    if (mode == NonDefault) {
+        QVector<quint8> emptyRow(tileSize * pixelSize);
+        for (int i = 0; i < tileSize; i++) {
+            memcpy(emptyRow.data() + i * pixelSize, defaultPixel, pixelSize);
+        }
+
+        bounds = calculateTightBounds(buffer.constData(), pixelSize, emptyRow.constData());
+    } else {
+        QVector<quint8> opacity(tileSize * tileSize);
+        cs->copyOpacityU8(buffer.constData(), opacity.data(), tileSize * tileSize);
+
+        const QVector<quint8> emptyRow(tileSize, OPACITY_TRANSPARENT_U8);
+        bounds = calculateTightBounds(opacity.constData(), 1, emptyRow.constData());
+    }
+
+    return bounds.translated(tileRect.topLeft());
+}
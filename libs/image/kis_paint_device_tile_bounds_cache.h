@@ -0,0 +1,97 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_PAINT_DEVICE_TILE_BOUNDS_CACHE_H
+#define __KIS_PAINT_DEVICE_TILE_BOUNDS_CACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPoint>
+#include <QRect>
+#include <QSet>
+
+class KisPaintDevice;
+class KoColorSpace;
+
+
+/**
+ * KisPaintDeviceTileBoundsCache keeps the tight bounds of the non-default
+ * and of the non-transparent pixels of every tile of a paint device. When
+ * the bounds are requested, only the tiles changed since the previous
+ * request are scanned again (see KisPaintDevice::changedRects()), and the
+ * bounds of the device are united from the bounds of the tiles, that is,
+ * the calculation is linear in the number of tiles, not pixels.
+ *
+ * The changed tiles are scanned lazily: the tiles lying completely inside
+ * the bounds found so far cannot extend them, so they are left unscanned
+ * until the bounds shrink. For a filled layer it means that only the tiles
+ * along its edges are read.
+ *
+ * The wrapped devices are not handled by the cache, then the methods
+ * return false and the caller should scan the device itself.
+ */
+class KisPaintDeviceTileBoundsCache
+{
+public:
+    KisPaintDeviceTileBoundsCache(KisPaintDevice *paintDevice);
+    ~KisPaintDeviceTileBoundsCache();
+
+    /**
+     * Calculates the same value as KisPaintDevice::calculateExactBounds(false)
+     * \return false if the bounds cannot be calculated by the cache
+     */
+    bool exactBounds(QRect *bounds);
+
+    /**
+     * Calculates the same value as KisPaintDevice::calculateExactBounds(true)
+     * \return false if the bounds cannot be calculated by the cache
+     */
+    bool nonDefaultPixelArea(QRect *bounds);
+
+    void clear();
+
+private:
+    enum Mode {
+        NonDefault,
+        NonTransparent
+    };
+
+    struct TileBounds {
+        TileBounds() : revision(-1), colorSpace(0), boundsValid(false) {}
+
+        qint64 revision;
+        QPoint offset;
+        const KoColorSpace *colorSpace;
+        QByteArray defaultPixel;
+        QHash<quint64, QRect> tiles;
+        QSet<quint64> unscannedTiles;
+
+        bool boundsValid;
+        QRect bounds;
+    };
+
+    bool calculateBounds(Mode mode, QRect *bounds);
+    void updateTiles(Mode mode, TileBounds *tileBounds);
+    QRect calculateTileBounds(Mode mode, const QRect &tileRect, const quint8 *defaultPixel);
+
+private:
+    KisPaintDevice *m_paintDevice;
+    TileBounds m_tileBounds[2];
+    QMutex m_mutex;
+};
+
+#endif /* __KIS_PAINT_DEVICE_TILE_BOUNDS_CACHE_H */
@@ -2763,6 +2763,23 @@ void KisPainter::renderMirrorMaskSafe(QRect rc, KisPaintDeviceSP dab, int sx, in
     renderMirrorMask(rc, dab, sx, sy, maskToProcess);
 }
 
+void KisPainter::renderMirrorMaskSafe(QRect rc, KisFixedPaintDeviceSP dab, KisFixedPaintDeviceSP mask, bool preserveDab, bool preserveMask)
+{
+    if (!d->mirrorHorizontally && !d->mirrorVertically) return;
+
+    KisFixedPaintDeviceSP dabToProcess = dab;
+    if (preserveDab) {
+        dabToProcess = new KisFixedPaintDevice(*dab);
+    }
+
+    KisFixedPaintDeviceSP maskToProcess = mask;
+    if (preserveMask) {
+        maskToProcess = new KisFixedPaintDevice(*mask);
+    }
+
+    renderMirrorMask(rc, dabToProcess, maskToProcess);
+}
+
 void KisPainter::renderMirrorMask(QRect rc, KisFixedPaintDeviceSP dab)
 {
     int x = rc.topLeft().x();
@@ -407,6 +407,21 @@ public:
      */
     void renderMirrorMaskSafe(QRect rc, KisPaintDeviceSP dab, int sx, int sy, KisFixedPaintDeviceSP mask, bool preserveMask);
 
+    /**
+     * Convenience method for renderMirrorMask(), allows to choose whether
+     * we need to preserve our fixed dab and mask or do the transformations
+     * in-place.
+     *
+     * @param rc rectangle area covered by dab
+     * @param dab the device to render
+     * @param mask mask to use for rendering
+     * @param preserveDab states whether a temporary copy of the dab should
+     *                    be created to do the transformations
+     * @param preserveMask states whether a temporary copy of the mask should
+     *                    be created to do the transformations
+     */
+    void renderMirrorMaskSafe(QRect rc, KisFixedPaintDeviceSP dab, KisFixedPaintDeviceSP mask, bool preserveDab, bool preserveMask);
+
     /**
      * A complex method that re-renders a dab on an \p rc area.
      * The \p rc  area and all the dedicated mirroring areas are cleared
@@ -0,0 +1,207 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_SLIDING_HISTOGRAM_H
+#define __KIS_SLIDING_HISTOGRAM_H
+
+#include <QAtomicInt>
+#include <QRect>
+#include <QVector>
+#include <QtConcurrent>
+#include <QtMath>
+
+#include <KoUpdater.h>
+
+#include "kis_paint_device.h"
+
+
+/**
+ * KisSlidingHistogram applies a rank-like filter (median, most frequent
+ * color, min/max of a neighbourhood...) with a square window of
+ * (2 * radius + 1) x (2 * radius + 1) pixels.
+ *
+ * The window slides along the rows (Huang's algorithm): when it moves
+ * one pixel to the right, the column that leaves the window is removed
+ * from the histogram and the column that enters is added, so the cost
+ * per pixel is O(radius) instead of O(radius^2).
+ *
+ * The area is split into strips of rows, which are processed in
+ * parallel. The source pixels of a strip are read in one go and
+ * converted into samples once, so the histogram never touches the
+ * color space in the inner loop.
+ *
+ * The histogram is a policy class that is copied for every strip:
+ *
+ * \code{.cpp}
+ * struct Histogram {
+ *     // the number of floats a pixel is converted into
+ *     int sampleSize() const;
+ *     void sample(const quint8 *pixel, float *sample);
+ *
+ *     void reset();
+ *     void addSample(const float *sample);
+ *     void removeSample(const float *sample);
+ *
+ *     // writes the filtered pixel for the current window
+ *     void writeResult(quint8 *dst);
+ * };
+ * \endcode
+ */
+namespace KisSlidingHistogram
+{
+
+/**
+ * The height of the strips processed in parallel,
+ * it is aligned to the size of the tiles
+ */
+static const int stripHeight = 64;
+
+/**
+ * Applies the filter to \p applyRect of \p dst reading the pixels
+ * from \p src. The window is clipped by \p sourceBounds, the pixels
+ * outside it are never taken into account.
+ *
+ * \p src and \p dst may not be the same device, because the strips
+ * are processed in parallel. To filter a device in place, pass a copy
+ * of it as \p src (the tiles of the copy are shared copy-on-write).
+ */
+template <class Histogram>
+void apply(KisPaintDeviceSP src, KisPaintDeviceSP dst,
+           const QRect &applyRect, const QRect &sourceBounds,
+           int radius, const Histogram &histogram,
+           KoUpdater *progressUpdater)
+{
+    const QRect processRect = applyRect & sourceBounds;
+    if (processRect.isEmpty()) return;
+
+    const int pixelSize = src->pixelSize();
+
+    QVector<QRect> strips;
+
+    for (int y = processRect.top(); y <= processRect.bottom();) {
+        const int nextStrip = (qFloor(qreal(y) / stripHeight) + 1) * stripHeight;
+        const int bottom = qMin(nextStrip - 1, processRect.bottom());
+
+        strips << QRect(processRect.left(), y, processRect.width(), bottom - y + 1);
+        y = bottom + 1;
+    }
+
+    if (progressUpdater) {
+        progressUpdater->setRange(0, processRect.height());
+    }
+
+    QAtomicInt processedRows;
+
+    QtConcurrent::blockingMap(strips, [&] (const QRect &strip) {
+        if (progressUpdater && progressUpdater->interrupted()) return;
+
+        Histogram stripHistogram(histogram);
+        const int sampleSize = stripHistogram.sampleSize();
+
+        const QRect inputRect =
+            strip.adjusted(-radius, -radius, radius, radius) & sourceBounds;
+
+        QVector<float> samples(inputRect.width() * inputRect.height() * sampleSize);
+
+        {
+            QVector<quint8> pixels(inputRect.width() * inputRect.height() * pixelSize);
+            src->readBytes(pixels.data(), inputRect);
+
+            const quint8 *pixel = pixels.constData();
+            float *sample = samples.data();
+
+            for (int i = 0; i < inputRect.width() * inputRect.height(); i++) {
+                stripHistogram.sample(pixel, sample);
+                pixel += pixelSize;
+                sample += sampleSize;
+            }
+        }
+
+        const int sampleRowStride = inputRect.width() * sampleSize;
+
+        auto addColumn = [&] (int x, int top, int bottom) {
+            const float *sample = samples.constData() +
+                (top - inputRect.top()) * sampleRowStride +
+                (x - inputRect.left()) * sampleSize;
+
+            for (int y = top; y <= bottom; y++, sample += sampleRowStride) {
+                stripHistogram.addSample(sample);
+            }
+        };
+
+        auto removeColumn = [&] (int x, int top, int bottom) {
+            const float *sample = samples.constData() +
+                (top - inputRect.top()) * sampleRowStride +
+                (x - inputRect.left()) * sampleSize;
+
+            for (int y = top; y <= bottom; y++, sample += sampleRowStride) {
+                stripHistogram.removeSample(sample);
+            }
+        };
+
+        QVector<quint8> result(strip.width() * strip.height() * pixelSize);
+        quint8 *dstPtr = result.data();
+
+        for (int y = strip.top(); y <= strip.bottom(); y++) {
+            const int top = qMax(y - radius, inputRect.top());
+            const int bottom = qMin(y + radius, inputRect.bottom());
+
+            /**
+             * The histogram is rebuilt for every row, which also
+             * keeps the rounding errors of the floating point
+             * samples from accumulating
+             */
+            stripHistogram.reset();
+
+            const int left = strip.left();
+            const int firstColumn = qMax(left - radius, inputRect.left());
+            const int lastColumn = qMin(left + radius, inputRect.right());
+
+            for (int x = firstColumn; x <= lastColumn; x++) {
+                addColumn(x, top, bottom);
+            }
+
+            for (int x = left; x <= strip.right(); x++) {
+                if (x > left) {
+                    const int leavingColumn = x - radius - 1;
+                    const int enteringColumn = x + radius;
+
+                    if (leavingColumn >= inputRect.left()) {
+                        removeColumn(leavingColumn, top, bottom);
+                    }
+
+                    if (enteringColumn <= inputRect.right()) {
+                        addColumn(enteringColumn, top, bottom);
+                    }
+                }
+
+                stripHistogram.writeResult(dstPtr);
+                dstPtr += pixelSize;
+            }
+        }
+
+        dst->writeBytes(result.constData(), strip);
+
+        const int rows = processedRows.fetchAndAddOrdered(strip.height()) + strip.height();
+        if (progressUpdater) {
+            progressUpdater->setValue(rows);
+        }
+    });
+}
+
+}
+
+#endif /* __KIS_SLIDING_HISTOGRAM_H */
@@ -19,6 +19,7 @@
 #include "kis_stroke.h"
 
 #include "kis_stroke_strategy.h"
+#include "kis_stroke_tracer.h"
 
 
 KisStroke::KisStroke(KisStrokeStrategy *strokeStrategy, Type type, int levelOfDetail)
@@ -257,6 +258,19 @@ bool KisStroke::nextJobBarrier() const
         m_jobsQueue.head()->isBarrier() : false;
 }
 
+namespace {
+
+/**
+ * The id of the strategy is attached to the jobs only for tracing,
+ * so don't copy it when the tracer is disabled
+ */
+inline QString traceStrokeId(const KisStrokeStrategy *strategy)
+{
+    return KisStrokeTracer::instance()->isEnabled() ? strategy->id() : QString();
+}
+
+}
+
 void KisStroke::enqueue(KisStrokeJobStrategy *strategy,
                         KisStrokeJobData *data)
 {
@@ -266,7 +280,7 @@ void KisStroke::enqueue(KisStrokeJobStrategy *strategy,
         return;
     }
 
-    m_jobsQueue.enqueue(new KisStrokeJob(strategy, data, worksOnLevelOfDetail(), true));
+    m_jobsQueue.enqueue(new KisStrokeJob(strategy, data, worksOnLevelOfDetail(), true, traceStrokeId(m_strokeStrategy.data())));
 }
 
 void KisStroke::prepend(KisStrokeJobStrategy *strategy,
@@ -283,7 +297,7 @@ void KisStroke::prepend(KisStrokeJobStrategy *strategy,
     // LOG_MERGE_FIXME:
     Q_UNUSED(levelOfDetail);
 
-    m_jobsQueue.prepend(new KisStrokeJob(strategy, data, worksOnLevelOfDetail(), isCancellable));
+    m_jobsQueue.prepend(new KisStrokeJob(strategy, data, worksOnLevelOfDetail(), isCancellable, traceStrokeId(m_strokeStrategy.data())));
 }
 
 KisStrokeJob* KisStroke::dequeue()
@@ -19,6 +19,8 @@
 #ifndef __KIS_STROKE_JOB_H
 #define __KIS_STROKE_JOB_H
 
+#include <QString>
+
 #include "kis_runnable.h"
 #include "kis_stroke_job_strategy.h"
 
@@ -28,11 +30,13 @@ public:
     KisStrokeJob(KisStrokeJobStrategy *strategy,
                  KisStrokeJobData *data,
                  int levelOfDetail,
-                 bool isCancellable)
+                 bool isCancellable,
+                 const QString &strokeId = QString())
         : m_dabStrategy(strategy),
           m_dabData(data),
           m_levelOfDetail(levelOfDetail),
-          m_isCancellable(isCancellable)
+          m_isCancellable(isCancellable),
+          m_strokeId(strokeId)
     {
     }
 
@@ -67,6 +71,14 @@ public:
         return m_isCancellable;
     }
 
+    /**
+     * The id of the stroke strategy the job belongs to. Used for
+     * tracing only, see KisStrokeTracer
+     */
+    QString strokeId() const {
+        return m_strokeId;
+    }
+
 private:
     // for testing use only, do not use in real code
     friend QString getJobName(KisStrokeJob *job);
@@ -90,6 +102,7 @@ private:
 
     int m_levelOfDetail;
     bool m_isCancellable;
+    QString m_strokeId;
 };
 
 #endif /* __KIS_STROKE_JOB_H */
@@ -0,0 +1,335 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_stroke_tracer.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGlobalStatic>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QThread>
+#include <QThreadStorage>
+#include <QWeakPointer>
+
+#include "kis_debug.h"
+
+Q_GLOBAL_STATIC(KisStrokeTracer, s_instance)
+
+namespace {
+
+/**
+ * The events of a thread are stored in a ring buffer, so only the
+ * latest MaxEventsPerThread events are kept. The buffer is written by
+ * the owning thread only, so its lock is contended only while the
+ * events are being read or cleared.
+ */
+struct ThreadBuffer
+{
+    ThreadBuffer(int _id, const QString &_threadName)
+        : id(_id),
+          threadName(_threadName),
+          nextIndex(0)
+    {
+    }
+
+    void append(const KisStrokeTracer::Event &event) {
+        QMutexLocker l(&lock);
+
+        if (events.size() < KisStrokeTracer::MaxEventsPerThread) {
+            events.append(event);
+            events.last().threadId = id;
+        } else {
+            events[nextIndex] = event;
+            events[nextIndex].threadId = id;
+            nextIndex = (nextIndex + 1) % events.size();
+        }
+    }
+
+    void fetchEvents(QVector<KisStrokeTracer::Event> *result) {
+        QMutexLocker l(&lock);
+
+        // the oldest event is at nextIndex
+        for (int i = nextIndex; i < events.size(); i++) {
+            result->append(events[i]);
+        }
+        for (int i = 0; i < nextIndex; i++) {
+            result->append(events[i]);
+        }
+    }
+
+    void clear() {
+        QMutexLocker l(&lock);
+
+        events.clear();
+        events.squeeze();
+        nextIndex = 0;
+    }
+
+    const int id;
+    const QString threadName;
+
+    QMutex lock;
+    QVector<KisStrokeTracer::Event> events;
+    int nextIndex;
+};
+
+typedef QSharedPointer<ThreadBuffer> ThreadBufferSP;
+typedef QWeakPointer<ThreadBuffer> ThreadBufferWSP;
+
+/**
+ * The buffers are owned by the tracers, the threads keep only weak
+ * references to them, keyed by the serial number of the tracer. The
+ * storage is shared by all the tracers, so the references are freed
+ * when the thread exits, not when the tracer is destroyed.
+ */
+typedef QHash<int, ThreadBufferWSP> ThreadBuffersHash;
+Q_GLOBAL_STATIC(QThreadStorage<ThreadBuffersHash>, s_threadBuffers)
+
+QAtomicInt s_lastTracerSerial(0);
+
+QString jobTypeToCategory(KisStrokeTracer::JobType type)
+{
+    switch (type) {
+    case KisStrokeTracer::STROKE:
+        return "stroke";
+    case KisStrokeTracer::MERGE:
+        return "merge";
+    case KisStrokeTracer::SPONTANEOUS:
+        return "spontaneous";
+    }
+
+    return "unknown";
+}
+
+}
+
+struct KisStrokeTracer::Private
+{
+    Private() : enabled(false), serial(s_lastTracerSerial.fetchAndAddOrdered(1)) {}
+
+    QAtomicInt enabled;
+    QElapsedTimer timer;
+    const int serial;
+
+    mutable QMutex buffersLock;
+    QList<ThreadBufferSP> buffers;
+
+    QString autoSaveFileName;
+
+    ThreadBufferSP currentBuffer();
+};
+
+ThreadBufferSP KisStrokeTracer::Private::currentBuffer()
+{
+    ThreadBuffersHash &threadBuffers = s_threadBuffers->localData();
+
+    ThreadBufferSP buffer = threadBuffers.value(serial).toStrongRef();
+
+    if (!buffer) {
+        QMutexLocker l(&buffersLock);
+
+        QThread *thread = QThread::currentThread();
+        QString threadName = thread->objectName();
+        if (threadName.isEmpty()) {
+            threadName = QString("Thread %1").arg(buffers.size());
+        }
+
+        buffer = ThreadBufferSP(new ThreadBuffer(buffers.size(), threadName));
+        buffers.append(buffer);
+
+        // drop the references to the buffers of the deleted tracers
+        for (auto it = threadBuffers.begin(); it != threadBuffers.end();) {
+            if (it.value().isNull()) {
+                it = threadBuffers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        threadBuffers.insert(serial, buffer);
+    }
+
+    return buffer;
+}
+
+KisStrokeTracer::KisStrokeTracer()
+    : m_d(new Private)
+{
+    m_d->timer.start();
+
+    m_d->autoSaveFileName = QString::fromLocal8Bit(qgetenv("KRITA_STROKE_TRACE"));
+    if (!m_d->autoSaveFileName.isEmpty()) {
+        setEnabled(true);
+    }
+}
+
+KisStrokeTracer::~KisStrokeTracer()
+{
+    if (!m_d->autoSaveFileName.isEmpty()) {
+        saveChromeTrace(m_d->autoSaveFileName);
+    }
+}
+
+KisStrokeTracer* KisStrokeTracer::instance()
+{
+    return s_instance;
+}
+
+bool KisStrokeTracer::isEnabled() const
+{
+    return m_d->enabled.loadAcquire();
+}
+
+void KisStrokeTracer::setEnabled(bool value)
+{
+    m_d->enabled.storeRelease(value);
+}
+
+qint64 KisStrokeTracer::currentTime() const
+{
+    return m_d->timer.nsecsElapsed();
+}
+
+void KisStrokeTracer::reportJob(JobType type,
+                                const QString &name,
+                                const QString &nodeName,
+                                const QRect &rect,
+                                int levelOfDetail,
+                                qint64 startTime,
+                                qint64 endTime)
+{
+    if (!isEnabled()) return;
+
+    Event event;
+    event.type = type;
+    event.name = name;
+    event.nodeName = nodeName;
+    event.rect = rect;
+    event.levelOfDetail = levelOfDetail;
+    event.startTime = startTime;
+    event.endTime = endTime;
+    event.threadId = -1;
+
+    m_d->currentBuffer()->append(event);
+}
+
+QVector<KisStrokeTracer::Event> KisStrokeTracer::events() const
+{
+    QList<ThreadBufferSP> buffers;
+
+    {
+        QMutexLocker l(&m_d->buffersLock);
+        buffers = m_d->buffers;
+    }
+
+    QVector<Event> result;
+
+    Q_FOREACH (ThreadBufferSP buffer, buffers) {
+        buffer->fetchEvents(&result);
+    }
+
+    return result;
+}
+
+void KisStrokeTracer::clear()
+{
+    QMutexLocker l(&m_d->buffersLock);
+
+    Q_FOREACH (ThreadBufferSP buffer, m_d->buffers) {
+        buffer->clear();
+    }
+}
+
+bool KisStrokeTracer::writeChromeTrace(QIODevice *device) const
+{
+    if (!device->isWritable()) return false;
+
+    const QVector<Event> allEvents = events();
+
+    device->write("{\"traceEvents\":[\n");
+
+    bool first = true;
+    auto writeObject = [device, &first] (const QJsonObject &object) {
+        if (!first) {
+            device->write(",\n");
+        }
+        device->write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+        first = false;
+    };
+
+    {
+        QMutexLocker l(&m_d->buffersLock);
+
+        Q_FOREACH (ThreadBufferSP buffer, m_d->buffers) {
+            QJsonObject args;
+            args["name"] = buffer->threadName;
+
+            QJsonObject metadata;
+            metadata["ph"] = "M";
+            metadata["name"] = "thread_name";
+            metadata["pid"] = 1;
+            metadata["tid"] = buffer->id;
+            metadata["args"] = args;
+
+            writeObject(metadata);
+        }
+    }
+
+    Q_FOREACH (const Event &event, allEvents) {
+        QJsonObject args;
+        args["node"] = event.nodeName;
+        args["lod"] = event.levelOfDetail;
+        args["rect"] = QString("%1,%2 %3x%4")
+            .arg(event.rect.x()).arg(event.rect.y())
+            .arg(event.rect.width()).arg(event.rect.height());
+
+        QJsonObject object;
+        object["name"] = event.name.isEmpty() ? jobTypeToCategory(event.type) : event.name;
+        object["cat"] = jobTypeToCategory(event.type);
+        object["ph"] = "X";
+        object["pid"] = 1;
+        object["tid"] = event.threadId;
+
+        // the format expects microseconds
+        object["ts"] = 0.001 * event.startTime;
+        object["dur"] = 0.001 * (event.endTime - event.startTime);
+        object["args"] = args;
+
+        writeObject(object);
+    }
+
+    device->write("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    return true;
+}
+
+bool KisStrokeTracer::saveChromeTrace(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        warnImage << "Failed to open the stroke trace file" << fileName;
+        return false;
+    }
+
+    return writeChromeTrace(&file);
+}
@@ -0,0 +1,121 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_STROKE_TRACER_H
+#define __KIS_STROKE_TRACER_H
+
+#include <QScopedPointer>
+#include <QString>
+#include <QRect>
+#include <QVector>
+
+#include "kritaimage_export.h"
+
+class QIODevice;
+
+/**
+ * KisStrokeTracer records the execution of every job run by the
+ * updater context: stroke jobs, merge jobs and spontaneous jobs.
+ * Each event contains the thread, start and end time, the processed
+ * rect, the node, the level of detail and the name of the stroke
+ * strategy.
+ *
+ * The events are buffered per thread in ring buffers, which keep only
+ * the latest MaxEventsPerThread events, so the memory taken by the
+ * tracer is bounded while painting. The collected trace can be saved
+ * in the Chrome Trace Event format, which can be opened in
+ * chrome://tracing or in Perfetto UI.
+ *
+ * The tracer is disabled by default. Set KRITA_STROKE_TRACE environment
+ * variable to a file name to enable it on startup; the trace will be
+ * written into this file on exit.
+ */
+class KRITAIMAGE_EXPORT KisStrokeTracer
+{
+public:
+    enum JobType {
+        STROKE,
+        MERGE,
+        SPONTANEOUS
+    };
+
+    struct Event {
+        JobType type;
+        QString name;
+
+        /// the label of the node, the update jobs use its class and address
+        QString nodeName;
+        QRect rect;
+        int levelOfDetail;
+
+        /// start and end time of the job in nanoseconds
+        qint64 startTime;
+        qint64 endTime;
+
+        /// a small sequential number of the thread the job was run in
+        int threadId;
+    };
+
+    /// the number of the latest events kept for every thread
+    static const int MaxEventsPerThread = 16384;
+
+public:
+    KisStrokeTracer();
+    ~KisStrokeTracer();
+
+    static KisStrokeTracer* instance();
+
+    bool isEnabled() const;
+    void setEnabled(bool value);
+
+    /**
+     * @return current time in nanoseconds since the creation of the tracer
+     */
+    qint64 currentTime() const;
+
+    /**
+     * Records a finished job. It is safe to call the method from any
+     * thread. If the tracer is disabled, the call is ignored.
+     */
+    void reportJob(JobType type,
+                   const QString &name,
+                   const QString &nodeName,
+                   const QRect &rect,
+                   int levelOfDetail,
+                   qint64 startTime,
+                   qint64 endTime);
+
+    /**
+     * @return a snapshot of all the events recorded since the last
+     *         clear(), at most MaxEventsPerThread events per thread
+     */
+    QVector<Event> events() const;
+
+    /**
+     * Drops all the events recorded till this moment and
+     * frees the memory taken by them
+     */
+    void clear();
+
+    bool writeChromeTrace(QIODevice *device) const;
+    bool saveChromeTrace(const QString &fileName) const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_STROKE_TRACER_H */
@@ -26,6 +26,7 @@
 #include "kis_spontaneous_job.h"
 #include "kis_base_rects_walker.h"
 #include "kis_async_merger.h"
+#include "kis_stroke_tracer.h"
 
 
 class KisUpdateJobItem :  public QObject, public QRunnable
@@ -77,6 +78,19 @@ public:
                 m_exclusiveJobLock->lockForRead();
             }
 
+            KisStrokeTracer *tracer = KisStrokeTracer::instance();
+            const bool tracingEnabled = tracer->isEnabled();
+            const qint64 traceStartTime = tracingEnabled ? tracer->currentTime() : 0;
+
+            KisStrokeTracer::JobType traceType = KisStrokeTracer::SPONTANEOUS;
+            QString traceName;
+            QString traceNodeName;
+            int traceLevelOfDetail = 0;
+
+            if (tracingEnabled) {
+                fetchTraceInfo(&traceType, &traceName, &traceNodeName, &traceLevelOfDetail);
+            }
+
             if(m_type == MERGE) {
                 runMergeJob();
             } else {
@@ -86,6 +100,12 @@ public:
                 m_runnableJob = 0;
             }
 
+            if (tracingEnabled) {
+                tracer->reportJob(traceType, traceName, traceNodeName,
+                                  m_changeRect, traceLevelOfDetail,
+                                  traceStartTime, tracer->currentTime());
+            }
+
             setDone();
 
 
@@ -98,6 +118,36 @@ public:
         }
     }
 
+    inline void fetchTraceInfo(KisStrokeTracer::JobType *type,
+                               QString *name,
+                               QString *nodeName,
+                               int *levelOfDetail) const {
+
+        if (m_type == MERGE) {
+            *type = KisStrokeTracer::MERGE;
+            *levelOfDetail = m_walker->levelOfDetail();
+
+            /**
+             * The name of the node can be changed by the GUI thread at
+             * any moment, and the walkers are created in any thread too,
+             * so the node is identified by its class and address instead
+             */
+            KisNodeSP node = m_walker->startNode();
+            if (node) {
+                *nodeName = QString("%1 0x%2")
+                    .arg(node->metaObject()->className())
+                    .arg(quintptr(node.data()), 0, 16);
+            }
+        } else if (m_type == STROKE) {
+            KisStrokeJob *job = static_cast<KisStrokeJob*>(m_runnableJob);
+            *type = KisStrokeTracer::STROKE;
+            *name = job->strokeId();
+            *levelOfDetail = job->levelOfDetail();
+        } else {
+            *type = KisStrokeTracer::SPONTANEOUS;
+        }
+    }
+
     inline void runMergeJob() {
         Q_ASSERT(m_type == MERGE);
         // dbgKrita << "Executing merge job" << m_walker->changeRect()
@@ -85,6 +85,8 @@ struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
           numTickets(0),
           numUpdates(0),
           mousePath(0.0),
+          guiEventsTime(0),
+          numGuiEvents(0),
           loggingEnabled(false)
     {
         loggingEnabled = KisImageConfig().enablePerfLog();
@@ -104,6 +106,9 @@ struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
     QElapsedTimer strokeTime;
     KisPaintOpPresetSP preset;
 
+    qint64 guiEventsTime;
+    qint32 numGuiEvents;
+
     bool loggingEnabled;
 };
 
@@ -140,6 +145,8 @@ void KisUpdateTimeMonitor::startStrokeMeasure()
     m_d->numTickets = 0;
     m_d->numUpdates = 0;
     m_d->mousePath = 0;
+    m_d->guiEventsTime = 0;
+    m_d->numGuiEvents = 0;
 
     m_d->lastMousePos = QPointF();
     m_d->preset = 0;
@@ -178,6 +185,16 @@ void KisUpdateTimeMonitor::reportMouseMove(const QPointF &pos)
     m_d->lastMousePos = pos;
 }
 
+void KisUpdateTimeMonitor::reportGuiEventTime(qint64 nsecs)
+{
+    if (!m_d->loggingEnabled) return;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    m_d->guiEventsTime += nsecs;
+    m_d->numGuiEvents++;
+}
+
 void KisUpdateTimeMonitor::printValues()
 {
     qint64 strokeTime = m_d->strokeTime.elapsed();
@@ -185,6 +202,8 @@ void KisUpdateTimeMonitor::printValues()
     qreal nonUpdateTime = qreal(m_d->jobsTime) / m_d->numTickets;
     qreal jobsPerUpdate = qreal(m_d->numTickets) / m_d->numUpdates;    
     qreal mouseSpeed = qreal(m_d->mousePath) / strokeTime;
+    qreal guiEventTime = m_d->numGuiEvents ?
+        qreal(m_d->guiEventsTime) / m_d->numGuiEvents / 1000000.0 : 0.0;
 
     QString prefix;
 
@@ -203,6 +222,7 @@ void KisUpdateTimeMonitor::printValues()
            << i18n("Mouse Speed:") << QString::number( mouseSpeed, 'f', 3 ) << "\t"
            << i18n("Jobs/Update:") << QString::number( jobsPerUpdate, 'f', 3 ) << "\t"
            << i18n("Non Update Time:") << QString::number( nonUpdateTime, 'f', 3 ) << "\t"
+           << i18n("GUI Time/Event:") << QString::number( guiEventTime, 'f', 3 ) << "\t"
            << i18n("Response Time:") << responseTime << endl; // 'endl' will use the correct OS line ending
     logFile.close();
 }
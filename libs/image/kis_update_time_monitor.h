@@ -40,6 +40,12 @@ public:
     void reportPaintOpPreset(KisPaintOpPresetSP preset);
 
     void reportMouseMove(const QPointF &pos);
+
+    /**
+     * Reports the time (in nanoseconds) the GUI thread has spent
+     * on handling a single input event of the stroke
+     */
+    void reportGuiEventTime(qint64 nsecs);
     void printValues();
 
     void reportJobStarted(void *key);
@@ -19,6 +19,8 @@
 #include "kis_layer_style_filter_environment.h"
 
 #include <QBitArray>
+#include <QMutex>
+#include <QMutexLocker>
 
 #include "kis_layer.h"
 #include "kis_ls_utils.h"
@@ -36,11 +38,32 @@
 #include "kis_pixel_selection.h"
 
 
+namespace {
+
+struct AlphaSelectionCacheEntry {
+    KisPaintDeviceSP device;
+    QRect rect;
+
+    /**
+     * Generated by the first effect that asks for it,
+     * guarded by \p lock
+     */
+    QMutex lock;
+    KisSelectionSP selection;
+};
+
+typedef QSharedPointer<AlphaSelectionCacheEntry> AlphaSelectionCacheEntrySP;
+
+}
+
 struct Q_DECL_HIDDEN KisLayerStyleFilterEnvironment::Private
 {
     KisLayer *sourceLayer;
     KisPixelSelectionSP cachedRandomSelection;
 
+    QMutex alphaSelectionLock;
+    QList<AlphaSelectionCacheEntrySP> alphaSelections;
+
     static KisPixelSelectionSP generateRandomSelection(const QRect &rc);
 };
 
@@ -150,3 +173,68 @@ KisPixelSelectionSP KisLayerStyleFilterEnvironment::cachedRandomSelection(const
 
     return m_d->cachedRandomSelection;
 }
+
+void KisLayerStyleFilterEnvironment::prepareAlphaSelection(KisPaintDeviceSP device, const QRect &rect)
+{
+    if (rect.isEmpty()) return;
+
+    AlphaSelectionCacheEntrySP entry(new AlphaSelectionCacheEntry());
+    entry->device = device;
+    entry->rect = rect;
+
+    QMutexLocker l(&m_d->alphaSelectionLock);
+    m_d->alphaSelections.append(entry);
+}
+
+void KisLayerStyleFilterEnvironment::releaseAlphaSelection(KisPaintDeviceSP device, const QRect &rect)
+{
+    QMutexLocker l(&m_d->alphaSelectionLock);
+
+    for (auto it = m_d->alphaSelections.begin(); it != m_d->alphaSelections.end(); ++it) {
+        if ((*it)->device == device && (*it)->rect == rect) {
+            m_d->alphaSelections.erase(it);
+            break;
+        }
+    }
+}
+
+KisSelectionSP KisLayerStyleFilterEnvironment::alphaSelection(KisPaintDeviceSP device, const QRect &srcRect) const
+{
+    AlphaSelectionCacheEntrySP entry;
+
+    {
+        QMutexLocker l(&m_d->alphaSelectionLock);
+
+        Q_FOREACH (AlphaSelectionCacheEntrySP e, m_d->alphaSelections) {
+            if (e->device == device && e->rect.contains(srcRect)) {
+                entry = e;
+                break;
+            }
+        }
+    }
+
+    if (!entry) {
+        return KisLsUtils::selectionFromAlphaChannel(device, srcRect);
+    }
+
+    KisSelectionSP cachedSelection;
+
+    {
+        QMutexLocker l(&entry->lock);
+
+        if (!entry->selection) {
+            entry->selection = KisLsUtils::selectionFromAlphaChannel(device, entry->rect);
+        }
+        cachedSelection = entry->selection;
+    }
+
+    /**
+     * The effects blur and grow the selection, so the pixels
+     * outside the requested rect should be reset to make the
+     * result exactly the same as of a freshly generated one
+     */
+    KisSelectionSP selection = new KisSelection(*cachedSelection);
+    selection->pixelSelection()->crop(srcRect);
+
+    return selection;
+}
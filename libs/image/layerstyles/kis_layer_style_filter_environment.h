@@ -20,6 +20,7 @@
 #define __KIS_LAYER_STYLE_FILTER_ENVIRONMENT_H
 
 #include <QScopedPointer>
+#include <QSharedPointer>
 #include <QRect>
 
 #include <kritaimage_export.h>
@@ -49,9 +50,35 @@ public:
 
     KisPixelSelectionSP cachedRandomSelection(const QRect &requestedRect) const;
 
+    /**
+     * Most of the effects of the style start with converting the alpha
+     * channel of the layer into a selection. The projection plane of the
+     * style registers the union of the rects the effects need, and the
+     * selection is converted once, when the first effect fetches its copy
+     * with alphaSelection(). If no enabled effect needs it, nothing is
+     * converted at all.
+     *
+     * Several update jobs may recalculate the layer at the same time, so
+     * every prepareAlphaSelection() should be paired with a call to
+     * releaseAlphaSelection() with the same arguments.
+     */
+    void prepareAlphaSelection(KisPaintDeviceSP device, const QRect &rect);
+    void releaseAlphaSelection(KisPaintDeviceSP device, const QRect &rect);
+
+    /**
+     * @return the alpha channel of \p device in \p srcRect converted into a
+     * selection. The selection is copied (copy-on-write) from the prepared
+     * one if it covers \p srcRect (the prepared one is generated on the
+     * first request), otherwise it is generated from scratch.
+     * The caller may modify the returned selection.
+     */
+    KisSelectionSP alphaSelection(KisPaintDeviceSP device, const QRect &srcRect) const;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
 };
 
+typedef QSharedPointer<KisLayerStyleFilterEnvironment> KisLayerStyleFilterEnvironmentSP;
+
 #endif /* __KIS_LAYER_STYLE_FILTER_ENVIRONMENT_H */
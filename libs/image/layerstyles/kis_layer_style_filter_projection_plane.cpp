@@ -18,6 +18,7 @@
 
 #include "kis_layer_style_filter_projection_plane.h"
 
+#include "kis_global.h"
 #include "filter/kis_filter.h"
 #include "filter/kis_filter_configuration.h"
 #include "filter/kis_filter_registry.h"
@@ -36,7 +37,7 @@ struct KisLayerStyleFilterProjectionPlane::Private
 
     QScopedPointer<KisLayerStyleFilter> filter;
     KisPSDLayerStyleSP style;
-    QScopedPointer<KisLayerStyleFilterEnvironment> environment;
+    KisLayerStyleFilterEnvironmentSP environment;
 
     KisMultipleProjection projection;
 };
@@ -47,7 +48,18 @@ KisLayerStyleFilterProjectionPlane(KisLayer *sourceLayer)
 {
     Q_ASSERT(sourceLayer);
     m_d->sourceLayer = sourceLayer;
-    m_d->environment.reset(new KisLayerStyleFilterEnvironment(sourceLayer));
+    m_d->environment = toQShared(new KisLayerStyleFilterEnvironment(sourceLayer));
+}
+
+KisLayerStyleFilterProjectionPlane::
+KisLayerStyleFilterProjectionPlane(KisLayer *sourceLayer,
+                                   KisLayerStyleFilterEnvironmentSP environment)
+    : m_d(new Private)
+{
+    Q_ASSERT(sourceLayer);
+    Q_ASSERT(environment);
+    m_d->sourceLayer = sourceLayer;
+    m_d->environment = environment;
 }
 
 KisLayerStyleFilterProjectionPlane::~KisLayerStyleFilterProjectionPlane()
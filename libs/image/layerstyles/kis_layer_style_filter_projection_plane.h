@@ -24,12 +24,20 @@
 #include <QScopedPointer>
 
 #include "kis_types.h"
+#include "kis_layer_style_filter_environment.h"
 
 
 class KisLayerStyleFilterProjectionPlane : public KisAbstractProjectionPlane
 {
 public:
     KisLayerStyleFilterProjectionPlane(KisLayer *sourceLayer);
+
+    /**
+     * The planes of all the effects of a style share one environment,
+     * so that the data cached in it is reused by all of them
+     */
+    KisLayerStyleFilterProjectionPlane(KisLayer *sourceLayer,
+                                       KisLayerStyleFilterEnvironmentSP environment);
     ~KisLayerStyleFilterProjectionPlane() override;
 
     void setStyle(KisLayerStyleFilter *filter, KisPSDLayerStyleSP style);
@@ -20,6 +20,7 @@
 
 #include "kis_global.h"
 #include "kis_layer_style_filter_projection_plane.h"
+#include "kis_layer_style_filter_environment.h"
 #include "kis_psd_layer_style.h"
 
 #include "kis_ls_drop_shadow_filter.h"
@@ -31,7 +32,9 @@
 
 struct Q_DECL_HIDDEN KisLayerStyleProjectionPlane::Private
 {
+    KisLayer *sourceLayer;
     KisAbstractProjectionPlaneWSP sourceProjectionPlane;
+    KisLayerStyleFilterEnvironmentSP environment;
 
     QVector<KisAbstractProjectionPlaneSP> stylesBefore;
     QVector<KisAbstractProjectionPlaneSP> stylesAfter;
@@ -61,75 +64,77 @@ KisLayerStyleProjectionPlane::KisLayerStyleProjectionPlane(KisLayer *sourceLayer
 void KisLayerStyleProjectionPlane::init(KisLayer *sourceLayer, KisPSDLayerStyleSP style)
 {
     Q_ASSERT(sourceLayer);
+    m_d->sourceLayer = sourceLayer;
     m_d->sourceProjectionPlane = sourceLayer->internalProjectionPlane();
+    m_d->environment = toQShared(new KisLayerStyleFilterEnvironment(sourceLayer));
     m_d->style = style;
 
     {
         KisLayerStyleFilterProjectionPlane *dropShadow =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         dropShadow->setStyle(new KisLsDropShadowFilter(KisLsDropShadowFilter::DropShadow), style);
         m_d->stylesBefore << toQShared(dropShadow);
     }
 
     {
         KisLayerStyleFilterProjectionPlane *innerShadow =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         innerShadow->setStyle(new KisLsDropShadowFilter(KisLsDropShadowFilter::InnerShadow), style);
         m_d->stylesAfter << toQShared(innerShadow);
     }
 
     {
         KisLayerStyleFilterProjectionPlane *outerGlow =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         outerGlow->setStyle(new KisLsDropShadowFilter(KisLsDropShadowFilter::OuterGlow), style);
         m_d->stylesAfter << toQShared(outerGlow);
     }
 
     {
         KisLayerStyleFilterProjectionPlane *innerGlow =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         innerGlow->setStyle(new KisLsDropShadowFilter(KisLsDropShadowFilter::InnerGlow), style);
         m_d->stylesAfter << toQShared(innerGlow);
     }
 
     {
         KisLayerStyleFilterProjectionPlane *satin =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         satin->setStyle(new KisLsSatinFilter(), style);
         m_d->stylesAfter << toQShared(satin);
     }
 
     {
         KisLayerStyleFilterProjectionPlane *colorOverlay =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         colorOverlay->setStyle(new KisLsOverlayFilter(KisLsOverlayFilter::Color), style);
         m_d->stylesAfter << toQShared(colorOverlay);
     }
 
     {
         KisLayerStyleFilterProjectionPlane *gradientOverlay =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         gradientOverlay->setStyle(new KisLsOverlayFilter(KisLsOverlayFilter::Gradient), style);
         m_d->stylesAfter << toQShared(gradientOverlay);
     }
 
     {
         KisLayerStyleFilterProjectionPlane *patternOverlay =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         patternOverlay->setStyle(new KisLsOverlayFilter(KisLsOverlayFilter::Pattern), style);
         m_d->stylesAfter << toQShared(patternOverlay);
     }
 
     {
         KisLayerStyleFilterProjectionPlane *stroke =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         stroke->setStyle(new KisLsStrokeFilter(), style);
         m_d->stylesAfter << toQShared(stroke);
     }
 
     {
         KisLayerStyleFilterProjectionPlane *bevelEmboss =
-            new KisLayerStyleFilterProjectionPlane(sourceLayer);
+            new KisLayerStyleFilterProjectionPlane(sourceLayer, m_d->environment);
         bevelEmboss->setStyle(new KisLsBevelEmbossFilter(), style);
         m_d->stylesAfter << toQShared(bevelEmboss);
     }
@@ -151,6 +156,25 @@ QRect KisLayerStyleProjectionPlane::recalculate(const QRect& rect, KisNodeSP fil
     QRect result = sourcePlane->recalculate(rect, filthyNode);
 
     if (m_d->style->isEnabled()) {
+        /**
+         * Convert the alpha channel of the layer into a selection only
+         * once, all the effects will take their copies of it. The
+         * conversion happens on the first request, so the styles
+         * without shadows, glows, satin, stroke or bevel skip it.
+         */
+        QRect alphaSelectionRect;
+
+        Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesBefore) {
+            alphaSelectionRect |= plane->needRect(rect, KisLayer::N_ABOVE_FILTHY);
+        }
+
+        Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesAfter) {
+            alphaSelectionRect |= plane->needRect(rect, KisLayer::N_ABOVE_FILTHY);
+        }
+
+        KisPaintDeviceSP sourceDevice = m_d->sourceLayer->projection();
+        m_d->environment->prepareAlphaSelection(sourceDevice, alphaSelectionRect);
+
         Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesBefore) {
             plane->recalculate(rect, filthyNode);
         }
@@ -158,6 +182,8 @@ QRect KisLayerStyleProjectionPlane::recalculate(const QRect& rect, KisNodeSP fil
         Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesAfter) {
             plane->recalculate(rect, filthyNode);
         }
+
+        m_d->environment->releaseAlphaSelection(sourceDevice, alphaSelectionRect);
     }
 
     return result;
@@ -121,7 +121,7 @@ void applyDropShadow(KisPaintDeviceSP srcDevice,
     ShadowRectsData d(applyRect, context, shadow, ShadowRectsData::NEED_RECT);
 
     KisSelectionSP baseSelection =
-        KisLsUtils::selectionFromAlphaChannel(srcDevice, d.spreadNeedRect);
+        env->alphaSelection(srcDevice, d.spreadNeedRect);
 
     KisPixelSelectionSP selection = baseSelection->pixelSelection();
 
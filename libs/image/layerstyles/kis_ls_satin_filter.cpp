@@ -133,7 +133,7 @@ void applySatin(KisPaintDeviceSP srcDevice,
     SatinRectsData d(applyRect, context, config, SatinRectsData::NEED_RECT);
 
     KisSelectionSP baseSelection =
-        KisLsUtils::selectionFromAlphaChannel(srcDevice, d.blurNeedRect);
+        env->alphaSelection(srcDevice, d.blurNeedRect);
 
     KisPixelSelectionSP selection = baseSelection->pixelSelection();
 
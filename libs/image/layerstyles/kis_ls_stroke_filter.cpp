@@ -88,7 +88,7 @@ void KisLsStrokeFilter::applyStroke(KisPaintDeviceSP srcDevice,
                                          applyRect, 2 * config->size());
 
         KisSelectionSP knockOutSelection =
-            KisLsUtils::selectionFromAlphaChannel(srcDevice, applyRect);
+            env->alphaSelection(srcDevice, applyRect);
 
         // disabled intentionally, because it creates artifacts on smooth lines
         // KisLsUtils::findEdge(knockOutSelection->pixelSelection(), applyRect, true);
@@ -32,6 +32,7 @@
 #include "kis_adjustment_layer.h"
 #include "kis_filter_mask.h"
 #include "kis_selection.h"
+#include "kis_below_stack_cache.h"
 
 #include "filter/kis_filter.h"
 #include "filter/kis_filter_configuration.h"
@@ -287,5 +288,82 @@ void KisAsyncMergerTest::testSubgraphingWithoutUpdatingParent()
     }
 }
 
+    /*
+      +-----------+
+      |root       |
+      | paint 4   |
+      | paint 3   |  <-- painted on
+      | paint 2   |
+      | paint 1   |
+      +-----------+
+     */
+
+void KisAsyncMergerTest::testBelowStackCache()
+{
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, 128, 128, colorSpace, "below stack cache test");
+
+    QList<KisPaintLayerSP> layers;
+    const QColor colors[] = {Qt::white, Qt::red, Qt::green, Qt::blue};
+
+    for (int i = 0; i < 4; i++) {
+        KisPaintLayerSP layer = new KisPaintLayer(image, QString("paint%1").arg(i + 1), 160);
+        layer->paintDevice()->fill(QRect(i * 16, i * 16, 64, 64), KoColor(colors[i], colorSpace));
+        image->addNode(layer, image->rootLayer());
+        layers << layer;
+    }
+
+    image->rootLayer()->setBelowStackCacheEnabled(true);
+    image->initialRefreshGraph();
+
+    KisBelowStackCache *cache = image->rootLayer()->belowStackCache();
+    QVERIFY(cache);
+
+    const QRect cropRect(image->bounds());
+    const QRect dirtyRect(8, 8, 80, 80);
+
+    auto updateLayer = [&] (KisPaintLayerSP layer, const QColor &color) {
+        layer->paintDevice()->fill(dirtyRect, KoColor(color, colorSpace));
+
+        KisMergeWalker walker(cropRect);
+        KisAsyncMerger merger;
+        walker.collectRects(layer, dirtyRect);
+        merger.startMerge(walker);
+    };
+
+    auto referenceProjection = [&] () {
+        image->rootLayer()->setBelowStackCacheEnabled(false);
+
+        KisFullRefreshWalker walker(cropRect);
+        KisAsyncMerger merger;
+        walker.collectRects(image->rootLayer(), image->bounds());
+        merger.startMerge(walker);
+
+        image->rootLayer()->setBelowStackCacheEnabled(true);
+        return image->projection()->convertToQImage(0);
+    };
+
+    // the first update fills the cache, the second one fetches from it
+    updateLayer(layers[2], Qt::yellow);
+    QVERIFY(cache->tryFetch({layers[0].data(), layers[1].data()},
+                            new KisPaintDevice(colorSpace), dirtyRect));
+
+    updateLayer(layers[2], Qt::cyan);
+    QImage cachedResult = image->projection()->convertToQImage(0);
+    QCOMPARE(cachedResult, referenceProjection());
+
+    // the reference refresh has cleared the cache, so fill it again
+    updateLayer(layers[2], Qt::magenta);
+
+    // updating the layer below must drop the cached stack
+    updateLayer(layers[1], Qt::black);
+    QVERIFY(!cache->tryFetch({layers[0].data(), layers[1].data()},
+                             new KisPaintDevice(colorSpace), dirtyRect));
+
+    updateLayer(layers[2], Qt::gray);
+    cachedResult = image->projection()->convertToQImage(0);
+    QCOMPARE(cachedResult, referenceProjection());
+}
+
 QTEST_MAIN(KisAsyncMergerTest)
 
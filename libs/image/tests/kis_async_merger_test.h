@@ -30,6 +30,7 @@ private Q_SLOTS:
     void debugObligeChild();
     void testFullRefreshWithClones();
     void testSubgraphingWithoutUpdatingParent();
+    void testBelowStackCache();
 };
 
 #endif /* KIS_ASYNC_MERGER_TEST_H */
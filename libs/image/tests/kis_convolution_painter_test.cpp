@@ -437,4 +437,86 @@ void KisConvolutionPainterTest::testGaussianDetailsFFTW()
     testGaussianDetails(true);
 }
 
+void KisConvolutionPainterTest::testSeparableKernelDetection()
+{
+    QVector<qreal> rowWeights;
+    QVector<qreal> columnWeights;
+
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> gaussian =
+        KisGaussianKernel::createVerticalMatrix(3) *
+        KisGaussianKernel::createHorizontalMatrix(3);
+
+    KisConvolutionKernelSP kernel = KisConvolutionKernel::fromMatrix(gaussian, 0, 1.0);
+    QVERIFY(kernel->separate(&rowWeights, &columnWeights));
+    QCOMPARE(rowWeights.size(), int(kernel->width()));
+    QCOMPARE(columnWeights.size(), int(kernel->height()));
+
+    for (int r = 0; r < columnWeights.size(); r++) {
+        for (int c = 0; c < rowWeights.size(); c++) {
+            QVERIFY(qAbs(columnWeights[r] * rowWeights[c] - gaussian(r, c)) < 1e-9);
+        }
+    }
+
+    kernel = KisGaussianKernel::createVerticalKernel(3);
+    QVERIFY(kernel->separate(&rowWeights, &columnWeights));
+    QCOMPARE(rowWeights, QVector<qreal>(1, 1.0));
+
+    qreal offset = 0.0;
+    qreal factor = 1.0;
+
+    kernel = KisConvolutionKernel::fromMatrix(initSymmFilter(offset, factor), offset, factor);
+    QVERIFY(!kernel->separate(&rowWeights, &columnWeights));
+
+    kernel = KisConvolutionKernel::fromMatrix(initAsymmFilter(offset, factor), offset, factor);
+    QVERIFY(!kernel->separate(&rowWeights, &columnWeights));
+}
+
+void KisConvolutionPainterTest::testSeparableConvolution()
+{
+    QImage qimage(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
+
+    KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+    dev->convertFromQImage(qimage, 0, 0, 0);
+
+    const qreal radius = 5;
+    const QRect applyRect = dev->exactBounds();
+
+    // reference: two one-dimensional passes
+    KisPaintDeviceSP interm = new KisPaintDevice(dev->colorSpace());
+    KisPaintDeviceSP refDev = new KisPaintDevice(dev->colorSpace());
+
+    KisConvolutionPainter horizPainter(interm, KisConvolutionPainter::SPATIAL);
+    horizPainter.applyMatrix(KisGaussianKernel::createHorizontalKernel(radius), dev,
+                             applyRect.topLeft() - QPoint(0, radius),
+                             applyRect.topLeft() - QPoint(0, radius),
+                             applyRect.size() + QSize(0, 2 * radius),
+                             BORDER_REPEAT);
+
+    KisConvolutionPainter verticalPainter(refDev, KisConvolutionPainter::SPATIAL);
+    verticalPainter.applyMatrix(KisGaussianKernel::createVerticalKernel(radius), interm,
+                                applyRect.topLeft(), applyRect.topLeft(),
+                                applyRect.size(), BORDER_REPEAT);
+
+    // the two-dimensional kernel is applied in two passes internally
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> gaussian =
+        KisGaussianKernel::createVerticalMatrix(radius) *
+        KisGaussianKernel::createHorizontalMatrix(radius);
+
+    KisPaintDeviceSP resultDev = new KisPaintDevice(dev->colorSpace());
+    KisConvolutionPainter painter(resultDev, KisConvolutionPainter::SPATIAL);
+    painter.applyMatrix(KisConvolutionKernel::fromMatrix(gaussian, 0, gaussian.sum()), dev,
+                        applyRect.topLeft(), applyRect.topLeft(),
+                        applyRect.size(), BORDER_REPEAT);
+
+    QImage refImage = refDev->convertToQImage(0, applyRect.x(), applyRect.y(), applyRect.width(), applyRect.height());
+    QImage resultImage = resultDev->convertToQImage(0, applyRect.x(), applyRect.y(), applyRect.width(), applyRect.height());
+
+    // the reference rounds the intermediate result to 8 bits
+    QPoint errpoint;
+    if (!TestUtil::compareQImages(errpoint, refImage, resultImage, 1)) {
+        resultImage.save("separable_convolution.png");
+        QFAIL(QString("Separable convolution differs from two passes, first different pixel: %1,%2 ").arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+    }
+}
+
 QTEST_MAIN(KisConvolutionPainterTest)
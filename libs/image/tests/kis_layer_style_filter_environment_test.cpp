@@ -20,6 +20,8 @@
 
 #include "layerstyles/kis_layer_style_filter_environment.h"
 #include "kis_pixel_selection.h"
+#include "kis_selection.h"
+#include <KoColor.h>
 #include "testutil.h"
 
 
@@ -58,4 +60,39 @@ void KisLayerStyleFilterEnvironmentTest::benchmarkRandomSelectionGeneration()
     }
 }
 
+void KisLayerStyleFilterEnvironmentTest::testAlphaSelectionCaching()
+{
+    TestUtil::MaskParent p;
+    KisLayerStyleFilterEnvironment env(p.layer.data());
+
+    KisPaintDeviceSP dev = p.layer->paintDevice();
+    const KoColor color(Qt::red, dev->colorSpace());
+    dev->fill(QRect(30, 30, 100, 100), color);
+
+    const QRect preparedRect(0, 0, 200, 200);
+    const QRect requestedRect(20, 40, 60, 120);
+
+    env.prepareAlphaSelection(dev, preparedRect);
+
+    KisSelectionSP cached = env.alphaSelection(dev, requestedRect);
+
+    // nothing is prepared, so the selection is generated from scratch
+    KisLayerStyleFilterEnvironment referenceEnv(p.layer.data());
+    KisSelectionSP reference = referenceEnv.alphaSelection(dev, requestedRect);
+
+    QCOMPARE(cached->pixelSelection()->selectedExactRect(), QRect(30, 40, 50, 90));
+
+    QPoint errpoint;
+    if (!TestUtil::comparePaintDevices(errpoint, cached->pixelSelection(), reference->pixelSelection())) {
+        QFAIL(QString("The cached alpha selection differs at %1,%2").arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+    }
+
+    // the copies are independent from each other
+    cached->pixelSelection()->clear();
+    KisSelectionSP cached2 = env.alphaSelection(dev, requestedRect);
+    QCOMPARE(cached2->pixelSelection()->selectedExactRect(), QRect(30, 40, 50, 90));
+
+    env.releaseAlphaSelection(dev, preparedRect);
+}
+
 QTEST_MAIN(KisLayerStyleFilterEnvironmentTest)
@@ -25,6 +25,13 @@
 
 #include <QDomDocument>
 #include <QImage>
+#include <QtMath>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include "kis_fixed_paint_device.h"
+#include "kis_brush_mask_applicator_base.h"
 
 QImage createQImageFromMask(const KisMaskGenerator& generator)
 {
@@ -181,5 +188,81 @@ void KisMaskGeneratorTest::testCopyCtorGaussRect()
     testCopyCtor(&gen);
 }
 
+void testApplicator(KisMaskGenerator *gen)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    const int size = qCeil(qMax(gen->width(), gen->height())) + 4;
+    const QRect rect(0, 0, size, size);
+
+    KisFixedPaintDeviceSP dev = new KisFixedPaintDevice(cs);
+    dev->setRect(rect);
+    dev->initialize();
+    dev->fill(rect, KoColor(Qt::white, cs));
+
+    const qreal centerX = 0.5 * size;
+    const qreal centerY = 0.5 * size;
+
+    MaskProcessingData data(dev, cs, 0.0, 1.0, centerX, centerY, 0.0);
+
+    KisBrushMaskApplicatorBase *applicator = gen->applicator();
+    applicator->initializeData(&data);
+    applicator->process(rect);
+
+    /**
+     * The vectorized applicators calculate the mask in floating point,
+     * while the scalar version truncates the values to quint8 on every
+     * step, so allow small difference.
+     */
+    const int tolerance = 3;
+
+    const quint8 *ptr = dev->data();
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            const int expected = OPACITY_OPAQUE_U8 - gen->valueAt(x - centerX, y - centerY);
+            const int value = cs->opacityU8(ptr);
+            ptr += cs->pixelSize();
+
+            QVERIFY2(qAbs(value - expected) <= tolerance,
+                     QString("The applicator result differs from valueAt() at (%1, %2): %3 vs %4")
+                         .arg(x).arg(y).arg(value).arg(expected).toLatin1());
+        }
+    }
+}
+
+void KisMaskGeneratorTest::testApplicators()
+{
+    {
+        KisCircleMaskGenerator gen(47, 0.8, 0.4, 0.6, 2, true);
+        testApplicator(&gen);
+    }
+
+    {
+        KisRectangleMaskGenerator gen(47, 0.8, 0.4, 0.6, 2, true);
+        testApplicator(&gen);
+    }
+
+    {
+        KisGaussCircleMaskGenerator gen(47, 0.8, 0.4, 0.6, 2, true);
+        testApplicator(&gen);
+    }
+
+    {
+        KisGaussRectangleMaskGenerator gen(47, 0.8, 0.4, 0.6, 2, true);
+        testApplicator(&gen);
+    }
+
+    KisCubicCurve curve; // linear
+
+    {
+        KisCurveCircleMaskGenerator gen(47, 0.8, 0.4, 0.6, 2, curve, true);
+        testApplicator(&gen);
+    }
+
+    {
+        KisCurveRectangleMaskGenerator gen(47, 0.8, 0.4, 0.6, 2, curve, true);
+        testApplicator(&gen);
+    }
+}
 
 QTEST_MAIN(KisMaskGeneratorTest)
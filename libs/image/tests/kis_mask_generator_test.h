@@ -37,6 +37,8 @@ private Q_SLOTS:
 
     void testCopyCtorGaussCircle();
     void testCopyCtorGaussRect();
+
+    void testApplicators();
 };
 
 #endif
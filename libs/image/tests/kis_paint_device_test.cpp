@@ -288,6 +288,78 @@ void KisPaintDeviceTest::testColorSpaceConversion()
 }
 
 
+void KisPaintDeviceTest::testColorSpaceConversionSparse()
+{
+    const KoColorSpace* srcCs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace* dstCs = KoColorSpaceRegistry::instance()->rgb16();
+    KisPaintDeviceSP dev = new KisPaintDevice(srcCs);
+
+    dev->fill(QRect(0, 0, 100, 100), KoColor(Qt::red, srcCs));
+    dev->fill(QRect(3000, 3000, 100, 100), KoColor(Qt::blue, srcCs));
+
+    const QRegion srcRegion = dev->region();
+
+    KUndo2Command* cmd = dev->convertTo(dstCs);
+    QVERIFY(*dev->colorSpace() == *dstCs);
+
+    // the holes between the filled areas should not be allocated
+    QCOMPARE(dev->region(), srcRegion);
+
+    KoColor red(Qt::red, srcCs);
+    red.convertTo(dstCs);
+    KoColor blue(Qt::blue, srcCs);
+    blue.convertTo(dstCs);
+
+    KoColor pixel;
+    dev->pixel(50, 50, &pixel);
+    QCOMPARE(pixel, red);
+    dev->pixel(3050, 3050, &pixel);
+    QCOMPARE(pixel, blue);
+
+    QCOMPARE(dev->exactBounds(), QRect(0, 0, 3100, 3100));
+
+    cmd->undo();
+    QVERIFY(*dev->colorSpace() == *srcCs);
+    QCOMPARE(dev->region(), srcRegion);
+
+    delete cmd;
+}
+
+void KisPaintDeviceTest::testColorSpaceConversionParallel()
+{
+    const KoColorSpace* srcCs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace* dstCs = KoColorSpaceRegistry::instance()->lab16();
+    KisPaintDeviceSP dev = new KisPaintDevice(srcCs);
+
+    // big enough to be split between a few jobs
+    const QRect rc(0, 0, 2048, 2048);
+    dev->fill(rc, KoColor(Qt::red, srcCs));
+    dev->fill(QRect(1000, 100, 500, 1900), KoColor(Qt::blue, srcCs));
+
+    KisPaintDeviceSP ref = new KisPaintDevice(*dev);
+
+    KUndo2Command* cmd = dev->convertTo(dstCs);
+    QVERIFY(*dev->colorSpace() == *dstCs);
+
+    KisPaintDeviceSP converted = new KisPaintDevice(dstCs);
+    QVector<quint8> srcPixels(rc.width() * rc.height() * srcCs->pixelSize());
+    QVector<quint8> dstPixels(rc.width() * rc.height() * dstCs->pixelSize());
+    ref->readBytes(srcPixels.data(), rc);
+    srcCs->convertPixelsTo(srcPixels.constData(), dstPixels.data(), dstCs, rc.width() * rc.height(),
+                           KoColorConversionTransformation::internalRenderingIntent(),
+                           KoColorConversionTransformation::internalConversionFlags());
+    converted->writeBytes(dstPixels.constData(), rc);
+
+    QPoint pt;
+    QVERIFY(TestUtil::comparePaintDevices(pt, dev, converted));
+
+    cmd->undo();
+    QVERIFY(*dev->colorSpace() == *srcCs);
+    QVERIFY(TestUtil::comparePaintDevices(pt, dev, ref));
+
+    delete cmd;
+}
+
 void KisPaintDeviceTest::testRoundtripConversion()
 {
     QImage image(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
@@ -458,6 +530,83 @@ void KisPaintDeviceTest::testCaching()
     QCOMPARE(exactBounds4, QRect(50,50,50,50));
 }
 
+void KisPaintDeviceTest::testIncrementalThumbnail()
+{
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    /**
+     * The old path samples the nearest pixels, while the cache averages
+     * the blocks of pixels, so only the pixels lying on the edges of the
+     * shapes may differ noticeably
+     */
+    auto compareWithOldPath = [] (KisPaintDeviceSP dev, const QImage &thumb) {
+        const QImage reference = dev->createThumbnail(thumb.width(), thumb.height(), QRect(), 1);
+        QCOMPARE(reference.size(), thumb.size());
+
+        QPoint pt;
+        QVERIFY(TestUtil::compareQImages(pt, reference, thumb, 1, 1, thumb.width() * thumb.height() / 16));
+    };
+
+    dev->fill(QRect(0, 0, 1024, 512), KoColor(Qt::white, cs));
+    dev->fill(QRect(100, 100, 300, 200), KoColor(Qt::red, cs));
+
+    QImage thumb1 = dev->createThumbnail(128, 64);
+    QCOMPARE(thumb1.size(), QSize(128, 64));
+    compareWithOldPath(dev, thumb1);
+
+    // only a few tiles are updated in the cache
+    dev->fill(QRect(600, 50, 100, 100), KoColor(Qt::blue, cs));
+    QImage thumb2 = dev->createThumbnail(128, 64);
+
+    QVERIFY(thumb1 != thumb2);
+    compareWithOldPath(dev, thumb2);
+
+    // the copy of the device builds its thumbnail from scratch
+    KisPaintDeviceSP copy = new KisPaintDevice(*dev);
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, copy->createThumbnail(128, 64), thumb2));
+
+    // remove some tiles
+    dev->clear(QRect(0, 0, 512, 512));
+    QImage thumb3 = dev->createThumbnail(128, 64);
+
+    copy = new KisPaintDevice(*dev);
+    QVERIFY(TestUtil::compareQImages(pt, copy->createThumbnail(128, 64), thumb3));
+    compareWithOldPath(dev, thumb3);
+
+    // smaller thumbnails are served from the same level
+    QImage thumb4 = dev->createThumbnail(32, 16);
+    QCOMPARE(thumb4.size(), QSize(32, 16));
+    QVERIFY(TestUtil::compareQImages(pt, copy->createThumbnail(32, 16), thumb4));
+    compareWithOldPath(dev, thumb4);
+
+    // moving the device keeps the levels
+    dev->moveTo(QPoint(64, -128));
+    copy = new KisPaintDevice(*dev);
+    QVERIFY(TestUtil::compareQImages(pt, dev->createThumbnail(128, 64), copy->createThumbnail(128, 64)));
+    compareWithOldPath(dev, dev->createThumbnail(128, 64));
+    dev->moveTo(QPoint(0, 0));
+
+    // undoing a conversion brings back the old data manager
+    KUndo2Command *cmd = dev->convertTo(KoColorSpaceRegistry::instance()->rgb16());
+    QImage thumb5 = dev->createThumbnail(128, 64);
+    QVERIFY(TestUtil::compareQImages(pt, thumb5, thumb3, 1));
+    compareWithOldPath(dev, thumb5);
+
+    dev->fill(QRect(600, 300, 100, 100), KoColor(Qt::green, dev->colorSpace()));
+    dev->createThumbnail(128, 64);
+
+    cmd->undo();
+    QVERIFY(*dev->colorSpace() == *cs);
+    QVERIFY(TestUtil::compareQImages(pt, dev->createThumbnail(128, 64), thumb3));
+
+    cmd->redo();
+    copy = new KisPaintDevice(*dev);
+    QVERIFY(TestUtil::compareQImages(pt, dev->createThumbnail(128, 64), copy->createThumbnail(128, 64)));
+    delete cmd;
+}
+
 void KisPaintDeviceTest::testRegion()
 {
     const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
@@ -824,6 +973,74 @@ void KisPaintDeviceTest::testExactBoundsNonTransparent()
     QCOMPARE(dev->nonDefaultPixelArea(), QRect(-1,-1,1002,1002));
 }
 
+void KisPaintDeviceTest::testExactBoundsIncremental()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    auto checkBounds = [dev] () {
+        QCOMPARE(dev->exactBounds(), dev->calculateExactBounds(false));
+        QCOMPARE(dev->nonDefaultPixelArea(), dev->calculateExactBounds(true));
+    };
+
+    dev->fill(QRect(10, 10, 1000, 1000), KoColor(Qt::white, cs));
+    QCOMPARE(dev->exactBounds(), QRect(10, 10, 1000, 1000));
+    checkBounds();
+
+    // only the changed tiles are rescanned
+    dev->fill(QRect(1500, 1700, 3, 5), KoColor(Qt::red, cs));
+    QCOMPARE(dev->exactBounds(), QRect(10, 10, 1493, 1695));
+    checkBounds();
+
+    dev->clear(QRect(1500, 1700, 3, 5));
+    QCOMPARE(dev->exactBounds(), QRect(10, 10, 1000, 1000));
+    checkBounds();
+
+    dev->clear(QRect(0, 0, 500, 1100));
+    QCOMPARE(dev->exactBounds(), QRect(500, 10, 510, 1000));
+    checkBounds();
+
+    // transparent pixels with non-default color
+    const quint8 weirdPixelData[4] = {0,10,0,0};
+    dev->setPixel(1200, 1200, KoColor(weirdPixelData, cs));
+    QCOMPARE(dev->exactBounds(), QRect(500, 10, 510, 1000));
+    QCOMPARE(dev->nonDefaultPixelArea(), QRect(500, 10, 701, 1191));
+    checkBounds();
+
+    dev->moveTo(QPoint(-33, 17));
+    QCOMPARE(dev->exactBounds(), QRect(467, 27, 510, 1000));
+    checkBounds();
+
+    // the bounds of the moved tiles are still tracked
+    dev->fill(QRect(1100, 40, 10, 10), KoColor(Qt::red, cs));
+    QCOMPARE(dev->exactBounds(), QRect(467, 27, 643, 1000));
+    checkBounds();
+
+    dev->moveTo(QPoint(0, 0));
+    QCOMPARE(dev->exactBounds(), QRect(500, 10, 643, 1000));
+    checkBounds();
+
+    // the inner tiles are not scanned until the bounds shrink to them
+    dev->clear();
+    dev->fill(QRect(0, 0, 1024, 1024), KoColor(Qt::white, cs));
+    QCOMPARE(dev->exactBounds(), QRect(0, 0, 1024, 1024));
+    checkBounds();
+
+    dev->clear(QRect(0, 0, 1024, 300));
+    dev->clear(QRect(0, 700, 1024, 324));
+    dev->clear(QRect(0, 300, 300, 400));
+    dev->clear(QRect(700, 300, 324, 400));
+    QCOMPARE(dev->exactBounds(), QRect(300, 300, 400, 400));
+    checkBounds();
+
+    dev->setDefaultPixel(KoColor(Qt::white, cs));
+    checkBounds();
+
+    dev->clear();
+    QVERIFY(dev->nonDefaultPixelArea().isEmpty());
+    checkBounds();
+}
+
 KisPaintDeviceSP createWrapAroundPaintDevice(const KoColorSpace *cs)
 {
     struct TestingDefaultBounds : public KisDefaultBoundsBase {
@@ -2182,6 +2399,70 @@ void KisPaintDeviceTest::testCopyPaintDeviceWithFrames()
     QVERIFY(channel->keyframeAt(10));
 }
 
+void KisPaintDeviceTest::testDeduplicateFrames()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    TestUtil::TestingTimedDefaultBounds *bounds = new TestUtil::TestingTimedDefaultBounds();
+    dev->setDefaultBounds(bounds);
+
+    KisRasterKeyframeChannel *channel = dev->createKeyframeChannel(KisKeyframeChannel::Content);
+    QVERIFY(channel);
+
+    KisPaintDeviceFramesInterface *i = dev->framesInterface();
+    QVERIFY(i);
+
+    channel->addKeyframe(10);
+    channel->addKeyframe(20);
+
+    const int frame0 = channel->frameIdAt(0);
+    const int frame10 = channel->frameIdAt(10);
+    const int frame20 = channel->frameIdAt(20);
+
+    // frames 0 and 10 have the same content, frame 20 differs
+    const QRect rc(0, 0, 128, 64);
+
+    bounds->testingSetTime(0);
+    dev->fill(rc, KoColor(Qt::red, cs));
+
+    bounds->testingSetTime(10);
+    dev->fill(rc, KoColor(Qt::red, cs));
+
+    bounds->testingSetTime(20);
+    dev->fill(rc, KoColor(Qt::green, cs));
+
+    KisDataManagerSP dm0 = i->frameDataManager(frame0);
+    KisDataManagerSP dm10 = i->frameDataManager(frame10);
+    KisDataManagerSP dm20 = i->frameDataManager(frame20);
+
+    QVERIFY(dm0->getTile(0, 0, false)->tileData() != dm10->getTile(0, 0, false)->tileData());
+
+    i->deduplicateFrames();
+
+    for (int col = 0; col < 2; col++) {
+        QVERIFY(dm0->getTile(col, 0, false)->tileData() == dm10->getTile(col, 0, false)->tileData());
+        QVERIFY(dm0->getTile(col, 0, false)->tileData() != dm20->getTile(col, 0, false)->tileData());
+    }
+
+    // the shared tiles are copied on write
+    bounds->testingSetTime(10);
+    dev->fill(QRect(0, 0, 10, 10), KoColor(Qt::blue, cs));
+
+    QVERIFY(dm0->getTile(0, 0, false)->tileData() != dm10->getTile(0, 0, false)->tileData());
+    QVERIFY(dm0->getTile(1, 0, false)->tileData() == dm10->getTile(1, 0, false)->tileData());
+
+    QCOMPARE(i->frameBounds(frame0), rc);
+    QCOMPARE(i->frameBounds(frame10), rc);
+
+    bounds->testingSetTime(0);
+    QCOMPARE(dev->exactBounds(), rc);
+
+    KoColor pixel(cs);
+    dev->pixel(5, 5, &pixel);
+    QCOMPARE(pixel, KoColor(Qt::red, cs));
+}
+
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/variance.hpp>
@@ -35,6 +35,7 @@ private Q_SLOTS:
     void testThumbnail();
     void testThumbnailDeviceWithOffset();
     void testCaching();
+    void testIncrementalThumbnail();
     void testRegion();
     void testPixel();
     void testRoundtripReadWrite();
@@ -44,6 +45,8 @@ private Q_SLOTS:
     void testMakeClone();
     void testBltPerformance();
     void testColorSpaceConversion();
+    void testColorSpaceConversionSparse();
+    void testColorSpaceConversionParallel();
     void testDeviceDuplication();
     void testTranslate();
     void testOpacity();
@@ -52,6 +55,7 @@ private Q_SLOTS:
     void testAmortizedExactBounds();
     void testNonDefaultPixelArea();
     void testExactBoundsNonTransparent();
+    void testExactBoundsIncremental();
 
     void testReadBytesWrapAround();
     void testWrappedRandomAccessor();
@@ -77,6 +81,7 @@ private Q_SLOTS:
     void testCrossDeviceFrameCopyChannel();
     void testLazyFrameCreation();
     void testCopyPaintDeviceWithFrames();
+    void testDeduplicateFrames();
 
     void testCompositionAssociativity();
 };
@@ -0,0 +1,134 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_sliding_histogram_test.h"
+
+#include <QTest>
+
+#include <algorithm>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_debug.h"
+#include "kis_paint_device.h"
+#include "kis_sliding_histogram.h"
+
+
+namespace {
+
+/**
+ * The median of the window, the lower one for even pixel counts
+ */
+struct MedianHistogram
+{
+    MedianHistogram() : counts(256), total(0) {}
+
+    int sampleSize() const { return 1; }
+    void sample(const quint8 *pixel, float *sample) { *sample = *pixel; }
+
+    void reset() { counts.fill(0); total = 0; }
+    void addSample(const float *sample) { counts[int(*sample)]++; total++; }
+    void removeSample(const float *sample) { counts[int(*sample)]--; total--; }
+
+    void writeResult(quint8 *dst) {
+        int accumulated = 0;
+        for (int i = 0; i < counts.size(); i++) {
+            accumulated += counts[i];
+            if (2 * accumulated >= total) {
+                *dst = i;
+                return;
+            }
+        }
+        *dst = 0;
+    }
+
+    QVector<int> counts;
+    int total;
+};
+
+quint8 bruteForceMedian(const QVector<quint8> &pixels, const QRect &rc,
+                        const QRect &sourceBounds, int x, int y, int radius)
+{
+    const QRect window =
+        QRect(x - radius, y - radius, 2 * radius + 1, 2 * radius + 1) & sourceBounds;
+
+    QVector<quint8> values;
+    for (int j = window.top(); j <= window.bottom(); j++) {
+        for (int i = window.left(); i <= window.right(); i++) {
+            values << pixels[(j - rc.top()) * rc.width() + (i - rc.left())];
+        }
+    }
+
+    std::sort(values.begin(), values.end());
+    return values[(values.size() - 1) / 2];
+}
+
+}
+
+void KisSlidingHistogramTest::testMedian_data()
+{
+    QTest::addColumn<QRect>("applyRect");
+    QTest::addColumn<QRect>("sourceBounds");
+    QTest::addColumn<int>("radius");
+
+    QTest::newRow("unclipped") << QRect(10, 10, 100, 90) << QRect(0, 0, 200, 200) << 3;
+    QTest::newRow("clipped") << QRect(0, 0, 200, 200) << QRect(0, 0, 200, 200) << 5;
+    QTest::newRow("negative") << QRect(-70, -30, 150, 140) << QRect(-100, -100, 200, 200) << 4;
+    QTest::newRow("radius-0") << QRect(5, 5, 70, 70) << QRect(0, 0, 200, 200) << 0;
+}
+
+void KisSlidingHistogramTest::testMedian()
+{
+    QFETCH(QRect, applyRect);
+    QFETCH(QRect, sourceBounds);
+    QFETCH(int, radius);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->alpha8();
+
+    QVector<quint8> pixels(sourceBounds.width() * sourceBounds.height());
+    for (int i = 0; i < pixels.size(); i++) {
+        pixels[i] = (i * 7919 + (i / 13) * 31) % 256;
+    }
+
+    KisPaintDeviceSP src = new KisPaintDevice(cs);
+    src->writeBytes(pixels.constData(), sourceBounds);
+
+    KisPaintDeviceSP dst = new KisPaintDevice(cs);
+
+    KisSlidingHistogram::apply(src, dst, applyRect, sourceBounds, radius,
+                               MedianHistogram(), 0);
+
+    QVector<quint8> result(applyRect.width() * applyRect.height());
+    dst->readBytes(result.data(), applyRect);
+
+    for (int y = applyRect.top(); y <= applyRect.bottom(); y++) {
+        for (int x = applyRect.left(); x <= applyRect.right(); x++) {
+            const quint8 value =
+                result[(y - applyRect.top()) * applyRect.width() + (x - applyRect.left())];
+
+            const quint8 expected =
+                bruteForceMedian(pixels, sourceBounds, sourceBounds, x, y, radius);
+
+            if (value != expected) {
+                qDebug() << "Failed at" << x << y << ppVar(value) << ppVar(expected);
+                QFAIL("the median differs from the brute force one");
+            }
+        }
+    }
+}
+
+QTEST_MAIN(KisSlidingHistogramTest)
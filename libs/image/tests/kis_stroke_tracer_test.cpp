@@ -0,0 +1,150 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_stroke_tracer_test.h"
+
+#include <QTest>
+#include <QBuffer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtConcurrent>
+
+#include "kis_stroke_tracer.h"
+
+
+void KisStrokeTracerTest::testDisabled()
+{
+    KisStrokeTracer tracer;
+    tracer.setEnabled(false);
+
+    tracer.reportJob(KisStrokeTracer::MERGE, "", "node", QRect(0,0,10,10), 0, 0, 10);
+    QVERIFY(tracer.events().isEmpty());
+}
+
+void KisStrokeTracerTest::testMultithreadedRecording()
+{
+    KisStrokeTracer tracer;
+    tracer.setEnabled(true);
+
+    const int numJobs = 64;
+    const int eventsPerJob = 200; // fits the ring buffer even in a single thread
+
+    QVector<int> jobs;
+    for (int i = 0; i < numJobs; i++) {
+        jobs << i;
+    }
+
+    QtConcurrent::blockingMap(jobs, [&tracer, eventsPerJob] (int job) {
+        for (int i = 0; i < eventsPerJob; i++) {
+            const qint64 start = tracer.currentTime();
+            tracer.reportJob(KisStrokeTracer::STROKE, "test-stroke", QString(),
+                             QRect(job, i, 1, 1), 1, start, tracer.currentTime());
+        }
+    });
+
+    QVector<KisStrokeTracer::Event> events = tracer.events();
+    QCOMPARE(events.size(), numJobs * eventsPerJob);
+
+    Q_FOREACH (const KisStrokeTracer::Event &event, events) {
+        QCOMPARE(event.type, KisStrokeTracer::STROKE);
+        QCOMPARE(event.name, QString("test-stroke"));
+        QCOMPARE(event.levelOfDetail, 1);
+        QVERIFY(event.threadId >= 0);
+        QVERIFY(event.endTime >= event.startTime);
+    }
+
+    tracer.clear();
+    QVERIFY(tracer.events().isEmpty());
+}
+
+void KisStrokeTracerTest::testRingBuffer()
+{
+    KisStrokeTracer tracer;
+    tracer.setEnabled(true);
+
+    const int numEvents = KisStrokeTracer::MaxEventsPerThread + 10;
+
+    for (int i = 0; i < numEvents; i++) {
+        tracer.reportJob(KisStrokeTracer::MERGE, "", "node", QRect(i, 0, 1, 1), 0, i, i + 1);
+    }
+
+    QVector<KisStrokeTracer::Event> events = tracer.events();
+    QCOMPARE(events.size(), int(KisStrokeTracer::MaxEventsPerThread));
+
+    // the oldest events are dropped, the order is preserved
+    QCOMPARE(events.first().startTime, qint64(10));
+    QCOMPARE(events.last().startTime, qint64(numEvents - 1));
+
+    for (int i = 1; i < events.size(); i++) {
+        QVERIFY(events[i].startTime > events[i - 1].startTime);
+    }
+
+    tracer.clear();
+    QVERIFY(tracer.events().isEmpty());
+
+    tracer.reportJob(KisStrokeTracer::MERGE, "", "node", QRect(), 0, 100, 200);
+    QCOMPARE(tracer.events().size(), 1);
+}
+
+void KisStrokeTracerTest::testChromeTraceExport()
+{
+    KisStrokeTracer tracer;
+    tracer.setEnabled(true);
+
+    tracer.reportJob(KisStrokeTracer::MERGE, "", "Layer 1", QRect(10,20,30,40), 2, 1000, 3000);
+    tracer.reportJob(KisStrokeTracer::STROKE, "freehand", "", QRect(), 0, 3000, 5000);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(tracer.writeChromeTrace(&buffer));
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(buffer.data(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+
+    QJsonArray traceEvents = doc.object()["traceEvents"].toArray();
+
+    int numMetadata = 0;
+    QJsonObject mergeEvent;
+    QJsonObject strokeEvent;
+
+    Q_FOREACH (const QJsonValue &value, traceEvents) {
+        QJsonObject object = value.toObject();
+
+        if (object["ph"].toString() == "M") {
+            numMetadata++;
+        } else if (object["cat"].toString() == "merge") {
+            mergeEvent = object;
+        } else if (object["cat"].toString() == "stroke") {
+            strokeEvent = object;
+        }
+    }
+
+    QCOMPARE(numMetadata, 1);
+
+    QCOMPARE(mergeEvent["name"].toString(), QString("merge"));
+    QCOMPARE(mergeEvent["ph"].toString(), QString("X"));
+    QCOMPARE(mergeEvent["ts"].toDouble(), 1.0);
+    QCOMPARE(mergeEvent["dur"].toDouble(), 2.0);
+    QCOMPARE(mergeEvent["args"].toObject()["node"].toString(), QString("Layer 1"));
+    QCOMPARE(mergeEvent["args"].toObject()["lod"].toInt(), 2);
+    QCOMPARE(mergeEvent["args"].toObject()["rect"].toString(), QString("10,20 30x40"));
+
+    QCOMPARE(strokeEvent["name"].toString(), QString("freehand"));
+}
+
+QTEST_MAIN(KisStrokeTracerTest)
@@ -54,7 +54,10 @@ protected:
         tile->lockForRead();
     }
     inline void unlockTile(KisTileSP &tile) {
-        tile->unlock();
+        if (m_writable)
+            tile->unlockForWrite();
+        else
+            tile->unlock();
     }
 
     inline quint32 xToCol(quint32 x) const {
@@ -73,15 +73,47 @@
 
 #define namedTransactionInProgress() ((bool)m_currentMemento)
 
+namespace {
+
+/**
+ * Every memento manager counts the revisions of its tiles in its own
+ * range, so a revision taken from one data manager is never mistaken
+ * for a revision of another one, e.g. of the data manager that has
+ * replaced it. Only the start of the range is taken from the global
+ * counter, once per manager. Since the tiles are stamped lazily (see
+ * KisTile::unlockForWrite()), 2^32 revisions per manager are more than
+ * enough.
+ */
+QAtomicInteger<qint64> s_lastRevisionRange(0);
+const int revisionRangeBits = 32;
+
+qint64 newRevisionRange()
+{
+    return (s_lastRevisionRange.fetchAndAddOrdered(1) + 1) << revisionRangeBits;
+}
+
+/**
+ * The log of removed tiles is limited, when it overflows, the
+ * oldest half of it is dropped and the changes made before that
+ * cannot be tracked anymore
+ */
+const int maxLoggedRemovedTiles = 4096;
+
+}
+
 KisMementoManager::KisMementoManager()
     : m_index(0),
       m_headsHashTable(0),
-      m_registrationBlocked(false)
+      m_registrationBlocked(false),
+      m_lastTileRevision(newRevisionRange())
 {
     /**
      * Tile change/delete registration is enabled for all
      * devices by default. It can't be delayed.
      */
+
+    m_oldestTrackedRevision = m_lastTileRevision.load();
+    m_observedTileRevision = m_oldestTrackedRevision;
 }
 
 KisMementoManager::KisMementoManager(const KisMementoManager& rhs)
@@ -90,8 +122,13 @@ KisMementoManager::KisMementoManager(const KisMementoManager& rhs)
         m_cancelledRevisions(rhs.m_cancelledRevisions),
         m_headsHashTable(rhs.m_headsHashTable, 0),
         m_currentMemento(rhs.m_currentMemento),
-        m_registrationBlocked(rhs.m_registrationBlocked)
+        m_registrationBlocked(rhs.m_registrationBlocked),
+        m_lastTileRevision(newRevisionRange())
 {
+    // the tiles of the copy are new, so there is nothing to track
+    m_oldestTrackedRevision = m_lastTileRevision.load();
+    m_observedTileRevision = m_oldestTrackedRevision;
+
     Q_ASSERT_X(!m_registrationBlocked,
                "KisMementoManager", "(impossible happened) "
                "The device has been copied while registration was blocked");
@@ -146,6 +183,23 @@ void KisMementoManager::registerTileChange(KisTile *tile)
 
 void KisMementoManager::registerTileDeleted(KisTile *tile)
 {
+    {
+        QMutexLocker l(&m_tileRevisionLock);
+
+        RemovedTile removedTile;
+        removedTile.revision = registerTileRevision();
+        removedTile.col = tile->col();
+        removedTile.row = tile->row();
+
+        if (m_removedTiles.size() >= maxLoggedRemovedTiles) {
+            const int numDroppedTiles = maxLoggedRemovedTiles / 2;
+            m_oldestTrackedRevision = m_removedTiles[numDroppedTiles - 1].revision;
+            m_removedTiles.remove(0, numDroppedTiles);
+        }
+
+        m_removedTiles.append(removedTile);
+    }
+
     if (registrationBlocked()) return;
 
     DEBUG_LOG_TILE_ACTION("reg. [D]", tile, tile->col(), tile->row());
@@ -384,6 +438,59 @@ void KisMementoManager::resetRevisionHistory(KisMementoItemList list)
     }
 }
 
+qint64 KisMementoManager::registerTileRevision()
+{
+    return m_lastTileRevision.fetchAndAddOrdered(1) + 1;
+}
+
+qint64 KisMementoManager::lastTileRevision() const
+{
+    const qint64 revision = m_lastTileRevision.loadAcquire();
+
+    /**
+     * The consumer may compare the tiles against this revision now,
+     * so the tiles stamped with it (or earlier) should get a new
+     * revision on the next write
+     */
+    qint64 observedRevision = m_observedTileRevision.loadAcquire();
+    while (observedRevision < revision &&
+           !m_observedTileRevision.testAndSetOrdered(observedRevision, revision, observedRevision));
+
+    return revision;
+}
+
+bool KisMementoManager::fetchRemovedTiles(qint64 revision, QVector<QPoint> *tiles) const
+{
+    QMutexLocker l(&m_tileRevisionLock);
+
+    /**
+     * The revision may predate the log or even this manager, or it may
+     * have been taken from another manager
+     */
+    if (revision < m_oldestTrackedRevision ||
+        revision > m_lastTileRevision.loadAcquire()) {
+
+        return false;
+    }
+
+    for (int i = m_removedTiles.size() - 1; i >= 0; i--) {
+        const RemovedTile &removedTile = m_removedTiles[i];
+        if (removedTile.revision <= revision) break;
+
+        tiles->append(QPoint(removedTile.col, removedTile.row));
+    }
+
+    return true;
+}
+
+void KisMementoManager::resetTileRevisionLog()
+{
+    QMutexLocker l(&m_tileRevisionLock);
+
+    m_removedTiles.clear();
+    m_oldestTrackedRevision = registerTileRevision();
+}
+
 void KisMementoManager::setDefaultTileData(KisTileData *defaultTileData)
 {
     m_headsHashTable.setDefaultTileData(defaultTileData);
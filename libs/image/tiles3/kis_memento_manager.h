@@ -20,6 +20,10 @@
 #define KIS_MEMENTO_MANAGER_
 
 #include <QList>
+#include <QMutex>
+#include <QPoint>
+#include <QVector>
+#include <QAtomicInteger>
 
 #include "kis_memento_item.h"
 #include "kis_tile_hash_table.h"
@@ -112,6 +116,52 @@ public:
      */
     void purgeHistory(KisMementoSP oldestMemento);
 
+    /**
+     * Tile revisions. A write access to a tile stamps it with a new
+     * revision, every removal of a tile is logged by the memento
+     * manager. Every manager counts the revisions in its own range, so
+     * a revision of one manager is never valid for another one, even
+     * when the data manager of a device is replaced with a new one.
+     *
+     * @return a new tile revision, which also becomes the last revision
+     *         of this manager
+     */
+    qint64 registerTileRevision();
+
+    /**
+     * A tile needs a new revision on write only if its current
+     * revision could have been seen by a consumer (see
+     * lastTileRevision()). This way a tile written many times
+     * between two requests of the consumer is stamped only once.
+     */
+    inline bool tileNeedsNewRevision(qint64 tileRevision) const {
+        return tileRevision <= m_observedTileRevision.loadAcquire();
+    }
+
+    /**
+     * @return the revision of the last change of the tiles
+     *         of this manager. The tiles written after the call
+     *         will get revisions newer than the returned one.
+     */
+    qint64 lastTileRevision() const;
+
+    /**
+     * Adds the positions of the tiles removed after \p revision
+     * into \p tiles
+     *
+     * @return false if the log of removed tiles doesn't go back to
+     *         \p revision or \p revision has been taken from another
+     *         manager, then all the tiles should be considered changed
+     */
+    bool fetchRemovedTiles(qint64 revision, QVector<QPoint> *tiles) const;
+
+    /**
+     * Forgets the log of removed tiles, so that the changes made before
+     * this moment cannot be tracked anymore. Used when all the pixels of
+     * the device change at once, e.g. when its default pixel is changed.
+     */
+    void resetTileRevisionLog();
+
 protected:
     qint32 findRevisionByMemento(KisMementoSP memento) const;
     void resetRevisionHistory(KisMementoItemList list);
@@ -156,6 +206,21 @@ protected:
      * \see rollforward()
      */
     bool m_registrationBlocked;
+
+    struct RemovedTile {
+        qint64 revision;
+        qint32 col;
+        qint32 row;
+    };
+
+    /**
+     * The log of removed tiles, sorted by revision
+     */
+    QVector<RemovedTile> m_removedTiles;
+    qint64 m_oldestTrackedRevision;
+    QAtomicInteger<qint64> m_lastTileRevision;
+    mutable QAtomicInteger<qint64> m_observedTileRevision;
+    mutable QMutex m_tileRevisionLock;
 };
 
 #endif /* KIS_MEMENTO_MANAGER_ */
@@ -59,7 +59,10 @@ private:
     }
 
     inline void unlockTile(KisTileSP &tile) {
-        tile->unlock();
+        if (m_writable)
+            tile->unlockForWrite();
+        else
+            tile->unlock();
     }
 
     inline quint32 xToCol(quint32 x) const {
@@ -40,9 +40,12 @@ void KisTile::init(qint32 col, qint32 row,
     m_tileData->acquire();
 
     m_mementoManager = mm;
+    m_revision = 0;
 
-    if (m_mementoManager)
+    if (m_mementoManager) {
+        m_revision = m_mementoManager->registerTileRevision();
         m_mementoManager->registerTileChange(this);
+    }
 }
 
 KisTile::KisTile(qint32 col, qint32 row,
@@ -208,6 +211,21 @@ void KisTile::unlock() const
     DEBUG_LOG_ACTION("unlock");
 }
 
+void KisTile::unlockForWrite()
+{
+    /**
+     * The revision is updated when the write is finished. If it was
+     * updated on lock, a consumer fetching the revision of the device
+     * in the middle of the write would consider the rest of the write
+     * as already seen.
+     */
+    if (m_mementoManager && m_mementoManager->tileNeedsNewRevision(m_revision)) {
+        m_revision = m_mementoManager->registerTileRevision();
+    }
+
+    unlock();
+}
+
 
 #include <stdio.h>
 void KisTile::debugPrintInfo()
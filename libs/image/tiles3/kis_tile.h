@@ -75,6 +75,12 @@ public:
     void lockForWrite();
     void unlock() const;
 
+    /**
+     * Unlocks the tile locked with lockForWrite() and updates
+     * its revision
+     */
+    void unlockForWrite();
+
     /* this allows us work directly on tile's data */
     inline quint8 *data() const {
         return m_tileData->data();
@@ -113,6 +119,15 @@ public:
         return m_tileData;
     }
 
+    /**
+     * @return the revision of the last write access to the tile
+     *
+     * \see KisMementoManager::registerTileRevision()
+     */
+    inline qint64 revision() const {
+        return m_revision;
+    }
+
 private:
     void init(qint32 col, qint32 row,
               KisTileData *defaultTileData, KisMementoManager* mm);
@@ -130,6 +145,8 @@ private:
     qint32 m_col;
     qint32 m_row;
 
+    qint64 m_revision;
+
     /**
      * Added for faster retrieving by processors
      */
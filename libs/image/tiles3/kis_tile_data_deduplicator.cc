@@ -0,0 +1,81 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tile_data_deduplicator.h"
+
+#include <QByteArray>
+
+#include "kis_assert.h"
+#include "kis_tile_data.h"
+
+
+KisTileDataDeduplicator::KisTileDataDeduplicator(qint32 pixelSize)
+    : m_pixelSize(pixelSize),
+      m_numDuplicates(0)
+{
+}
+
+KisTileDataDeduplicator::~KisTileDataDeduplicator()
+{
+}
+
+KisTileData* KisTileDataDeduplicator::findSharedTileData(KisTileSP tile)
+{
+    KIS_ASSERT_RECOVER(tile->pixelSize() == m_pixelSize) { return 0; }
+
+    const int tileDataSize = KisTileData::WIDTH * KisTileData::HEIGHT * m_pixelSize;
+
+    tile->lockForRead();
+
+    const quint8 *data = tile->data();
+    const uint hash = qHash(QByteArray::fromRawData(reinterpret_cast<const char*>(data), tileDataSize));
+
+    KisTileData *sharedData = 0;
+    bool alreadyShared = false;
+
+    QVector<KisTileSP> &candidates = m_tiles[hash];
+
+    Q_FOREACH (KisTileSP candidate, candidates) {
+        if (candidate->tileData() == tile->tileData()) {
+            alreadyShared = true;
+            break;
+        }
+
+        candidate->lockForRead();
+        const bool isEqual = !memcmp(candidate->data(), data, tileDataSize);
+        candidate->unlock();
+
+        if (isEqual) {
+            sharedData = candidate->tileData();
+            break;
+        }
+    }
+
+    tile->unlock();
+
+    if (sharedData) {
+        m_numDuplicates++;
+    } else if (!alreadyShared) {
+        candidates.append(tile);
+    }
+
+    return sharedData;
+}
+
+int KisTileDataDeduplicator::numDuplicates() const
+{
+    return m_numDuplicates;
+}
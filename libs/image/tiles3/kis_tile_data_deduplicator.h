@@ -0,0 +1,63 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_TILE_DATA_DEDUPLICATOR_H
+#define __KIS_TILE_DATA_DEDUPLICATOR_H
+
+#include <QHash>
+#include <QVector>
+
+#include "kritaimage_export.h"
+#include "kis_tile.h"
+
+
+/**
+ * KisTileDataDeduplicator remembers the tiles passed to
+ * KisTiledDataManager::deduplicateTiles() and finds the ones with
+ * exactly the same content, so that they could share one tile data
+ * copy-on-write. One deduplicator can be passed to several data
+ * managers (e.g. to all the frames of an animated device), then the
+ * tiles are shared between the managers.
+ *
+ * The tiles are compared by the hash of their content first and then
+ * byte by byte, so a hash collision never merges different tiles.
+ */
+class KRITAIMAGE_EXPORT KisTileDataDeduplicator
+{
+public:
+    KisTileDataDeduplicator(qint32 pixelSize);
+    ~KisTileDataDeduplicator();
+
+    /**
+     * @return the tile data with the same content as \p tile has,
+     * or null if there is no such data or the tile already uses it.
+     * In the latter case the tile is remembered for the future
+     * lookups.
+     */
+    KisTileData* findSharedTileData(KisTileSP tile);
+
+    /**
+     * The number of tiles that have been found to be duplicates
+     */
+    int numDuplicates() const;
+
+private:
+    qint32 m_pixelSize;
+    int m_numDuplicates;
+    QHash<uint, QVector<KisTileSP>> m_tiles;
+};
+
+#endif /* __KIS_TILE_DATA_DEDUPLICATOR_H */
@@ -94,6 +94,7 @@ KisTileDataPooler::KisTileDataPooler(KisTileDataStore *store, qint32 memoryLimit
     m_lastPoolMemoryMetric = 0;
     m_lastRealMemoryMetric = 0;
     m_lastHistoricalMemoryMetric = 0;
+    m_statisticsRevision = 0;
 
     if(memoryLimit >= 0) {
         m_memoryLimit = memoryLimit;
@@ -213,6 +214,7 @@ void KisTileDataPooler::run()
         m_lastPoolMemoryMetric = memoryOccupied;
         m_lastRealMemoryMetric = statRealMemory;
         m_lastHistoricalMemoryMetric = statHistoricalMemory;
+        m_statisticsRevision.ref();
 
         m_store->endIteration(iter);
 
@@ -242,6 +244,7 @@ void KisTileDataPooler::forceUpdateMemoryStats()
     m_lastPoolMemoryMetric = memoryOccupied;
     m_lastRealMemoryMetric = statRealMemory;
     m_lastHistoricalMemoryMetric = statHistoricalMemory;
+    m_statisticsRevision.ref();
 
     m_store->endIteration(iter);
 }
@@ -261,6 +264,11 @@ qint64 KisTileDataPooler::lastHistoricalMemoryMetric() const
     return m_lastHistoricalMemoryMetric;
 }
 
+int KisTileDataPooler::statisticsRevision() const
+{
+    return m_statisticsRevision.loadAcquire();
+}
+
 inline int KisTileDataPooler::clonesMetric(KisTileData *td, int numClones) {
     return numClones * td->pixelSize();
 }
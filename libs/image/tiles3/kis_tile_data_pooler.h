@@ -44,6 +44,13 @@ public:
     qint64 lastRealMemoryMetric() const;
     qint64 lastHistoricalMemoryMetric() const;
 
+    /**
+     * The number of times the memory statistics have been gathered.
+     * The user can compare it to the value saved earlier to know if
+     * the statistics have been updated since then.
+     */
+    int statisticsRevision() const;
+
 
     /**
      * Is case the pooler thread is not running, the user might force
@@ -93,6 +100,7 @@ protected:
     qint32 m_lastPoolMemoryMetric;
     qint32 m_lastRealMemoryMetric;
     qint32 m_lastHistoricalMemoryMetric;
+    QAtomicInt m_statisticsRevision;
 };
 
 
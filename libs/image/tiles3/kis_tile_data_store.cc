@@ -115,6 +115,7 @@ KisTileDataStore::MemoryStatistics KisTileDataStore::memoryStatistics()
     stats.totalMemorySize = memoryMetric() * metricCoeff + stats.poolSize;
 
     stats.swapSize = m_swappedStore.totalMemoryMetric() * metricCoeff;
+    stats.statisticsRevision = m_pooler.statisticsRevision();
 
     return stats;
 }
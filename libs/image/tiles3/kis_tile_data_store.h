@@ -51,6 +51,9 @@ public:
         qint64 poolSize;
 
         qint64 swapSize;
+
+        /// \see KisTileDataPooler::statisticsRevision()
+        int statisticsRevision;
     };
 
     MemoryStatistics memoryStatistics();
@@ -54,6 +54,7 @@ public:
 
         m_tile = tile;
         m_offset = pixelIndex * dm->pixelSize();
+        m_type = type;
 
         if (type == READ) {
             m_tile->lockForRead();
@@ -65,7 +66,11 @@ public:
 
     virtual ~KisTileDataWrapper()
     {
-        m_tile->unlock();
+        if (m_type == WRITE) {
+            m_tile->unlockForWrite();
+        } else {
+            m_tile->unlock();
+        }
     }
 
     /**
@@ -103,5 +108,6 @@ private:
 
     KisTileSP m_tile;
     qint32 m_offset;
+    accessType m_type;
 };
 #endif /* __KIS_TILE_DATA_WRAPPER_H */
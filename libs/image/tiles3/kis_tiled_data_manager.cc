@@ -24,6 +24,7 @@
 #include "kis_tile.h"
 #include "kis_tiled_data_manager.h"
 #include "kis_tile_data_wrapper.h"
+#include "kis_tile_data_deduplicator.h"
 #include "kis_tiled_data_manager_p.h"
 #include "kis_memento_manager.h"
 #include "swap/kis_legacy_tile_compressor.h"
@@ -111,6 +112,9 @@ void KisTiledDataManager::setDefaultPixelImpl(const quint8 *defaultPixel)
     m_hashTable->setDefaultTileData(td);
     m_mementoManager->setDefaultTileData(td);
 
+    // all the pixels outside the tiles have changed
+    m_mementoManager->resetTileRevisionLog();
+
     memcpy(m_defaultPixel, defaultPixel, pixelSize());
 }
 
@@ -581,6 +585,63 @@ void KisTiledDataManager::bitBltRoughOldData(KisTiledDataManager *srcDM, const Q
     bitBltRoughImpl<true>(srcDM, rect);
 }
 
+void KisTiledDataManager::deduplicateTiles(KisTileDataDeduplicator *deduplicator)
+{
+    QWriteLocker locker(&m_lock);
+
+    QVector<KisTileSP> tiles;
+
+    {
+        KisTileHashTableConstIterator iter(m_hashTable);
+        KisTileSP tile;
+
+        while ((tile = iter.tile())) {
+            tiles.append(tile);
+            iter.next();
+        }
+    }
+
+    Q_FOREACH (KisTileSP tile, tiles) {
+        KisTileData *td = deduplicator->findSharedTileData(tile);
+        if (!td) continue;
+
+        const qint32 column = tile->col();
+        const qint32 row = tile->row();
+
+        m_hashTable->deleteTile(column, row);
+        m_hashTable->addTile(KisTileSP(new KisTile(column, row, td, m_mementoManager)));
+    }
+}
+
+bool KisTiledDataManager::changedTileRects(qint64 revision, QVector<QRect> *rects) const
+{
+    QReadLocker locker(&m_lock);
+
+    QVector<QPoint> removedTiles;
+    if (!m_mementoManager->fetchRemovedTiles(revision, &removedTiles)) {
+        return false;
+    }
+
+    if (revision == m_mementoManager->lastTileRevision()) return true;
+
+    Q_FOREACH (const QPoint &pt, removedTiles) {
+        rects->append(QRect(pt.x() * KisTileData::WIDTH, pt.y() * KisTileData::HEIGHT,
+                            KisTileData::WIDTH, KisTileData::HEIGHT));
+    }
+
+    KisTileHashTableConstIterator iter(m_hashTable);
+    KisTileSP tile;
+
+    while ((tile = iter.tile())) {
+        if (tile->revision() > revision) {
+            rects->append(tile->extent());
+        }
+        iter.next();
+    }
+
+    return true;
+}
+
 void KisTiledDataManager::setExtent(qint32 x, qint32 y, qint32 w, qint32 h)
 {
     setExtent(QRect(x, y, w, h));
@@ -628,7 +689,7 @@ void KisTiledDataManager::setExtent(QRect newRect)
                         }
                     }
                 }
-                tile->unlock();
+                tile->unlockForWrite();
                 iter.next();
             } else {
                 iter.deleteCurrent();
@@ -40,6 +40,7 @@ typedef KisSharedPtr<KisTiledDataManager> KisTiledDataManagerSP;
 class KisTiledIterator;
 class KisTiledRandomAccessor;
 class KisPaintDeviceWriter;
+class KisTileDataDeduplicator;
 class QIODevice;
 
 /**
@@ -185,6 +186,44 @@ public:
 
     static void releaseInternalPools();
 
+    /**
+     * @return the revision of the last change of the data manager.
+     * The revisions increase monotonically, so a consumer can save
+     * the revision and later fetch the tiles changed after it with
+     * changedTileRects(). The revisions of different data managers
+     * never match, so a revision saved before the data manager of a
+     * device has been replaced is just reported as untrackable.
+     *
+     * NOTE: the revision of a tile is updated when the write into it
+     *       is finished, so the revision may be fetched while someone
+     *       writes into the data manager: the tiles being written will
+     *       be reported as changed after it.
+     */
+    qint64 revision() const {
+        return m_mementoManager->lastTileRevision();
+    }
+
+    /**
+     * Adds the rects of the tiles that have been changed, added or
+     * removed after \p revision into \p rects. The rects are in the
+     * coordinates of the data manager and may repeat.
+     *
+     * @return false if the changes made after \p revision cannot be
+     *         tracked anymore (e.g. the default pixel has been changed,
+     *         too many tiles have been removed since then or \p revision
+     *         belongs to another data manager). In such a
+     *         case the whole data manager should be considered changed.
+     */
+    bool changedTileRects(qint64 revision, QVector<QRect> *rects) const;
+
+    /**
+     * Makes all the revisions fetched before the call untrackable,
+     * that is changedTileRects() will return false for them
+     */
+    void resetRevisionLog() {
+        m_mementoManager->resetTileRevisionLog();
+    }
+
 protected:
     /**
      * Reads and writes the tiles 
@@ -242,6 +281,14 @@ public:
      */
     void bitBltRoughOldData(KisTiledDataManager *srcDM, const QRect &rect);
 
+    /**
+     * Makes the tiles having the same content as the tiles already
+     * seen by \p deduplicator share their tile data with them
+     * (copy-on-write). Passing the same deduplicator to several
+     * managers shares the identical tiles between all of them.
+     */
+    void deduplicateTiles(KisTileDataDeduplicator *deduplicator);
+
     /**
      * write the specified data to x, y. There is no checking on pixelSize!
      */
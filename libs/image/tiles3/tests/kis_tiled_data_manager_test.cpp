@@ -539,6 +539,154 @@ void KisTiledDataManagerTest::testUndoSetDefaultPixel()
     QVERIFY(memoryIsFilled(oddPixel2, tile10->data(), TILESIZE));
 }
 
+void KisTiledDataManagerTest::testTileRevisions()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+    quint8 oddPixel2 = 129;
+
+    dm.clear(QRect(0,0,128,64), &oddPixel1);
+
+    QVector<QRect> rects;
+
+    const qint64 revision1 = dm.revision();
+    QVERIFY(dm.changedTileRects(revision1, &rects));
+    QVERIFY(rects.isEmpty());
+
+    // change the tile (1,0) only
+    dm.clear(QRect(64,0,10,10), &oddPixel2);
+
+    const qint64 revision2 = dm.revision();
+    QVERIFY(revision2 > revision1);
+
+    QVERIFY(dm.changedTileRects(revision1, &rects));
+    QCOMPARE(rects.size(), 1);
+    QCOMPARE(rects.first(), QRect(64,0,64,64));
+
+    // remove all the tiles
+    rects.clear();
+    dm.clear();
+
+    QVERIFY(dm.changedTileRects(revision2, &rects));
+    QVERIFY(rects.contains(QRect(0,0,64,64)));
+    QVERIFY(rects.contains(QRect(64,0,64,64)));
+
+    // the default pixel changes everything
+    const qint64 revision3 = dm.revision();
+    dm.setDefaultPixel(&oddPixel2);
+
+    rects.clear();
+    QVERIFY(!dm.changedTileRects(revision3, &rects));
+
+    const qint64 revision4 = dm.revision();
+    QVERIFY(revision4 > revision3);
+    QVERIFY(dm.changedTileRects(revision4, &rects));
+    QVERIFY(rects.isEmpty());
+}
+
+void KisTiledDataManagerTest::testTileRevisionsRepeatedWrites()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+    quint8 oddPixel2 = 129;
+
+    dm.clear(QRect(0,0,128,64), &oddPixel1);
+
+    QVector<QRect> rects;
+
+    const qint64 revision1 = dm.revision();
+
+    // the tile is not stamped again until its revision is fetched...
+    dm.clear(QRect(0,0,10,10), &oddPixel2);
+    const qint64 revision2 = dm.revision();
+    dm.clear(QRect(0,0,10,10), &oddPixel1);
+
+    // ...but the writes made after the fetch are still visible
+    QVERIFY(dm.changedTileRects(revision2, &rects));
+    QCOMPARE(rects.size(), 1);
+    QCOMPARE(rects.first(), QRect(0,0,64,64));
+
+    rects.clear();
+    QVERIFY(dm.changedTileRects(revision1, &rects));
+    QCOMPARE(rects.size(), 1);
+    QCOMPARE(rects.first(), QRect(0,0,64,64));
+
+    const qint64 revision3 = dm.revision();
+    QVERIFY(revision3 > revision2);
+
+    rects.clear();
+    QVERIFY(dm.changedTileRects(revision3, &rects));
+    QVERIFY(rects.isEmpty());
+}
+
+void KisTiledDataManagerTest::testTileRevisionsMidWrite()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+
+    dm.clear(QRect(0,0,128,64), &oddPixel1);
+
+    QVector<QRect> rects;
+
+    KisTileSP tile = dm.getTile(0, 0, true);
+    tile->lockForWrite();
+    memset(tile->data(), 1, TILESIZE / 2);
+
+    // the revision is fetched while the tile is being written...
+    const qint64 revision = dm.revision();
+    QVERIFY(dm.changedTileRects(revision, &rects));
+    QVERIFY(rects.isEmpty());
+
+    memset(tile->data() + TILESIZE / 2, 2, TILESIZE / 2);
+    tile->unlockForWrite();
+
+    // ...so the rest of the write is still reported
+    QVERIFY(dm.revision() > revision);
+    QVERIFY(dm.changedTileRects(revision, &rects));
+    QCOMPARE(rects.size(), 1);
+    QCOMPARE(rects.first(), QRect(0,0,64,64));
+}
+
+void KisTiledDataManagerTest::testTileRevisionsForeignDataManager()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm1(1, &defaultPixel);
+    KisTiledDataManager dm2(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+
+    dm1.clear(QRect(0,0,128,64), &oddPixel1);
+    dm2.clear(QRect(0,0,64,64), &oddPixel1);
+
+    QVector<QRect> rects;
+
+    const qint64 revision1 = dm1.revision();
+    const qint64 revision2 = dm2.revision();
+
+    QVERIFY(dm1.changedTileRects(revision1, &rects));
+    QVERIFY(dm2.changedTileRects(revision2, &rects));
+    QVERIFY(rects.isEmpty());
+
+    // the revisions of one data manager are meaningless for the other
+    QVERIFY(!dm1.changedTileRects(revision2, &rects));
+    QVERIFY(!dm2.changedTileRects(revision1, &rects));
+
+    // the same for a copy of the data manager, its tiles are new
+    KisTiledDataManager dm3(dm1);
+    QVERIFY(!dm3.changedTileRects(revision1, &rects));
+
+    const qint64 revision3 = dm3.revision();
+    QVERIFY(dm3.changedTileRects(revision3, &rects));
+    QVERIFY(!dm1.changedTileRects(revision3, &rects));
+    QVERIFY(rects.isEmpty());
+}
+
 //#include <valgrind/callgrind.h>
 
 void KisTiledDataManagerTest::benchmarkReadOnlyTileLazy()
@@ -644,6 +792,42 @@ void KisTiledDataManagerTest::benchmarkCOWWithPooler()
     benchmarkCOWImpl();
 }
 
+void KisTiledDataManagerTest::benchmarkTileRevisions()
+{
+    const int pixelSize = 8;
+    quint8 defaultPixel[pixelSize];
+    memset(defaultPixel, 1, pixelSize);
+
+    KisTiledDataManager dm(pixelSize, defaultPixel);
+
+    /**
+     * The same 4096x2048 image as in benchmarkCOWImpl(), the tiles
+     * are written many times between two fetches of the revision,
+     * like it happens during a stroke
+     */
+    for (int i = 0; i < 32; i++) {
+        for (int j = 0; j < 64; j++) {
+            KisTileSP tile = dm.getTile(j, i, true);
+            tile->lockForWrite();
+            tile->unlock();
+        }
+    }
+
+    QBENCHMARK {
+        dm.revision();
+
+        for (int k = 0; k < 100; k++) {
+            for (int i = 0; i < 32; i++) {
+                for (int j = 0; j < 64; j++) {
+                    KisTileSP tile = dm.getTile(j, i, true);
+                    tile->lockForWrite();
+                    tile->unlockForWrite();
+                }
+            }
+        }
+    }
+}
+
 /******************* Stress job ***********************/
 
 //#define NUM_CYCLES 9000
@@ -52,6 +52,10 @@ private Q_SLOTS:
     void testTransactions();
     void testPurgeHistory();
     void testUndoSetDefaultPixel();
+    void testTileRevisions();
+    void testTileRevisionsRepeatedWrites();
+    void testTileRevisionsMidWrite();
+    void testTileRevisionsForeignDataManager();
 
     void benchmarkReadOnlyTileLazy();
     void benchmarkSharedPointers();
@@ -59,6 +63,8 @@ private Q_SLOTS:
     void benchmarkCOWNoPooler();
     void benchmarkCOWWithPooler();
 
+    void benchmarkTileRevisions();
+
     void stressTest();
 };
 
@@ -0,0 +1,56 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef VC_EXTRA_MATH_H
+#define VC_EXTRA_MATH_H
+
+#include <compositeops/KoVcMultiArchBuildSupport.h>
+
+#if defined HAVE_VC
+
+namespace VcExtraMath
+{
+
+/**
+ * Vectorized error function. Vc doesn't provide it, so we use
+ * Abramowitz and Stegun approximation 7.1.26. Its maximum absolute
+ * error is 1.5e-7, which is less than the precision of float.
+ */
+inline Vc::float_v erf(Vc::float_v::AsArg x)
+{
+    const Vc::float_v a1( 0.254829592f);
+    const Vc::float_v a2(-0.284496736f);
+    const Vc::float_v a3( 1.421413741f);
+    const Vc::float_v a4(-1.453152027f);
+    const Vc::float_v a5( 1.061405429f);
+    const Vc::float_v p(  0.3275911f);
+    const Vc::float_v vOne(Vc::One);
+
+    const Vc::float_v xa = Vc::abs(x);
+    const Vc::float_v t = vOne / (vOne + p * xa);
+    const Vc::float_v poly = ((((a5 * t + a4) * t + a3) * t + a2) * t + a1) * t;
+
+    Vc::float_v y = vOne - poly * Vc::exp(-xa * xa);
+    y(x < Vc::float_v(Vc::Zero)) = -y;
+
+    return y;
+}
+
+}
+
+#endif /* defined HAVE_VC */
+
+#endif // VC_EXTRA_MATH_H
@@ -412,6 +412,15 @@ public:
     virtual quint8 opacityU8(const quint8 * pixel) const = 0;
     virtual qreal opacityF(const quint8 * pixel) const = 0;
 
+    /**
+     * Get the alpha values of a run of pixels, downscaled to 8-bit values.
+     *
+     * src -- a pointer to the pixels
+     * dst -- a pointer to \p nPixels bytes for the alpha values
+     * nPixels -- the number of pixels
+     */
+    virtual void copyOpacityU8(const quint8 * src, quint8 * dst, qint32 nPixels) const = 0;
+
     /**
      * Set the alpha channel of the given run of pixels to the given value.
      *
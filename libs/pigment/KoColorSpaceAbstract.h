@@ -102,6 +102,10 @@ public:
         return _CSTrait::opacityF(U8_pixel);
     }
 
+    void copyOpacityU8(const quint8 * src, quint8 * dst, qint32 nPixels) const override {
+        _CSTrait::copyOpacityU8(src, dst, nPixels);
+    }
+
     void setOpacity(quint8 * pixels, quint8 alpha, qint32 nPixels) const override {
         _CSTrait::setOpacity(pixels, alpha, nPixels);
     }
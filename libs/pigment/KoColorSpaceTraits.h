@@ -22,6 +22,8 @@
 
 #include <QVector>
 
+#include <cstring>
+
 #include "KoColorSpaceConstants.h"
 #include "KoColorSpaceMaths.h"
 #include "DebugPigment.h"
@@ -85,6 +87,17 @@ struct KoColorSpaceTrait {
         return  KoColorSpaceMaths<channels_type, qreal>::scaleToA(c);
     }
 
+    inline static void copyOpacityU8(const quint8 * src, quint8 * dst, qint32 nPixels) {
+        if (alpha_pos < 0) {
+            memset(dst, OPACITY_OPAQUE_U8, nPixels);
+            return;
+        }
+        for (; nPixels > 0; --nPixels, src += pixelSize, ++dst) {
+            channels_type c = nativeArray(src)[alpha_pos];
+            *dst = KoColorSpaceMaths<channels_type, quint8>::scaleToA(c);
+        }
+    }
+
     /**
      * Set the alpha channel for this pixel from a value in the 0..255 range
      */
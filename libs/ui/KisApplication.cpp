@@ -35,6 +35,7 @@
 #include <QDesktopWidget>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QLocale>
 #include <QMessageBox>
 #include <QMessageBox>
@@ -68,6 +69,7 @@
 #include "KisMainWindow.h"
 #include "KisAutoSaveRecoveryDialog.h"
 #include "KisPart.h"
+#include "KisBatchConverter.h"
 #include <kis_icon.h>
 #include "kis_md5_generator.h"
 #include "kis_splash_screen.h"
@@ -477,6 +479,11 @@ bool KisApplication::start(const KisApplicationArguments &args)
 
     // Get the command line arguments which we have to parse
     int argsCount = args.filenames().count();
+
+    if (exportAs && argsCount > 0) {
+        return exportFilesInBatch(args.filenames(), exportFileName);
+    }
+
     if (argsCount > 0) {
         // Loop through arguments
         short int nPrinted = 0;
@@ -495,27 +502,7 @@ bool KisApplication::start(const KisApplicationArguments &args)
             }
             else {
 
-                if (exportAs) {
-                    QString outputMimetype = KisMimeDatabase::mimeTypeForFile(exportFileName);
-                    if (outputMimetype == "application/octetstream") {
-                        dbgKrita << i18n("Mimetype not found, try using the -mimetype option") << endl;
-                        return 1;
-                    }
-
-                    KisDocument *doc = KisPart::instance()->createDocument();
-                    doc->setFileBatchMode(m_batchRun);
-                    doc->openUrl(QUrl::fromLocalFile(fileName));
-
-                    qApp->processEvents(); // For vector layers to be updated
-
-                    doc->setFileBatchMode(true);
-                    if (!doc->exportDocumentSync(QUrl::fromLocalFile(exportFileName), outputMimetype.toLatin1())) {
-                        dbgKrita << "Could not export " << fileName << "to" << exportFileName << ":" << doc->errorMessage();
-                    }
-                    nPrinted++;
-                    QTimer::singleShot(0, this, SLOT(quit()));
-                }
-                else if (m_mainWindow) {
+                if (m_mainWindow) {
                     KisMainWindow::OpenFlags flags = m_batchRun ? KisMainWindow::BatchMode : KisMainWindow::None;
                     if (m_mainWindow->openDocument(QUrl::fromLocalFile(fileName), flags)) {
                         if (print) {
@@ -702,6 +689,63 @@ void KisApplication::checkAutosaveFiles()
     }
 }
 
+bool KisApplication::exportFilesInBatch(const QStringList &fileNames, const QString &exportFileName)
+{
+    const QString outputMimetype = KisMimeDatabase::mimeTypeForFile(exportFileName);
+    if (outputMimetype == "application/octet-stream") {
+        dbgKrita << i18n("Mimetype not found, try using the -mimetype option") << endl;
+        return false;
+    }
+
+    const QFileInfo exportFileInfo(exportFileName);
+
+    KisBatchConverter converter;
+    QStringList outputFileNames;
+
+    Q_FOREACH (const QString &fileName, fileNames) {
+        QString outputFileName = exportFileName;
+
+        if (fileNames.size() > 1) {
+            const QString baseName = QFileInfo(fileName).completeBaseName();
+
+            outputFileName =
+                exportFileInfo.absoluteDir().absoluteFilePath(
+                    baseName + "." + exportFileInfo.suffix());
+
+            /**
+             * The files with the same name from different directories
+             * should not overwrite each other's output
+             */
+            for (int i = 2; outputFileNames.contains(outputFileName); i++) {
+                outputFileName =
+                    exportFileInfo.absoluteDir().absoluteFilePath(
+                        QString("%1_%2.%3").arg(baseName).arg(i).arg(exportFileInfo.suffix()));
+            }
+        }
+
+        converter.addJob(KisBatchConverter::Job(fileName, outputFileName, outputMimetype.toLatin1()));
+        outputFileNames << outputFileName;
+    }
+
+    const QVector<KisBatchConverter::Result> results = converter.run();
+
+    int numExported = 0;
+    for (int i = 0; i < results.size(); i++) {
+        if (results[i].status != KisImportExportFilter::OK) {
+            dbgKrita << "Could not export " << fileNames[i] << "to" << outputFileNames[i] << ":"
+                     << KisImportExportFilter::conversionStatusString(results[i].status)
+                     << results[i].errorMessage;
+        } else {
+            numExported++;
+        }
+    }
+
+    QTimer::singleShot(0, this, SLOT(quit()));
+
+    // the script should know that some of the files have not been exported
+    return numExported == results.size();
+}
+
 bool KisApplication::createNewDocFromTemplate(const QString &fileName, KisMainWindow *mainWindow)
 {
     QString templatePath;
@@ -109,6 +109,12 @@ private:
     /// @return the number of autosavefiles opened
     void checkAutosaveFiles();
     bool createNewDocFromTemplate(const QString &fileName, KisMainWindow *m_mainWindow);
+    /**
+     * Converts \p fileNames into the format of \p exportFileName without
+     * creating any main window. If more than one file is passed, every file
+     * is saved into the directory of \p exportFileName, keeping its base name.
+     */
+    bool exportFilesInBatch(const QStringList &fileNames, const QString &exportFileName);
     void clearConfig();
 
 private:
@@ -0,0 +1,130 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisBatchConverter.h"
+
+#include <QCoreApplication>
+#include <QEvent>
+#include <QFileInfo>
+#include <QThread>
+#include <QUrl>
+
+#include <KisMimeDatabase.h>
+
+#include "KisDocument.h"
+#include "KisImportExportManager.h"
+#include "kis_assert.h"
+#include "kis_image.h"
+
+
+struct KisBatchConverter::Private
+{
+    QVector<Job> jobs;
+};
+
+KisBatchConverter::KisBatchConverter()
+    : m_d(new Private)
+{
+}
+
+KisBatchConverter::~KisBatchConverter()
+{
+}
+
+void KisBatchConverter::addJob(const Job &job)
+{
+    m_d->jobs.append(job);
+}
+
+int KisBatchConverter::numJobs() const
+{
+    return m_d->jobs.size();
+}
+
+QVector<KisBatchConverter::Result> KisBatchConverter::run()
+{
+    QVector<Result> results;
+
+    Q_FOREACH (const Job &job, m_d->jobs) {
+        results << processJob(job);
+
+        /**
+         * Some parts of the document are deleted with deleteLater(),
+         * so flush them before opening the next document to keep
+         * only one document in memory
+         */
+        QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+    }
+
+    m_d->jobs.clear();
+
+    return results;
+}
+
+KisBatchConverter::Result KisBatchConverter::processJob(const Job &job)
+{
+    KIS_SAFE_ASSERT_RECOVER_NOOP(QThread::currentThread() == qApp->thread());
+
+    Result result;
+
+    if (!QFileInfo(job.inputFile).exists()) {
+        result.status = KisImportExportFilter::FileNotFound;
+        return result;
+    }
+
+    QByteArray outputMimeType = job.outputMimeType;
+    if (outputMimeType.isEmpty()) {
+        outputMimeType = KisMimeDatabase::mimeTypeForFile(job.outputFile).toLatin1();
+    }
+
+    if (outputMimeType.isEmpty() || outputMimeType == "application/octet-stream") {
+        result.status = KisImportExportFilter::BadMimeType;
+        return result;
+    }
+
+    /**
+     * The document is created directly, without KisPart, so it will never
+     * be registered in any main window or view.
+     */
+    QScopedPointer<KisDocument> doc(new KisDocument());
+    doc->setFileBatchMode(true);
+
+    const QString inputMimeType = KisMimeDatabase::mimeTypeForFile(job.inputFile);
+    result.status = doc->importExportManager()->importDocument(job.inputFile, inputMimeType);
+
+    if (result.status != KisImportExportFilter::OK || !doc->image()) {
+        if (result.status == KisImportExportFilter::OK) {
+            result.status = KisImportExportFilter::ParsingError;
+        }
+        result.errorMessage = doc->errorMessage();
+        return result;
+    }
+
+    doc->setMimeTypeAfterLoading(inputMimeType);
+
+    // for vector layers to be updated
+    QCoreApplication::processEvents();
+
+    KisImageSP image = doc->image();
+    image->waitForDone();
+
+    if (!doc->exportDocumentSync(QUrl::fromLocalFile(job.outputFile), outputMimeType, job.exportConfiguration)) {
+        result.status = KisImportExportFilter::CreationError;
+        result.errorMessage = doc->errorMessage();
+    }
+
+    return result;
+}
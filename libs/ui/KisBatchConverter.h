@@ -0,0 +1,100 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISBATCHCONVERTER_H
+#define KISBATCHCONVERTER_H
+
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+#include <KisImportExportFilter.h>
+#include <kis_properties_configuration.h>
+
+#include "kritaui_export.h"
+
+/**
+ * KisBatchConverter converts a set of files from one format into another
+ * without creating any main window, view or KisPart registration for the
+ * documents. It is used by the command-line export mode.
+ *
+ * NOTE: this is not a GUI-free engine. The conversion goes through
+ *       KisDocument and the import/export filters of libs/ui, which
+ *       expect to live in the GUI thread, so the documents are converted
+ *       strictly one by one and there is no memory budget. Only the
+ *       processing inside a single document (the image updates, the
+ *       filters' own worker threads) can use several cores. A document
+ *       is destroyed before the next one is opened.
+ *
+ * The import/export filter plugins are fetched from a cache inside
+ * KisImportExportManager, so they are not looked up again for every
+ * document.
+ */
+class KRITAUI_EXPORT KisBatchConverter
+{
+public:
+    struct Job {
+        Job() {}
+        Job(const QString &_inputFile, const QString &_outputFile,
+            const QByteArray &_outputMimeType = QByteArray(),
+            KisPropertiesConfigurationSP _exportConfiguration = 0)
+            : inputFile(_inputFile),
+              outputFile(_outputFile),
+              outputMimeType(_outputMimeType),
+              exportConfiguration(_exportConfiguration)
+        {
+        }
+
+        QString inputFile;
+        QString outputFile;
+
+        /// if empty, the mimetype is deduced from the output file name
+        QByteArray outputMimeType;
+
+        /// if null, the last saved configuration of the filter is used
+        KisPropertiesConfigurationSP exportConfiguration;
+    };
+
+    struct Result {
+        KisImportExportFilter::ConversionStatus status = KisImportExportFilter::UsageError;
+        QString errorMessage;
+    };
+
+public:
+    KisBatchConverter();
+    ~KisBatchConverter();
+
+    void addJob(const Job &job);
+    int numJobs() const;
+
+    /**
+     * Runs all the queued jobs and blocks until they are finished. The
+     * results are returned in the order the jobs were added. Should be
+     * called from the GUI thread.
+     */
+    QVector<Result> run();
+
+    /**
+     * Processes a single job. Should be called from the GUI thread.
+     */
+    static Result processJob(const Job &job);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISBATCHCONVERTER_H
@@ -19,6 +19,8 @@
 
 #include "KisImportExportManager.h"
 
+#include <algorithm>
+
 #include <QFile>
 #include <QLabel>
 #include <QVBoxLayout>
@@ -35,6 +37,10 @@
 #include <QGroupBox>
 #include <QFuture>
 #include <QtConcurrent>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QGlobalStatic>
+#include <QPair>
 
 #include <klocalizedstring.h>
 #include <ksqueezedtextlabel.h>
@@ -148,6 +154,48 @@ QFuture<KisImportExportFilter::ConversionStatus> KisImportExportManager::exportD
     return result.futureStatus();
 }
 
+namespace {
+
+/**
+ * Querying KoJsonTrader loads the metadata of every plugin installed on
+ * the system, which is really slow when done for every file in a batch
+ * conversion. The loaders are fetched once and kept alive for the whole
+ * lifetime of the application, so that the filter factories stay warm
+ * between the documents.
+ */
+struct FilterLoadersCache
+{
+    ~FilterLoadersCache() {
+        qDeleteAll(loaders);
+    }
+
+    QMutex mutex;
+    bool initialized = false;
+    QList<QPluginLoader *> loaders;
+};
+
+Q_GLOBAL_STATIC(FilterLoadersCache, s_filterLoadersCache)
+
+QList<QPluginLoader *> cachedFilterLoaders()
+{
+    FilterLoadersCache *cache = s_filterLoadersCache;
+    QMutexLocker l(&cache->mutex);
+
+    if (!cache->initialized) {
+        cache->loaders = KoJsonTrader::instance()->query("Krita/FileFilter", "");
+        cache->initialized = true;
+    }
+
+    return cache->loaders;
+}
+
+QString directionKey(KisImportExportManager::Direction direction)
+{
+    return direction == KisImportExportManager::Export ? "X-KDE-Export" : "X-KDE-Import";
+}
+
+}
+
 // The static method to figure out to which parts of the
 // graph this mimetype has a connection to.
 QStringList KisImportExportManager::mimeFilter(Direction direction)
@@ -158,30 +206,26 @@ QStringList KisImportExportManager::mimeFilter(Direction direction)
 
     if (direction == KisImportExportManager::Import) {
         if (m_importMimeTypes.isEmpty()) {
-            QList<QPluginLoader *>list = KoJsonTrader::instance()->query("Krita/FileFilter", "");
-            Q_FOREACH(QPluginLoader *loader, list) {
+            Q_FOREACH(QPluginLoader *loader, cachedFilterLoaders()) {
                 QJsonObject json = loader->metaData().value("MetaData").toObject();
                 Q_FOREACH(const QString &mimetype, json.value("X-KDE-Import").toString().split(",", QString::SkipEmptyParts)) {
                     //qDebug() << "Adding  import mimetype" << mimetype << KisMimeDatabase::descriptionForMimeType(mimetype) << "from plugin" << loader;
                     mimeTypes << mimetype;
                 }
             }
-            qDeleteAll(list);
             m_importMimeTypes = mimeTypes.toList();
         }
         return m_importMimeTypes;
     }
     else if (direction == KisImportExportManager::Export) {
         if (m_exportMimeTypes.isEmpty()) {
-            QList<QPluginLoader *>list = KoJsonTrader::instance()->query("Krita/FileFilter", "");
-            Q_FOREACH(QPluginLoader *loader, list) {
+            Q_FOREACH(QPluginLoader *loader, cachedFilterLoaders()) {
                 QJsonObject json = loader->metaData().value("MetaData").toObject();
                 Q_FOREACH(const QString &mimetype, json.value("X-KDE-Export").toString().split(",", QString::SkipEmptyParts)) {
                     //qDebug() << "Adding  export mimetype" << mimetype << KisMimeDatabase::descriptionForMimeType(mimetype) << "from plugin" << loader;
                     mimeTypes << mimetype;
                 }
             }
-            qDeleteAll(list);
             m_exportMimeTypes = mimeTypes.toList();
         }
         return m_exportMimeTypes;
@@ -191,45 +235,57 @@ QStringList KisImportExportManager::mimeFilter(Direction direction)
 
 KisImportExportFilter *KisImportExportManager::filterForMimeType(const QString &mimetype, KisImportExportManager::Direction direction)
 {
-    int weight = -1;
-    KisImportExportFilter *filter = 0;
-    QList<QPluginLoader *>list = KoJsonTrader::instance()->query("Krita/FileFilter", "");
-    Q_FOREACH(QPluginLoader *loader, list) {
+    QList<QPair<int, QPluginLoader*>> candidates;
+
+    Q_FOREACH(QPluginLoader *loader, cachedFilterLoaders()) {
         QJsonObject json = loader->metaData().value("MetaData").toObject();
-        QString directionKey = direction == Export ? "X-KDE-Export" : "X-KDE-Import";
-        if (json.value(directionKey).toString().split(",", QString::SkipEmptyParts).contains(mimetype)) {
-            KLibFactory *factory = qobject_cast<KLibFactory *>(loader->instance());
+        if (json.value(directionKey(direction)).toString().split(",", QString::SkipEmptyParts).contains(mimetype)) {
+            candidates << qMakePair(json.value("X-KDE-Weight").toInt(), loader);
+        }
+    }
 
-            if (!factory) {
-                warnUI << loader->errorString();
-                continue;
-            }
+    // the heaviest filter wins, the others are the fallbacks if it fails to load
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [] (const QPair<int, QPluginLoader*> &lhs, const QPair<int, QPluginLoader*> &rhs) {
+                         return lhs.first > rhs.first;
+                     });
 
-            QObject* obj = factory->create<KisImportExportFilter>(0);
-            if (!obj || !obj->inherits("KisImportExportFilter")) {
-                delete obj;
-                continue;
-            }
+    KisImportExportFilter *filter = 0;
 
-            KisImportExportFilter *f = qobject_cast<KisImportExportFilter*>(obj);
-            if (!f) {
-                delete obj;
-                continue;
-            }
+    for (auto it = candidates.constBegin(); it != candidates.constEnd(); ++it) {
+        QPluginLoader *loader = it->second;
 
-            int w = json.value("X-KDE-Weight").toInt();
-            if (w > weight) {
-                delete filter;
-                filter = f;
-                f->setObjectName(loader->fileName());
-                weight = w;
-            }
+        /**
+         * The filters are also requested from the background thread of
+         * the asynchronous export (see doExport()), and
+         * QPluginLoader::instance() may load the library
+         */
+        QMutexLocker l(&s_filterLoadersCache->mutex);
+
+        KLibFactory *factory = qobject_cast<KLibFactory *>(loader->instance());
+
+        if (!factory) {
+            warnUI << loader->errorString();
+            continue;
         }
-    }
-    qDeleteAll(list);
-    if (filter) {
+
+        QObject* obj = factory->create<KisImportExportFilter>(0);
+        if (!obj || !obj->inherits("KisImportExportFilter")) {
+            delete obj;
+            continue;
+        }
+
+        filter = qobject_cast<KisImportExportFilter*>(obj);
+        if (!filter) {
+            delete obj;
+            continue;
+        }
+
+        filter->setObjectName(loader->fileName());
         filter->setMimeType(mimetype);
+        break;
     }
+
     return filter;
 }
 
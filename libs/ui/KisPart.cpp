@@ -66,6 +66,7 @@
 #include "kis_animation_cache_populator.h"
 #include "kis_idle_watcher.h"
 #include "kis_image.h"
+#include "kis_memory_statistics_server.h"
 #include "KisImportExportManager.h"
 #include "KisDocument.h"
 #include "KoToolManager.h"
@@ -89,6 +90,7 @@ public:
         : part(_part)
         , idleWatcher(2500)
         , animationCachePopulator(_part)
+        , undoPurgeStatisticsRevision(-1)
     {
     }
 
@@ -107,6 +109,9 @@ public:
 
     KisIdleWatcher idleWatcher;
     KisAnimationCachePopulator animationCachePopulator;
+
+    /// the revision of the tile statistics the last undo command was purged at
+    int undoPurgeStatisticsRevision;
 };
 
 
@@ -135,6 +140,9 @@ KisPart::KisPart()
     connect(&d->idleWatcher, SIGNAL(startedIdleMode()),
             &d->animationCachePopulator, SLOT(slotRequestRegeneration()));
 
+    connect(KisMemoryStatisticsServer::instance(), SIGNAL(sigUpdateMemoryStatistics()),
+            this, SLOT(slotCheckUndoMemoryLimit()));
+
     d->animationCachePopulator.slotRequestRegeneration();
 }
 
@@ -317,6 +325,71 @@ void KisPart::slotDocumentSaved()
     emit sigDocumentSaved(doc->url().toLocalFile());
 }
 
+void KisPart::slotCheckUndoMemoryLimit()
+{
+    /**
+     * The undo data is swapped out first (see "Swap Undo After" setting),
+     * the oldest commands are removed only when the total size of the
+     * history of all the open documents exceeds the limit
+     */
+    KisMemoryStatisticsServer *server = KisMemoryStatisticsServer::instance();
+    KisMemoryStatisticsServer::Statistics stats = server->fetchMemoryStatistics(KisImageSP());
+
+    if (stats.historicalMemoryLimit <= 0 ||
+        stats.historicalMemorySize <= stats.historicalMemoryLimit) {
+
+        return;
+    }
+
+    /**
+     * The statistics are gathered by the pooler thread asynchronously.
+     * The cycle that was running when the last command was removed may
+     * still report the old size, so we wait for a cycle that started
+     * after the removal before removing anything else.
+     */
+    if (d->undoPurgeStatisticsRevision >= 0 &&
+        stats.statisticsRevision - d->undoPurgeStatisticsRevision < 2) {
+
+        server->notifyHistoryChanged();
+        return;
+    }
+
+    /**
+     * The history is shared by all the documents, so the oldest command
+     * among all of them is removed, not the oldest one of every document
+     */
+    const int msecsPerDay = 24 * 60 * 60 * 1000;
+    const QTime currentTime = QTime::currentTime();
+
+    KUndo2Stack *oldestStack = 0;
+    int oldestAge = -1;
+
+    Q_FOREACH (QPointer<KisDocument> document, d->documents) {
+        if (!document) continue;
+
+        KUndo2Stack *stack = document->undoStack();
+        if (!stack->canPurgeOldestCommand()) continue;
+
+        // KUndo2Command::time() is not const, though it doesn't change anything
+        KUndo2Command *command = const_cast<KUndo2Command*>(stack->command(0));
+
+        int age = command->time().msecsTo(currentTime);
+        if (age < 0) {
+            age += msecsPerDay; // the command was created before midnight
+        }
+
+        if (age > oldestAge) {
+            oldestAge = age;
+            oldestStack = stack;
+        }
+    }
+
+    if (oldestStack && oldestStack->purgeOldestCommand()) {
+        d->undoPurgeStatisticsRevision = stats.statisticsRevision;
+        server->notifyHistoryChanged();
+    }
+}
+
 void KisPart::removeMainWindow(KisMainWindow *mainWindow)
 {
     dbgUI <<"mainWindow" << (void*)mainWindow <<"removed from doc" << this;
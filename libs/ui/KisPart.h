@@ -246,6 +246,8 @@ private Q_SLOTS:
 
     void slotDocumentSaved();
 
+    void slotCheckUndoMemoryLimit();
+
 private:
 
     Q_DISABLE_COPY(KisPart)
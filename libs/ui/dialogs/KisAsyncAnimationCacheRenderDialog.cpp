@@ -26,7 +26,8 @@
 
 namespace {
 
-QList<int> calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange)
+QList<int> calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange,
+                               const KisTimeRange &skipRange = KisTimeRange(), int maxFrames = -1)
 {
     QList<int> result;
 
@@ -41,6 +42,15 @@ QList<int> calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRang
 
         // TODO: optimize check for fully-cached case
         for (int frame = playbackRange.start(); frame <= playbackRange.end(); frame++) {
+            if (skipRange.contains(frame)) {
+                if (skipRange.isInfinite()) {
+                    break;
+                } else {
+                    frame = skipRange.end();
+                    continue;
+                }
+            }
+
             KisTimeRange stillFrameRange = KisTimeRange::infinite(0);
             KisTimeRange::calculateTimeRangeRecursive(image->root(), frame, stillFrameRange, true);
 
@@ -48,6 +58,8 @@ QList<int> calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRang
 
             if (cache->frameStatus(stillFrameRange.start()) == KisAnimationFrameCache::Uncached) {
                 result.append(stillFrameRange.start());
+
+                if (maxFrames > 0 && result.size() >= maxFrames) break;
             }
 
             if (stillFrameRange.isInfinite()) {
@@ -97,6 +109,10 @@ int KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(KisAnimationFrameCac
     return result;
 }
 
+QList<int> KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrames(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange, int maxFrames)
+{
+    return calcDirtyFramesList(cache, playbackRange, skipRange, maxFrames);
+}
 
 struct KisAsyncAnimationCacheRenderDialog::Private
 {
@@ -31,6 +31,13 @@ public:
 
     static int calcFirstDirtyFrame(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange);
 
+    /**
+     * @return up to \p maxFrames frames of \p playbackRange, lying outside
+     * \p skipRange, that should be regenerated. Only the first frame of
+     * every range of identical frames is returned.
+     */
+    static QList<int> calcFirstDirtyFrames(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange, int maxFrames);
+
 protected:
     QList<int> calcDirtyFrames() const override;
     KisAsyncAnimationRendererBase* createRenderer(KisImageSP image) override;
@@ -57,18 +57,6 @@ struct RendererPair {
     }
 };
 
-int calculateNumberMemoryAllowedClones(KisImageSP image)
-{
-    KisMemoryStatisticsServer::Statistics stats =
-        KisMemoryStatisticsServer::instance()
-        ->fetchMemoryStatistics(image);
-
-    const qint64 allowedMemory = 0.8 * stats.tilesHardLimit - stats.realMemorySize;
-    const qint64 cloneSize = stats.projectionsSize;
-
-    return allowedMemory > 0 ? allowedMemory / cloneSize : 0;
-}
-
 }
 
 
@@ -138,7 +126,7 @@ KisAsyncAnimationRenderDialogBase::regenerateRange(KisViewManager *viewManager)
     KisImageConfig cfg;
 
     const int maxThreads = cfg.maxNumberOfThreads();
-    const int numAllowedWorker = 1 + calculateNumberMemoryAllowedClones(m_d->image);
+    const int numAllowedWorker = 1 + calcNumberMemoryAllowedClones(m_d->image);
     const int proposedNumWorkers = qMin(m_d->dirtyFramesCount, cfg.frameRenderingClones());
     const int numWorkers = qMin(proposedNumWorkers, numAllowedWorker);
     const int numThreadsPerWorker = qMax(1, qCeil(qreal(maxThreads) / numWorkers));
@@ -199,6 +187,18 @@ KisAsyncAnimationRenderDialogBase::regenerateRange(KisViewManager *viewManager)
     return m_d->result;
 }
 
+int KisAsyncAnimationRenderDialogBase::calcNumberMemoryAllowedClones(KisImageSP image)
+{
+    KisMemoryStatisticsServer::Statistics stats =
+        KisMemoryStatisticsServer::instance()
+        ->fetchMemoryStatistics(image);
+
+    const qint64 allowedMemory = 0.8 * stats.tilesHardLimit - stats.realMemorySize;
+    const qint64 cloneSize = stats.projectionsSize;
+
+    return allowedMemory > 0 && cloneSize > 0 ? allowedMemory / cloneSize : 0;
+}
+
 void KisAsyncAnimationRenderDialogBase::slotFrameCompleted(int frame)
 {
     Q_UNUSED(frame);
@@ -100,6 +100,14 @@ public:
      */
     bool batchMode() const;
 
+    /**
+     * @return the number of clones of \p image that can be created
+     *         without exceeding the memory limit. The overhead of a clone
+     *         is estimated using "projections" metric of the statistics
+     *         server.
+     */
+    static int calcNumberMemoryAllowedClones(KisImageSP image);
+
 private Q_SLOTS:
     void slotFrameCompleted(int frame);
     void slotFrameCancelled(int frame);
@@ -723,6 +723,7 @@ void PerformanceTab::load(bool requestDefault)
     chkProgressReporting->setChecked(cfg.enableProgressReporting(requestDefault));
 
     sliderSwapSize->setValue(cfg.maxSwapSize(requestDefault) / 1024);
+    intUndoHistoryLimit->setValue(cfg.undoMemoryLimit(requestDefault));
     lblSwapFileLocation->setText(cfg.swapDir(requestDefault));
 
     m_lastUsedThreadsLimit = cfg.maxNumberOfThreads(requestDefault);
@@ -750,6 +751,7 @@ void PerformanceTab::save()
     cfg.setEnableProgressReporting(chkProgressReporting->isChecked());
 
     cfg.setMaxSwapSize(sliderSwapSize->value() * 1024);
+    cfg.setUndoMemoryLimit(intUndoHistoryLimit->value());
 
     cfg.setSwapDir(lblSwapFileLocation->text());
 
@@ -18,13 +18,17 @@
 
 #include "kis_animation_cache_populator.h"
 
+#include <algorithm>
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include <QTimer>
 #include <QMutex>
 #include <QtConcurrent>
 
 #include "kis_config.h"
+#include "kis_image_config.h"
 #include "kis_config_notifier.h"
 #include "KisPart.h"
 #include "KisDocument.h"
@@ -43,6 +47,26 @@
 #include "KisAsyncAnimationCacheRenderer.h"
 #include "dialogs/KisAsyncAnimationCacheRenderDialog.h"
 
+namespace {
+
+/**
+ * A copy-on-write clone of the image with its own renderer. The clones
+ * regenerate other frames of the cache concurrently with the main
+ * regenerator, which works on the image itself.
+ */
+struct CloneWorker {
+    CloneWorker(KisImageSP _image)
+        : image(_image),
+          frame(-1)
+    {
+    }
+
+    KisAsyncAnimationCacheRenderer renderer;
+    KisImageSP image;
+    int frame;
+};
+
+}
 
 struct KisAnimationCachePopulator::Private
 {
@@ -58,6 +82,7 @@ struct KisAnimationCachePopulator::Private
     static const int IDLE_COUNT_THRESHOLD = 4;
     static const int IDLE_CHECK_INTERVAL = 500;
     static const int BETWEEN_FRAMES_INTERVAL = 10;
+    static const int DROPPED_CLONES_CHECK_INTERVAL = 100;
 
     int requestedFrame;
     KisAnimationFrameCacheSP requestCache;
@@ -69,6 +94,25 @@ struct KisAnimationCachePopulator::Private
     KisAsyncAnimationCacheRenderer regenerator;
     bool calculateAnimationCacheInBackground = true;
 
+    std::vector<std::unique_ptr<CloneWorker>> clones;
+    KisAnimationFrameCacheSP clonesCache;
+    KisTimeRange clonesSkipRange;
+    KisSignalAutoConnectionsStore clonesConnections;
+
+    /**
+     * The image the clones are made of and its own threads limit, which
+     * is lowered while the clones are regenerating the frames
+     */
+    KisImageWSP clonedImage;
+    int clonedImageThreadsLimit = 0;
+
+    /**
+     * The clones that have been dropped, but whose strokes are still
+     * being cancelled. Destroying them right away would block the GUI.
+     */
+    std::vector<std::unique_ptr<CloneWorker>> droppedClones;
+    QTimer droppedClonesTimer;
+
 
 
     enum State {
@@ -87,6 +131,7 @@ struct KisAnimationCachePopulator::Private
           state(WaitingForIdle)
     {
         timer.setSingleShot(true);
+        droppedClonesTimer.setInterval(DROPPED_CLONES_CHECK_INTERVAL);
     }
 
     void timerTimeout() {
@@ -176,16 +221,35 @@ struct KisAnimationCachePopulator::Private
         KisImageSP image = cache->image();
         if (!image) return false;
 
-        KisImageAnimationInterface *animation = image->animationInterface();
-        KisTimeRange currentRange = animation->fullClipRange();
+        KisImageConfig cfg;
+        const int maxClones = qMax(0, cfg.frameRenderingClones() - 1);
 
-        const int frame = KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(cache, currentRange, skipRange);
+        QList<int> frames = dirtyFrames(cache, skipRange, 1 + maxClones);
 
-        if (frame >= 0) {
-            return regenerate(cache, frame);
+        if (frames.isEmpty()) {
+            if (cache == clonesCache && !hasActiveClones()) {
+                dropClones();
+            }
+            return false;
         }
 
-        return false;
+        /**
+         * The clones should be created before the main regenerator
+         * starts its stroke, otherwise we will not be able to lock
+         * the image for copying.
+         */
+        if (frames.size() > 1) {
+            createClones(cache, qMin(frames.size() - 1, maxClones));
+            clonesSkipRange = skipRange;
+        }
+
+        if (!regenerate(cache, frames.takeFirst())) {
+            return false;
+        }
+
+        startClonesRegeneration(frames);
+
+        return true;
     }
 
     bool regenerate(KisAnimationFrameCacheSP cache, int frame)
@@ -202,12 +266,177 @@ struct KisAnimationCachePopulator::Private
          */
         enterState(WaitingForFrame);
 
+        requestCache = cache;
+        requestedFrame = frame;
+
         regenerator.setFrameCache(cache);
         regenerator.startFrameRegeneration(cache->image(), frame);
 
         return true;
     }
 
+    /**
+     * @return up to \p maxFrames dirty frames of \p cache, which are
+     * not being regenerated right now
+     */
+    QList<int> dirtyFrames(KisAnimationFrameCacheSP cache, const KisTimeRange &skipRange, int maxFrames)
+    {
+        KisImageSP image = cache->image();
+        if (!image) return QList<int>();
+
+        QList<int> framesInProgress;
+
+        if (state == WaitingForFrame && cache == requestCache) {
+            framesInProgress << requestedFrame;
+        }
+
+        if (cache == clonesCache) {
+            for (auto &clone : clones) {
+                if (clone->renderer.isActive()) {
+                    framesInProgress << clone->frame;
+                }
+            }
+        }
+
+        KisTimeRange currentRange = image->animationInterface()->fullClipRange();
+
+        QList<int> frames =
+            KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrames(
+                cache, currentRange, skipRange, maxFrames + framesInProgress.size());
+
+        Q_FOREACH (int frame, framesInProgress) {
+            frames.removeAll(frame);
+        }
+
+        while (frames.size() > maxFrames) {
+            frames.removeLast();
+        }
+
+        return frames;
+    }
+
+    void createClones(KisAnimationFrameCacheSP cache, int numClones)
+    {
+        if (cache != clonesCache) {
+            dropClones();
+        }
+
+        if (!clones.empty()) return;
+
+        KisImageSP image = cache->image();
+        if (!image) return;
+
+        numClones = qMin(numClones, KisAsyncAnimationRenderDialogBase::calcNumberMemoryAllowedClones(image));
+        if (numClones <= 0) return;
+
+        // the image must not be changed while being copied
+        if (!image->tryBarrierLock(true)) return;
+
+        KisImageConfig cfg;
+        const int numThreadsPerClone = qMax(1, cfg.maxNumberOfThreads() / (numClones + 1));
+
+        for (int i = 0; i < numClones; i++) {
+            KisImageSP clone = image->clone(true);
+            clone->setWorkingThreadsLimit(numThreadsPerClone);
+
+            std::unique_ptr<CloneWorker> worker(new CloneWorker(clone));
+            worker->renderer.setFrameCache(cache);
+
+            QObject::connect(&worker->renderer, SIGNAL(sigFrameCompleted(int)), q, SLOT(slotCloneFrameReady()));
+
+            clones.push_back(std::move(worker));
+        }
+
+        image->unlock();
+
+        clonesCache = cache;
+
+        /**
+         * The main regenerator works on the image itself, so it should
+         * share the threads with the clones as well
+         */
+        clonedImage = image;
+        clonedImageThreadsLimit = image->workingThreadsLimit();
+        image->setWorkingThreadsLimit(numThreadsPerClone);
+
+        /**
+         * Any change in the image makes the clones outdated, so they
+         * are dropped as soon as the cache is invalidated.
+         */
+        clonesConnections.addConnection(image->animationInterface(), SIGNAL(sigFramesChanged(KisTimeRange,QRect)),
+                                        q, SLOT(slotDropClones()));
+        clonesConnections.addConnection(image.data(), SIGNAL(sigAboutToBeDeleted()),
+                                        q, SLOT(slotDropClones()));
+    }
+
+    void startClonesRegeneration(QList<int> frames)
+    {
+        for (auto &clone : clones) {
+            if (frames.isEmpty()) break;
+            if (clone->renderer.isActive()) continue;
+
+            clone->frame = frames.takeFirst();
+            clone->renderer.startFrameRegeneration(clone->image, clone->frame);
+        }
+    }
+
+    bool hasActiveClones() const
+    {
+        for (auto &clone : clones) {
+            if (clone->renderer.isActive()) return true;
+        }
+        return false;
+    }
+
+    void dropClones()
+    {
+        clonesConnections.clear();
+
+        KisImageSP image = clonedImage;
+        if (image) {
+            image->setWorkingThreadsLimit(clonedImageThreadsLimit);
+        }
+        clonedImage = 0;
+
+        /**
+         * The destructor of the image waits for the running frame to
+         * finish, so the clones are not destroyed here. Their strokes
+         * are cancelled and they are released when they become idle.
+         */
+        for (auto &clone : clones) {
+            QObject::disconnect(&clone->renderer, 0, q, 0);
+
+            if (clone->renderer.isActive()) {
+                clone->renderer.cancelCurrentFrameRendering();
+            }
+
+            clone->image->requestStrokeCancellation();
+            droppedClones.push_back(std::move(clone));
+        }
+
+        clones.clear();
+        clonesCache = 0;
+        clonesSkipRange = KisTimeRange();
+
+        if (!droppedClones.empty()) {
+            droppedClonesTimer.start();
+        }
+    }
+
+    void releaseDroppedClones()
+    {
+        droppedClones.erase(
+            std::remove_if(droppedClones.begin(), droppedClones.end(),
+                           [] (const std::unique_ptr<CloneWorker> &clone) {
+                               return clone->image->isIdle();
+                           }),
+            droppedClones.end());
+
+        if (droppedClones.empty()) {
+            droppedClonesTimer.stop();
+        }
+    }
+
     QString debugStateToString(State newState) {
         QString str = "<unknown>";
 
@@ -266,6 +495,7 @@ KisAnimationCachePopulator::KisAnimationCachePopulator(KisPart *part)
     : m_d(new Private(this, part))
 {
     connect(&m_d->timer, SIGNAL(timeout()), this, SLOT(slotTimer()));
+    connect(&m_d->droppedClonesTimer, SIGNAL(timeout()), this, SLOT(slotReleaseDroppedClones()));
 
     connect(&m_d->regenerator, SIGNAL(sigFrameCancelled(int)), SLOT(slotRegeneratorFrameCancelled()));
     connect(&m_d->regenerator, SIGNAL(sigFrameCompleted(int)), SLOT(slotRegeneratorFrameReady()));
@@ -275,7 +505,10 @@ KisAnimationCachePopulator::KisAnimationCachePopulator(KisPart *part)
 }
 
 KisAnimationCachePopulator::~KisAnimationCachePopulator()
-{}
+{
+    // cancel the strokes of the clones before waiting for them
+    m_d->dropClones();
+}
 
 bool KisAnimationCachePopulator::regenerate(KisAnimationFrameCacheSP cache, int frame)
 {
@@ -298,16 +531,51 @@ void KisAnimationCachePopulator::slotRequestRegeneration()
 void KisAnimationCachePopulator::slotRegeneratorFrameCancelled()
 {
     KIS_ASSERT_RECOVER_RETURN(m_d->state == Private::WaitingForFrame);
+    m_d->requestCache = 0;
     m_d->enterState(Private::NotWaitingForAnything);
 }
 
 void KisAnimationCachePopulator::slotRegeneratorFrameReady()
 {
+    m_d->requestCache = 0;
     m_d->enterState(Private::BetweenFrames);
 }
 
+void KisAnimationCachePopulator::slotCloneFrameReady()
+{
+    if (!m_d->clonesCache) return;
+
+    int numIdleClones = 0;
+    for (auto &clone : m_d->clones) {
+        if (!clone->renderer.isActive()) {
+            numIdleClones++;
+        }
+    }
+
+    /**
+     * The clones do not block the user's image, so they continue
+     * regenerating the frames until the image is changed
+     */
+    QList<int> frames = m_d->dirtyFrames(m_d->clonesCache, m_d->clonesSkipRange, numIdleClones);
+    m_d->startClonesRegeneration(frames);
+}
+
+void KisAnimationCachePopulator::slotDropClones()
+{
+    m_d->dropClones();
+}
+
+void KisAnimationCachePopulator::slotReleaseDroppedClones()
+{
+    m_d->releaseDroppedClones();
+}
+
 void KisAnimationCachePopulator::slotConfigChanged()
 {
     KisConfig cfg;
     m_d->calculateAnimationCacheInBackground = cfg.calculateAnimationCacheInBackground();
+
+    if (!m_d->calculateAnimationCacheInBackground) {
+        m_d->dropClones();
+    }
 }
@@ -48,6 +48,10 @@ private Q_SLOTS:
     void slotRegeneratorFrameCancelled();
     void slotRegeneratorFrameReady();
 
+    void slotCloneFrameReady();
+    void slotDropClones();
+    void slotReleaseDroppedClones();
+
     void slotConfigChanged();
 
 private:
@@ -20,8 +20,11 @@
 #include "kis_filter_manager.h"
 
 
+#include <algorithm>
+
 #include <QHash>
 #include <QSignalMapper>
+#include <QWidget>
 
 #include <QMessageBox>
 #include <kactionmenu.h>
@@ -35,10 +38,12 @@
 #include <filter/kis_filter_registry.h>
 #include <filter/kis_filter_configuration.h>
 #include <kis_paint_device.h>
+#include <kis_global.h>
 
 // krita/ui
 #include "KisViewManager.h"
 #include "kis_canvas2.h"
+#include "kis_coordinates_converter.h"
 #include <kis_bookmarked_configuration_manager.h>
 
 #include "kis_action.h"
@@ -67,13 +72,53 @@ struct KisFilterManager::Private {
     KisFilterConfigurationSP lastConfiguration;
     KisFilterConfigurationSP currentlyAppliedConfiguration;
     KisStrokeId currentStrokeId;
+    KisFilterStrokeStrategy::CancellationTokenSP currentCancellationToken;
     QRect initialApplyRect;
 
     QSignalMapper actionsMapper;
 
     QPointer<KisDlgFilter> filterDialog;
+
+    QRect visibleImageRect() const;
+    static void sortPatchesForPreview(QVector<QRect> &patches, const QRect &visibleRect);
 };
 
+QRect KisFilterManager::Private::visibleImageRect() const
+{
+    KisCanvas2 *canvas = view->canvasBase();
+    if (!canvas || !canvas->canvasWidget()) return QRect();
+
+    return canvas->coordinatesConverter()->
+        widgetToImage(QRectF(canvas->canvasWidget()->rect())).toAlignedRect();
+}
+
+/**
+ * The patches are processed roughly in the order they are added
+ * to the stroke, so the visible ones go first, starting from the
+ * center of the viewport. This way the user sees the preview grow
+ * from the place they are looking at instead of from the top-left
+ * corner of the image.
+ */
+void KisFilterManager::Private::sortPatchesForPreview(QVector<QRect> &patches, const QRect &visibleRect)
+{
+    if (visibleRect.isEmpty()) return;
+
+    const QPointF center = QRectF(visibleRect).center();
+
+    std::stable_sort(patches.begin(), patches.end(),
+        [visibleRect, center] (const QRect &lhs, const QRect &rhs) {
+            const bool lhsVisible = lhs.intersects(visibleRect);
+            const bool rhsVisible = rhs.intersects(visibleRect);
+
+            if (lhsVisible != rhsVisible) {
+                return lhsVisible;
+            }
+
+            return kisSquareDistance(QRectF(lhs).center(), center) <
+                kisSquareDistance(QRectF(rhs).center(), center);
+        });
+}
+
 KisFilterManager::KisFilterManager(KisViewManager * view)
     : d(new Private)
 {
@@ -251,6 +296,9 @@ void KisFilterManager::apply(KisFilterConfigurationSP filterConfig)
     KisImageWSP image = d->view->image();
 
     if (d->currentStrokeId) {
+        // don't wait for the patches of the outdated preview to complete
+        d->currentCancellationToken->requestCancellation();
+
         image->addJob(d->currentStrokeId, new KisFilterStrokeStrategy::CancelSilentlyMarker);
         image->cancelStroke(d->currentStrokeId);
         d->currentStrokeId.clear();
@@ -276,10 +324,13 @@ void KisFilterManager::apply(KisFilterConfigurationSP filterConfig)
                                  d->view->activeNode(),
                                  resourceManager);
 
-    d->currentStrokeId =
-        image->startStroke(new KisFilterStrokeStrategy(filter,
-                                                       KisFilterConfigurationSP(filterConfig),
-                                                       resources));
+    KisFilterStrokeStrategy *strategy =
+        new KisFilterStrokeStrategy(filter,
+                                    KisFilterConfigurationSP(filterConfig),
+                                    resources);
+
+    d->currentCancellationToken = strategy->cancellationToken();
+    d->currentStrokeId = image->startStroke(strategy);
 
     QRect processRect = filter->changedRect(applyRect, filterConfig.data(), 0);
     processRect &= image->bounds();
@@ -287,6 +338,7 @@ void KisFilterManager::apply(KisFilterConfigurationSP filterConfig)
     if (filter->supportsThreading()) {
         QSize size = KritaUtils::optimalPatchSize();
         QVector<QRect> rects = KritaUtils::splitRectIntoPatches(processRect, size);
+        Private::sortPatchesForPreview(rects, d->visibleImageRect());
 
         Q_FOREACH (const QRect &rc, rects) {
             image->addJob(d->currentStrokeId,
@@ -317,6 +369,7 @@ void KisFilterManager::finish()
     d->reapplyAction->setText(i18n("Apply Filter Again: %1", filter->name()));
 
     d->currentStrokeId.clear();
+    d->currentCancellationToken.clear();
     d->currentlyAppliedConfiguration.clear();
 }
 
@@ -324,9 +377,11 @@ void KisFilterManager::cancel()
 {
     Q_ASSERT(d->currentStrokeId);
 
+    d->currentCancellationToken->requestCancellation();
     d->view->image()->cancelStroke(d->currentStrokeId);
 
     d->currentStrokeId.clear();
+    d->currentCancellationToken.clear();
     d->currentlyAppliedConfiguration.clear();
 }
 
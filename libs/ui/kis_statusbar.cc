@@ -294,9 +294,9 @@ void KisStatusBar::updateMemoryStatus()
                   "Memory used:\t %1 / %2\n"
                   "  image data:\t %3 / %4\n"
                   "  pool:\t\t %5 / %6\n"
-                  "  undo data:\t %7\n"
+                  "  undo data:\t %7 / %8\n"
                   "\n"
-                  "Swap used:\t %8",
+                  "Swap used:\t %9",
                   formatSize(stats.totalMemorySize),
                   formatSize(stats.totalMemoryLimit),
 
@@ -307,6 +307,9 @@ void KisStatusBar::updateMemoryStatus()
                   formatSize(stats.tilesPoolLimit),
 
                   formatSize(stats.historicalMemorySize),
+                  stats.historicalMemoryLimit > 0 ?
+                      formatSize(stats.historicalMemoryLimit) :
+                      i18nc("no limit for the undo data", "unlimited"),
                   formatSize(stats.swapSize));
 
     QString longStats = imageStatsMsg + "\n" + memoryStatsMsg;
@@ -20,6 +20,7 @@
 
 #include <QTimer>
 #include <QQueue>
+#include <QElapsedTimer>
 
 #include <klocalizedstring.h>
 
@@ -39,6 +40,7 @@
 #include "kis_stabilized_events_sampler.h"
 #include "KisStabilizerDelayedPaintHelper.h"
 #include "kis_config.h"
+#include "kis_pointer_utils.h"
 
 
 #include <math.h>
@@ -58,6 +60,16 @@ const qreal SPACING_UPDATE_INTERVAL = 50.0;
 // used when airbrushing.
 const qreal TIMING_UPDATE_INTERVAL = 50.0;
 
+// The maximum number of segments collected into a single stroke job.
+const int MAX_BATCH_SIZE = 64;
+
+// The maximum time, in milliseconds, the segments may wait for the scheduler to process the
+// previous batches. After that they are sent anyway, so the stroke doesn't stall visibly.
+const int MAX_BATCH_LATENCY = 30;
+
+// The interval, in milliseconds, of checking whether the pending segments can be sent.
+const int BATCH_FLUSH_INTERVAL = 5;
+
 struct KisToolFreehandHelper::Private
 {
     KisPaintingInformationBuilder *infoBuilder;
@@ -104,6 +116,17 @@ struct KisToolFreehandHelper::Private
     int canvasRotation;
     bool canvasMirroredH;
 
+    /**
+     * The segments are not sent to the strokes queue one by one. While
+     * the scheduler is still busy with the previous batches, new segments
+     * are collected into a pending batch, so its size adapts to the
+     * throughput of the scheduler.
+     */
+    QVector<FreehandStrokeStrategy::Data*> pendingJobs;
+    QSharedPointer<QAtomicInt> queuedBatches;
+    QTimer batchFlushTimer;
+    QElapsedTimer pendingJobsAge;
+
     qreal effectiveSmoothnessDistance() const;
 };
 
@@ -120,6 +143,10 @@ KisToolFreehandHelper::KisToolFreehandHelper(KisPaintingInformationBuilder *info
     m_d->smoothingOptions = KisSmoothingOptionsSP(
                 smoothingOptions ? smoothingOptions : new KisSmoothingOptions());
     m_d->canvasRotation = 0;
+    m_d->queuedBatches = toQShared(new QAtomicInt(0));
+
+    m_d->batchFlushTimer.setInterval(BATCH_FLUSH_INTERVAL);
+    connect(&m_d->batchFlushTimer, SIGNAL(timeout()), SLOT(tryFlushPendingJobs()));
 
     m_d->strokeTimeoutTimer.setSingleShot(true);
     connect(&m_d->strokeTimeoutTimer, SIGNAL(timeout()), SLOT(finishStroke()));
@@ -138,6 +165,7 @@ KisToolFreehandHelper::KisToolFreehandHelper(KisPaintingInformationBuilder *info
 
 KisToolFreehandHelper::~KisToolFreehandHelper()
 {
+    qDeleteAll(m_d->pendingJobs);
     delete m_d;
 }
 
@@ -321,6 +349,7 @@ void KisToolFreehandHelper::initPaintImpl(qreal startAngle,
     // information until paintAt is called.
     if (airbrushing) {
         paintAt(pi);
+        tryFlushPendingJobs();
     }
 }
 
@@ -426,6 +455,9 @@ qreal KisToolFreehandHelper::Private::effectiveSmoothnessDistance() const
 
 void KisToolFreehandHelper::paintEvent(KoPointerEvent *event)
 {
+    QElapsedTimer eventTime;
+    eventTime.start();
+
     KisPaintInformation info =
             m_d->infoBuilder->continueStroke(event,
                                              elapsedStrokeTime());
@@ -435,6 +467,9 @@ void KisToolFreehandHelper::paintEvent(KoPointerEvent *event)
     KisUpdateTimeMonitor::instance()->reportMouseMove(info.pos());
 
     paint(info);
+    tryFlushPendingJobs();
+
+    KisUpdateTimeMonitor::instance()->reportGuiEventTime(eventTime.nsecsElapsed());
 }
 
 void KisToolFreehandHelper::paint(KisPaintInformation &info)
@@ -625,6 +660,7 @@ void KisToolFreehandHelper::endPaint()
      */
     m_d->painterInfos.clear();
 
+    flushPendingJobs();
     m_d->strokesFacade->endStroke(m_d->strokeId);
     m_d->strokeId.clear();
 
@@ -654,6 +690,8 @@ void KisToolFreehandHelper::cancelPaint()
     // see a comment in endPaint()
     m_d->painterInfos.clear();
 
+    cancelPendingJobs();
+
     m_d->strokesFacade->cancelStroke(m_d->strokeId);
     m_d->strokeId.clear();
 
@@ -800,6 +838,8 @@ void KisToolFreehandHelper::stabilizerPollAndPaint()
     } else {
         emit requestExplicitUpdateOutline();
     }
+
+    tryFlushPendingJobs();
 }
 
 void KisToolFreehandHelper::stabilizerEnd()
@@ -839,6 +879,8 @@ void KisToolFreehandHelper::finishStroke()
                            m_d->previousPaintInformation,
                            m_d->previousTangent,
                            newTangent);
+
+        tryFlushPendingJobs();
     }
 }
 
@@ -860,6 +902,7 @@ void KisToolFreehandHelper::doAirbrushing()
                                       elapsedStrokeTime(),
                                       0.0);
         paint(nextPaint);
+        tryFlushPendingJobs();
     }
 }
 
@@ -869,13 +912,64 @@ int KisToolFreehandHelper::computeAirbrushTimerInterval() const
     return qMax(1, qFloor(realInterval));
 }
 
+void KisToolFreehandHelper::addJobToBatch(FreehandStrokeStrategy::Data *data)
+{
+    if (m_d->pendingJobs.isEmpty()) {
+        m_d->pendingJobsAge.start();
+        m_d->batchFlushTimer.start();
+    }
+
+    m_d->pendingJobs.append(data);
+
+    if (m_d->pendingJobs.size() >= MAX_BATCH_SIZE) {
+        flushPendingJobs();
+    }
+}
+
+void KisToolFreehandHelper::tryFlushPendingJobs()
+{
+    if (m_d->pendingJobs.isEmpty()) return;
+
+    /**
+     * When the scheduler has processed all the previous batches, the
+     * segments are sent immediately, so the latency is the same as
+     * without batching. Otherwise the new segments would just wait in
+     * the strokes queue, so they are coalesced with the following ones.
+     */
+    if (m_d->queuedBatches->load() <= 0 ||
+        m_d->pendingJobsAge.elapsed() >= MAX_BATCH_LATENCY) {
+
+        flushPendingJobs();
+    }
+}
+
+void KisToolFreehandHelper::flushPendingJobs()
+{
+    m_d->batchFlushTimer.stop();
+
+    if (m_d->pendingJobs.isEmpty()) return;
+
+    m_d->queuedBatches->ref();
+    m_d->strokesFacade->addJob(m_d->strokeId,
+                               new FreehandStrokeStrategy::BatchData(m_d->pendingJobs,
+                                                                     m_d->queuedBatches));
+    m_d->pendingJobs.clear();
+}
+
+void KisToolFreehandHelper::cancelPendingJobs()
+{
+    m_d->batchFlushTimer.stop();
+
+    qDeleteAll(m_d->pendingJobs);
+    m_d->pendingJobs.clear();
+}
+
 void KisToolFreehandHelper::paintAt(int painterInfoId,
                                     const KisPaintInformation &pi)
 {
     m_d->hasPaintAtLeastOnce = true;
-    m_d->strokesFacade->addJob(m_d->strokeId,
-                               new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
-                                                                painterInfoId, pi));
+    addJobToBatch(new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
+                                                    painterInfoId, pi));
 
     if(m_d->recordingAdapter) {
         m_d->recordingAdapter->addPoint(pi);
@@ -887,9 +981,8 @@ void KisToolFreehandHelper::paintLine(int painterInfoId,
                                       const KisPaintInformation &pi2)
 {
     m_d->hasPaintAtLeastOnce = true;
-    m_d->strokesFacade->addJob(m_d->strokeId,
-                               new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
-                                                                painterInfoId, pi1, pi2));
+    addJobToBatch(new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
+                                                    painterInfoId, pi1, pi2));
 
     if(m_d->recordingAdapter) {
         m_d->recordingAdapter->addLine(pi1, pi2);
@@ -927,10 +1020,9 @@ void KisToolFreehandHelper::paintBezierCurve(int painterInfoId,
 #endif
 
     m_d->hasPaintAtLeastOnce = true;
-    m_d->strokesFacade->addJob(m_d->strokeId,
-                               new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
-                                                                painterInfoId,
-                                                                pi1, control1, control2, pi2));
+    addJobToBatch(new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
+                                                    painterInfoId,
+                                                    pi1, control1, control2, pi2));
 
     if(m_d->recordingAdapter) {
         m_d->recordingAdapter->addCurve(pi1, control1, control2, pi2);
@@ -148,11 +148,16 @@ private:
                                                const KisPaintInformation &lastPaintInfo);
     int computeAirbrushTimerInterval() const;
 
+    void addJobToBatch(FreehandStrokeStrategy::Data *data);
+    void flushPendingJobs();
+    void cancelPendingJobs();
+
 private Q_SLOTS:
 
     void finishStroke();
     void doAirbrushing();
     void stabilizerPollAndPaint();
+    void tryFlushPendingJobs();
 
 private:
     struct Private;
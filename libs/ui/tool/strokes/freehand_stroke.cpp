@@ -85,11 +85,53 @@ void FreehandStrokeStrategy::init(bool needsIndirectPainting,
 
 void FreehandStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
 {
+    KisRandomSourceSP rnd = m_d->randomSource.source();
+
+    if (BatchData *batch = dynamic_cast<BatchData*>(data)) {
+        KisNodeSP currentNode;
+        QVector<QRect> nodeDirtyRects;
+        QVector<QRect> allDirtyRects;
+
+        /**
+         * All the items of a batch usually belong to the same node, so
+         * it is updated only once with all the dirty rects of the batch
+         */
+        Q_FOREACH (Data *item, batch->items) {
+            if (item->node != currentNode) {
+                if (currentNode) {
+                    currentNode->setDirty(nodeDirtyRects);
+                    nodeDirtyRects.clear();
+                }
+                currentNode = item->node;
+            }
+
+            const QVector<QRect> rects = paintData(item, rnd);
+            nodeDirtyRects += rects;
+            allDirtyRects += rects;
+        }
+
+        if (currentNode) {
+            currentNode->setDirty(nodeDirtyRects);
+        }
+
+        batch->releaseQueueSlot();
+
+        KisUpdateTimeMonitor::instance()->reportJobFinished(data, allDirtyRects);
+        return;
+    }
+
     Data *d = dynamic_cast<Data*>(data);
+
+    QVector<QRect> dirtyRects = paintData(d, rnd);
+    KisUpdateTimeMonitor::instance()->reportJobFinished(data, dirtyRects);
+    d->node->setDirty(dirtyRects);
+}
+
+QVector<QRect> FreehandStrokeStrategy::paintData(Data *d, KisRandomSourceSP rnd)
+{
     PainterInfo *info = painterInfos()[d->painterInfoId];
 
     KisUpdateTimeMonitor::instance()->reportPaintOpPreset(info->painter->preset());
-    KisRandomSourceSP rnd = m_d->randomSource.source();
 
     switch(d->type) {
     case Data::POINT:
@@ -135,9 +177,7 @@ void FreehandStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
         break;
     };
 
-    QVector<QRect> dirtyRects = info->painter->takeDirtyRegion();
-    KisUpdateTimeMonitor::instance()->reportJobFinished(data, dirtyRects);
-    d->node->setDirty(dirtyRects);
+    return info->painter->takeDirtyRegion();
 }
 
 KisStrokeStrategy* FreehandStrokeStrategy::createLodClone(int levelOfDetail)
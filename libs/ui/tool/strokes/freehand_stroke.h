@@ -28,6 +28,9 @@
 #include "kis_lod_transform.h"
 #include "KoColor.h"
 
+#include <QAtomicInt>
+#include <QSharedPointer>
+
 
 
 class KRITAUI_EXPORT FreehandStrokeStrategy : public KisPainterBasedStrokeStrategy
@@ -171,6 +174,68 @@ public:
         KoColor customColor;
     };
 
+    /**
+     * A few consecutive painting jobs executed as a single stroke job.
+     * The freehand helper collects the segments into a batch while the
+     * scheduler is busy, so the strokes queue is not flooded with tiny
+     * jobs and the node is updated once per batch.
+     *
+     * If \p _queuedCounter is set, it is decremented when the batch is
+     * processed or destroyed (cancelled). The batch and its LoD clone
+     * share the same slot in the counter, which is released by the one
+     * that is processed first: with Instant Preview the clone is painted
+     * by the LoD stroke, while the original waits for the end of it.
+     */
+    class BatchData : public KisStrokeJobData {
+        struct QueueSlot {
+            QueueSlot(QSharedPointer<QAtomicInt> _counter)
+                : counter(_counter), released(0) {}
+
+            QSharedPointer<QAtomicInt> counter;
+            QAtomicInt released;
+        };
+
+    public:
+        BatchData(const QVector<Data*> &_items,
+                  QSharedPointer<QAtomicInt> _queuedCounter = QSharedPointer<QAtomicInt>())
+            : items(_items)
+        {
+            if (_queuedCounter) {
+                queueSlot.reset(new QueueSlot(_queuedCounter));
+            }
+        }
+
+        ~BatchData() override {
+            qDeleteAll(items);
+            releaseQueueSlot();
+        }
+
+        KisStrokeJobData* createLodClone(int levelOfDetail) override {
+            QVector<Data*> clonedItems;
+            clonedItems.reserve(items.size());
+
+            Q_FOREACH (Data *item, items) {
+                clonedItems << static_cast<Data*>(item->createLodClone(levelOfDetail));
+            }
+
+            BatchData *clone = new BatchData(clonedItems);
+            clone->queueSlot = queueSlot;
+            return clone;
+        }
+
+        void releaseQueueSlot() {
+            if (queueSlot && queueSlot->released.testAndSetOrdered(0, 1)) {
+                queueSlot->counter->deref();
+            }
+        }
+
+    public:
+        QVector<Data*> items;
+
+    private:
+        QSharedPointer<QueueSlot> queueSlot;
+    };
+
 public:
     FreehandStrokeStrategy(bool needsIndirectPainting,
                            const QString &indirectPaintingCompositeOp,
@@ -195,6 +260,7 @@ protected:
 
 private:
     void init(bool needsIndirectPainting, const QString &indirectPaintingCompositeOp);
+    QVector<QRect> paintData(Data *d, KisRandomSourceSP rnd);
 
 private:
     struct Private;
@@ -22,6 +22,7 @@
 #include <filter/kis_filter_configuration.h>
 #include <kis_transaction.h>
 #include <KoCompositeOpRegistry.h>
+#include <KoUpdater.h>
 
 
 struct KisFilterStrokeStrategy::Private {
@@ -29,7 +30,8 @@ struct KisFilterStrokeStrategy::Private {
         : updatesFacade(0),
           cancelSilently(false),
           secondaryTransaction(0),
-          levelOfDetail(0)
+          levelOfDetail(0),
+          cancellationToken(new CancellationToken)
     {
     }
 
@@ -43,7 +45,8 @@ struct KisFilterStrokeStrategy::Private {
           filterDeviceBounds(),
           secondaryTransaction(0),
           progressHelper(),
-          levelOfDetail(0)
+          levelOfDetail(0),
+          cancellationToken(rhs.cancellationToken)
     {
         KIS_ASSERT_RECOVER_RETURN(!rhs.filterDevice);
         KIS_ASSERT_RECOVER_RETURN(rhs.filterDeviceBounds.isEmpty());
@@ -64,9 +67,62 @@ struct KisFilterStrokeStrategy::Private {
     QScopedPointer<KisProcessingVisitor::ProgressHelper> progressHelper;
 
     int levelOfDetail;
+
+    CancellationTokenSP cancellationToken;
 };
 
 
+void KisFilterStrokeStrategy::CancellationToken::requestCancellation()
+{
+    m_cancellationRequested.ref();
+
+    QMutexLocker l(&m_mutex);
+    Q_FOREACH (QPointer<KoUpdater> updater, m_activeUpdaters) {
+        interruptUpdater(updater);
+    }
+}
+
+bool KisFilterStrokeStrategy::CancellationToken::isCancellationRequested() const
+{
+    return m_cancellationRequested.load();
+}
+
+void KisFilterStrokeStrategy::CancellationToken::registerUpdater(KoUpdater *updater)
+{
+    if (!updater) return;
+
+    QMutexLocker l(&m_mutex);
+    m_activeUpdaters.append(updater);
+
+    // the cancellation might have been requested before we took the lock
+    if (isCancellationRequested()) {
+        interruptUpdater(updater);
+    }
+}
+
+void KisFilterStrokeStrategy::CancellationToken::unregisterUpdater(KoUpdater *updater)
+{
+    if (!updater) return;
+
+    QMutexLocker l(&m_mutex);
+    m_activeUpdaters.removeOne(updater);
+}
+
+void KisFilterStrokeStrategy::CancellationToken::interruptUpdater(KoUpdater *updater)
+{
+    if (!updater) return;
+
+    /**
+     * The updater lives in the thread of the node (ProgressHelper moves
+     * it there), which may be busy, so the slot is called directly
+     * instead of being queued. The interrupted flag is atomic; the
+     * filters poll interrupted() and return as soon as they notice it.
+     */
+    QMetaObject::invokeMethod(updater, "setInterrupted",
+                              Qt::DirectConnection, Q_ARG(bool, true));
+}
+
+
 KisFilterStrokeStrategy::KisFilterStrokeStrategy(KisFilterSP filter,
                                                  KisFilterConfigurationSP filterConfig,
                                                  KisResourcesSnapshotSP resources)
@@ -136,15 +192,25 @@ void KisFilterStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
     if (d) {
         const QRect rc = d->processRect;
 
+        if (m_d->cancellationToken->isCancellationRequested()) return;
+
         if (!m_d->filterDeviceBounds.intersects(
                 m_d->filter->neededRect(rc, m_d->filterConfig.data(), m_d->levelOfDetail))) {
 
             return;
         }
 
+        KoUpdater *updater = m_d->progressHelper->updater();
+        m_d->cancellationToken->registerUpdater(updater);
+
         m_d->filter->processImpl(m_d->filterDevice, rc,
                                  m_d->filterConfig.data(),
-                                 m_d->progressHelper->updater());
+                                 updater);
+
+        m_d->cancellationToken->unregisterUpdater(updater);
+
+        // the patch is incomplete, the stroke is going to be cancelled anyway
+        if (m_d->cancellationToken->isCancellationRequested()) return;
 
         if (m_d->secondaryTransaction) {
             KisPainter::copyAreaOptimized(rc.topLeft(), m_d->filterDevice, targetDevice(), rc, activeSelection());
@@ -206,3 +272,8 @@ KisStrokeStrategy* KisFilterStrokeStrategy::createLodClone(int levelOfDetail)
     KisFilterStrokeStrategy *clone = new KisFilterStrokeStrategy(*this, levelOfDetail);
     return clone;
 }
+
+KisFilterStrokeStrategy::CancellationTokenSP KisFilterStrokeStrategy::cancellationToken() const
+{
+    return m_d->cancellationToken;
+}
@@ -19,10 +19,18 @@
 #ifndef __KIS_FILTER_STROKE_STRATEGY_H
 #define __KIS_FILTER_STROKE_STRATEGY_H
 
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+#include <QSharedPointer>
+
 #include "kis_types.h"
 #include "kis_painter_based_stroke_strategy.h"
 #include "kis_lod_transform.h"
 
+class KoUpdater;
+
 
 class KRITAUI_EXPORT KisFilterStrokeStrategy : public KisPainterBasedStrokeStrategy
 {
@@ -60,6 +68,35 @@ public:
         }
     };
 
+    /**
+     * The token is shared by the stroke, its LoD clone and the owner of
+     * the stroke. Cancelling the stroke drops only the patches that have
+     * not been started yet, so before cancelling the owner should call
+     * requestCancellation() to interrupt the patches that are being
+     * filtered right now. Otherwise a slow filter would delay the
+     * preview of the new parameters by a whole patch.
+     */
+    class KRITAUI_EXPORT CancellationToken {
+    public:
+        void requestCancellation();
+        bool isCancellationRequested() const;
+
+    private:
+        friend class KisFilterStrokeStrategy;
+
+        void registerUpdater(KoUpdater *updater);
+        void unregisterUpdater(KoUpdater *updater);
+
+        static void interruptUpdater(KoUpdater *updater);
+
+    private:
+        QAtomicInt m_cancellationRequested;
+        QMutex m_mutex;
+        QList<QPointer<KoUpdater>> m_activeUpdaters;
+    };
+
+    typedef QSharedPointer<CancellationToken> CancellationTokenSP;
+
 public:
     KisFilterStrokeStrategy(KisFilterSP filter,
                             KisFilterConfigurationSP filterConfig,
@@ -76,6 +113,8 @@ public:
 
     KisStrokeStrategy* createLodClone(int levelOfDetail) override;
 
+    CancellationTokenSP cancellationToken() const;
+
 private:
     struct Private;
     Private* const m_d;
@@ -37,7 +37,7 @@ KoUpdater::KoUpdater(KoUpdaterPrivate *_d)
 
 
     setRange(0, 100);
-    m_interrupted = false;
+    m_interrupted.storeRelease(false);
 }
 
 KoUpdater::~KoUpdater()
@@ -64,7 +64,7 @@ int KoUpdater::progress() const
 
 bool KoUpdater::interrupted() const
 {
-    return m_interrupted;
+    return m_interrupted.loadAcquire();
 }
 
 int KoUpdater::maximum() const
@@ -107,7 +107,8 @@ void KoUpdater::setAutoNestedName(const QString &name)
 
 void KoUpdater::setInterrupted(bool value)
 {
-    m_interrupted = true;
+    Q_UNUSED(value);
+    m_interrupted.storeRelease(true);
 }
 
 KoDummyUpdater::KoDummyUpdater()
@@ -24,6 +24,7 @@
 #include "KoProgressProxy.h"
 #include <QObject>
 #include <QPointer>
+#include <QAtomicInt>
 
 class KoProgressUpdater;
 class KoUpdaterPrivate;
@@ -119,7 +120,8 @@ private Q_SLOTS:
 
 private:
 
-    bool m_interrupted;
+    // set from the GUI thread, polled by the workers
+    QAtomicInt m_interrupted;
     int  m_progressPercent;
 };
 
@@ -25,17 +25,16 @@
 
 #include "kis_oilpaint_filter.h"
 
-#include <stdlib.h>
-#include <vector>
+#include <algorithm>
 
 #include <QPoint>
 #include <QSpinBox>
-#include <QDateTime>
 
 #include <klocalizedstring.h>
 #include <kis_debug.h>
 #include <kpluginfactory.h>
 
+#include <KoColorSpace.h>
 #include <KoUpdater.h>
 
 #include <KisDocument.h>
@@ -48,157 +47,161 @@
 #include <filter/kis_filter_configuration.h>
 #include <kis_processing_information.h>
 #include <kis_paint_device.h>
+#include <kis_default_bounds_base.h>
+#include <kis_sliding_histogram.h>
 #include "widgets/kis_multi_integer_filter_widget.h"
 
 
-KisOilPaintFilter::KisOilPaintFilter() : KisFilter(id(), KisFilter::categoryArtistic(), i18n("&Oilpaint..."))
-{
-    setSupportsPainting(true);
-    setSupportsThreading(false);
-    setSupportsAdjustmentLayers(true);
-}
-
-void KisOilPaintFilter::processImpl(KisPaintDeviceSP device,
-                                    const QRect& applyRect,
-                                    const KisFilterConfigurationSP config,
-                                    KoUpdater* progressUpdater
-                                    ) const
-{
-    QPoint srcTopLeft = applyRect.topLeft();
-    Q_ASSERT(!device.isNull());
-
-    qint32 width = applyRect.width();
-    qint32 height = applyRect.height();
-
-    //read the filter configuration values from the KisFilterConfiguration object
-    quint32 brushSize = config ? config->getInt("brushSize", 1) : 1;
-    quint32 smooth = config ? config->getInt("smooth", 30) : 30;
-
-    OilPaint(device, device, srcTopLeft, applyRect.topLeft(), width, height, brushSize, smooth, progressUpdater);
-}
+namespace {
 
-// This method have been ported from Pieter Z. Voloshyn algorithm code.
+// This class has been ported from Pieter Z. Voloshyn's algorithm code in Digikam.
 
-/* Function to apply the OilPaint effect.
- *
- * data             => The image data in RGBA mode.
- * w                => Width of image.
- * h                => Height of image.
- * BrushSize        => Brush size.
- * Smoothness       => Smooth value.
- *
- * Theory           => Using MostFrequentColor function we take the main color in
- *                     a matrix and simply write at the original position.
+/**
+ * Finds the most frequent color in the window: the pixels are binned by
+ * their intensity, the result is the average color of the fullest bin.
+ * The window is slided by KisSlidingHistogram, so the bins are updated
+ * incrementally instead of being recounted for every pixel.
  */
-
-void KisOilPaintFilter::OilPaint(const KisPaintDeviceSP src, KisPaintDeviceSP dst, const QPoint& srcTopLeft, const QPoint& dstTopLeft, int w, int h,
-                                 int BrushSize, int Smoothness, KoUpdater* progressUpdater) const
+class MostFrequentColorHistogram
 {
-    if (progressUpdater) {
-        progressUpdater->setRange(0, w * h);
+public:
+    MostFrequentColorHistogram(const KoColorSpace *cs, int intensity)
+        : m_cs(cs),
+          m_channelCount(cs->channelCount()),
+          m_scale(intensity / 255.0),
+          m_counts(intensity + 1),
+          m_sums((intensity + 1) * m_channelCount),
+          m_channels(m_channelCount)
+    {
     }
 
-    QRect bounds(srcTopLeft.x(), srcTopLeft.y(), w, h);
+    int sampleSize() const {
+        return 1 + m_channelCount;
+    }
 
-    KisHLineConstIteratorSP it = src->createHLineConstIteratorNG(srcTopLeft.x(), srcTopLeft.y(), w);
-    KisHLineIteratorSP dstIt = dst->createHLineIteratorNG(dstTopLeft.x(), dstTopLeft.y(), w);
+    void sample(const quint8 *pixel, float *sample) {
+        m_cs->normalisedChannelsValue(pixel, m_channels);
 
-    int progress = 0;
-    for (qint32 yOffset = 0; yOffset < h; yOffset++) {
-        do {  //&& !cancelRequested()) {
-                MostFrequentColor(src, dstIt->rawData(), bounds, it->x(), it->y(), BrushSize, Smoothness);
-        }  while (it->nextPixel() && dstIt->nextPixel());
-        it->nextRow();
-        dstIt->nextRow();
+        sample[0] = uint(m_cs->intensity8(pixel) * m_scale);
+        std::copy(m_channels.constBegin(), m_channels.constEnd(), sample + 1);
+    }
 
-        if (progressUpdater) progressUpdater->setValue(progress += w);
+    void reset() {
+        m_counts.fill(0);
+        m_sums.fill(0.0);
     }
-}
 
-// This method has been ported from Pieter Z. Voloshyn's algorithm code in Digikam.
+    void addSample(const float *sample) {
+        const int bin = int(sample[0]);
+        double *sums = m_sums.data() + bin * m_channelCount;
 
-/* Function to determine the most frequent color in a matrix
- *
- * Bits             => Bits array
- * Width            => Image width
- * Height           => Image height
- * X                => Position horizontal
- * Y                => Position vertical
- * Radius           => Is the radius of the matrix to be analyzed
- * Intensity        => Intensity to calculate
- *
- * Theory           => This function creates a matrix with the analyzed pixel in
- *                     the center of this matrix and find the most frequenty color
- */
+        m_counts[bin]++;
+        for (int i = 0; i < m_channelCount; i++) {
+            sums[i] += sample[i + 1];
+        }
+    }
 
-void KisOilPaintFilter::MostFrequentColor(KisPaintDeviceSP src, quint8* dst, const QRect& bounds, int X, int Y, int Radius, int Intensity) const
-{
-    uint I;
+    void removeSample(const float *sample) {
+        const int bin = int(sample[0]);
+        double *sums = m_sums.data() + bin * m_channelCount;
+
+        if (--m_counts[bin]) {
+            for (int i = 0; i < m_channelCount; i++) {
+                sums[i] -= sample[i + 1];
+            }
+        } else {
+            // drop the rounding errors collected by the empty bin
+            std::fill(sums, sums + m_channelCount, 0.0);
+        }
+    }
 
-    double Scale = Intensity / 255.0;
+    void writeResult(quint8 *dst) {
+        int bin = 0;
+        int maxInstance = 0;
 
-    // Alloc some arrays to be used
-    uchar *IntensityCount = new uchar[(Intensity + 1) * sizeof(uchar)];
+        for (int i = 0; i < m_counts.size(); i++) {
+            if (m_counts[i] > maxInstance) {
+                bin = i;
+                maxInstance = m_counts[i];
+            }
+        }
 
-    const KoColorSpace* cs = src->colorSpace();
+        if (maxInstance != 0) {
+            const double *sums = m_sums.constData() + bin * m_channelCount;
+            for (int i = 0; i < m_channelCount; i++) {
+                m_channels[i] = sums[i] / maxInstance;
+            }
+            m_cs->fromNormalisedChannelsValue(dst, m_channels);
+        } else {
+            memset(dst, 0, m_cs->pixelSize());
+            m_cs->setOpacity(dst, OPACITY_OPAQUE_U8, 1);
+        }
+    }
 
-    QVector<float> channel(cs->channelCount());
-    QVector<float>* AverageChannels = new QVector<float>[(Intensity + 1)];
+private:
+    const KoColorSpace *m_cs;
+    int m_channelCount;
+    double m_scale;
 
-    // Erase the array
-    memset(IntensityCount, 0, (Intensity + 1) * sizeof(uchar));
+    QVector<int> m_counts;
+    QVector<double> m_sums;
+    QVector<float> m_channels;
+};
 
-    int startx = qMax(X - Radius, bounds.left());
-    int starty = qMax(Y - Radius, bounds.top());
-    int width = (2 * Radius) + 1;
-    if ((startx + width - 1) > bounds.right()) width = bounds.right() - startx + 1;
-    Q_ASSERT((startx + width - 1) <= bounds.right());
-    int height = (2 * Radius) + 1;
-    if ((starty + height) > bounds.bottom()) height = bounds.bottom() - starty + 1;
-    Q_ASSERT((starty + height - 1) <= bounds.bottom());
-    KisSequentialConstIterator srcIt(src, QRect(startx, starty, width, height));
-    do {
+}
 
-        cs->normalisedChannelsValue(srcIt.rawDataConst(), channel);
+KisOilPaintFilter::KisOilPaintFilter() : KisFilter(id(), KisFilter::categoryArtistic(), i18n("&Oilpaint..."))
+{
+    setSupportsPainting(true);
+    /**
+     * The patches must not be processed concurrently: the snapshot
+     * below would see the pixels written by the neighbouring patches.
+     * KisSlidingHistogram splits the area into strips itself.
+     */
+    setSupportsThreading(false);
+    setSupportsAdjustmentLayers(true);
+}
 
-        I = (uint)(cs->intensity8(srcIt.rawDataConst()) * Scale);
-        IntensityCount[I]++;
+void KisOilPaintFilter::processImpl(KisPaintDeviceSP device,
+                                    const QRect& applyRect,
+                                    const KisFilterConfigurationSP config,
+                                    KoUpdater* progressUpdater
+                                    ) const
+{
+    Q_ASSERT(!device.isNull());
 
-        if (IntensityCount[I] == 1) {
-            AverageChannels[I] = channel;
-        } else {
-            for (int i = 0; i < channel.size(); i++) {
-                AverageChannels[I][i] += channel[i];
-            }
-        }
-    } while (srcIt.nextPixel());
+    //read the filter configuration values from the KisFilterConfiguration object
+    quint32 brushSize = config ? config->getInt("brushSize", 1) : 1;
+    quint32 smooth = config ? config->getInt("smooth", 30) : 30;
 
-    I = 0;
-    int MaxInstance = 0;
+    /**
+     * The pixels are read from a snapshot of the device, so the strips
+     * of this call never see each other's filtered pixels. The tiles
+     * of the snapshot are shared with the device until they are written.
+     */
+    KisPaintDeviceSP src = new KisPaintDevice(*device);
 
-    for (int i = 0 ; i <= Intensity ; ++i) {
-        if (IntensityCount[i] > MaxInstance) {
-            I = i;
-            MaxInstance = IntensityCount[i];
-        }
-    }
+    const QRect sourceBounds =
+        neededRect(applyRect, config, device->defaultBounds()->currentLevelOfDetail()) &
+        device->defaultBounds()->bounds();
 
-    if (MaxInstance != 0) {
-        channel = AverageChannels[I];
-        for (int i = 0; i < channel.size(); i++) {
-            channel[i] /= MaxInstance;
-        }
-        cs->fromNormalisedChannelsValue(dst, channel);
-    } else {
-        memset(dst, 0, cs->pixelSize());
-        cs->setOpacity(dst, OPACITY_OPAQUE_U8, 1);
-    }
+    KisSlidingHistogram::apply(src, device, applyRect, sourceBounds, brushSize,
+                               MostFrequentColorHistogram(device->colorSpace(), smooth),
+                               progressUpdater);
+}
 
+QRect KisOilPaintFilter::neededRect(const QRect & rect, const KisFilterConfigurationSP config, int lod) const
+{
+    Q_UNUSED(lod);
 
-    delete [] IntensityCount;        // free all the arrays
-    delete [] AverageChannels;
+    const int brushSize = config ? config->getInt("brushSize", 1) : 1;
+    return rect.adjusted(-brushSize, -brushSize, brushSize, brushSize);
 }
 
+QRect KisOilPaintFilter::changedRect(const QRect & rect, const KisFilterConfigurationSP config, int lod) const
+{
+    return neededRect(rect, config, lod);
+}
 
 KisConfigWidget * KisOilPaintFilter::createConfigurationWidget(QWidget* parent, const KisPaintDeviceSP) const
 {
@@ -39,13 +39,12 @@ public:
     }
 
     KisFilterConfigurationSP factoryConfiguration() const override;
+
+    QRect neededRect(const QRect & rect, const KisFilterConfigurationSP config, int lod) const override;
+    QRect changedRect(const QRect & rect, const KisFilterConfigurationSP config, int lod) const override;
+
 public:
     KisConfigWidget * createConfigurationWidget(QWidget* parent, const KisPaintDeviceSP dev) const override;
-
-private:
-    void OilPaint(const KisPaintDeviceSP src, KisPaintDeviceSP dst, const QPoint& srcTopLeft, const QPoint& dstTopLeft, int w, int h,
-                  int BrushSize, int Smoothness, KoUpdater* progressUpdater) const;
-    void MostFrequentColor(KisPaintDeviceSP src, quint8* dst, const QRect& bounds, int X, int Y, int Radius, int Intensity) const;
 };
 
 #endif
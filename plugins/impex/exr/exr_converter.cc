@@ -28,6 +28,8 @@
 #include <ImfOutputFile.h>
 
 #include <ImfStringAttribute.h>
+#include <ImfThreading.h>
+#include <ImfTileDescription.h>
 #include "exr_extra_tags.h"
 
 #include <QApplication>
@@ -35,6 +37,10 @@
 #include <QDomDocument>
 
 #include <QFileInfo>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <mutex>
 
 #include <KoColorSpaceRegistry.h>
 #include <KoCompositeOpRegistry.h>
@@ -49,6 +55,7 @@
 #include <kis_paint_layer.h>
 #include <kis_transaction.h>
 #include "kis_iterator_ng.h"
+#include "kis_sequential_iterator.h"
 #include <kis_exr_layers_sorter.h>
 
 #include <metadata/kis_meta_data_entry.h>
@@ -167,6 +174,12 @@ EXRConverter::EXRConverter(KisDocument *doc, bool showNotifications)
 {
     d->doc = doc;
     d->showNotifications = showNotifications;
+
+    // let OpenEXR (de)compress the line blocks in its global thread pool
+    static std::once_flag threadPoolInitialized;
+    std::call_once(threadPoolInitialized, [] () {
+        Imf::setGlobalThreadCount(QThread::idealThreadCount());
+    });
 }
 
 EXRConverter::~EXRConverter()
@@ -368,18 +381,41 @@ void multiplyAlpha(Pixel *pixel)
     }
 }
 
+/**
+ * The pixels are transferred in strips of the height of a Krita tile, so that
+ * OpenEXR could decompress several line blocks (or tiles) at once in its
+ * global thread pool and every strip maps onto a single row of tiles of the
+ * paint device. No full-image staging buffer is needed.
+ */
+static const int EXR_STRIP_HEIGHT = 64;
+
+int readingStripHeight(const Imf::Header &header, int imageHeight)
+{
+    int stripHeight = EXR_STRIP_HEIGHT;
+
+    if (header.hasTileDescription()) {
+        const int tileHeight = header.tileDescription().ySize;
+        stripHeight = ((stripHeight + tileHeight - 1) / tileHeight) * tileHeight;
+    }
+
+    return qBound(1, stripHeight, imageHeight);
+}
+
 template<typename _T_>
 void EXRConverter::Private::decodeData4(Imf::InputFile& file, ExrPaintLayerInfo& info, KisPaintLayerSP layer, int width, int xstart, int ystart, int height, Imf::PixelType ptype)
 {
     typedef Rgba<_T_> Rgba;
 
-    QVector<Rgba> pixels(width);
+    const int stripHeight = readingStripHeight(file.header(), height);
+    QVector<Rgba> pixels(width * stripHeight);
 
     bool hasAlpha = info.channelMap.contains("A");
 
-    for (int y = 0; y < height; ++y) {
+    for (int stripStart = 0; stripStart < height; stripStart += stripHeight) {
+        const int numLines = qMin(stripHeight, height - stripStart);
+
         Imf::FrameBuffer frameBuffer;
-        Rgba* frameBufferData = (pixels.data()) - xstart - (ystart + y) * width;
+        Rgba* frameBufferData = (pixels.data()) - xstart - (ystart + stripStart) * width;
         frameBuffer.insert(info.channelMap["R"].toLatin1().constData(),
                 Imf::Slice(ptype, (char *) &frameBufferData->r,
                            sizeof(Rgba) * 1,
@@ -400,16 +436,16 @@ void EXRConverter::Private::decodeData4(Imf::InputFile& file, ExrPaintLayerInfo&
         }
 
         file.setFrameBuffer(frameBuffer);
-        file.readPixels(ystart + y);
+        file.readPixels(ystart + stripStart, ystart + stripStart + numLines - 1);
         Rgba *rgba = pixels.data();
-        KisHLineIteratorSP it = layer->paintDevice()->createHLineIteratorNG(0, y, width);
+        KisSequentialIterator it(layer->paintDevice(), QRect(0, stripStart, width, numLines));
         do {
 
             if (hasAlpha) {
                 unmultiplyAlpha<RgbPixelWrapper<_T_> >(rgba);
             }
 
-            typename KoRgbTraits<_T_>::Pixel* dst = reinterpret_cast<typename KoRgbTraits<_T_>::Pixel*>(it->rawData());
+            typename KoRgbTraits<_T_>::Pixel* dst = reinterpret_cast<typename KoRgbTraits<_T_>::Pixel*>(it.rawData());
 
             dst->red = rgba->r;
             dst->green = rgba->g;
@@ -422,7 +458,7 @@ void EXRConverter::Private::decodeData4(Imf::InputFile& file, ExrPaintLayerInfo&
 
 
             ++rgba;
-        } while (it->nextPixel());
+        } while (it.nextPixel());
     }
 
 }
@@ -436,7 +472,8 @@ void EXRConverter::Private::decodeData1(Imf::InputFile& file, ExrPaintLayerInfo&
     KIS_ASSERT_RECOVER_RETURN(
                 layer->paintDevice()->colorSpace()->colorModelId() == GrayAColorModelID);
 
-    QVector<pixel_type> pixels(width);
+    const int stripHeight = readingStripHeight(file.header(), height);
+    QVector<pixel_type> pixels(width * stripHeight);
 
     Q_ASSERT(info.channelMap.contains("G"));
     dbgFile << "G -> " << info.channelMap["G"];
@@ -445,9 +482,11 @@ void EXRConverter::Private::decodeData1(Imf::InputFile& file, ExrPaintLayerInfo&
     dbgFile << "Has Alpha:" << hasAlpha;
 
 
-    for (int y = 0; y < height; ++y) {
+    for (int stripStart = 0; stripStart < height; stripStart += stripHeight) {
+        const int numLines = qMin(stripHeight, height - stripStart);
+
         Imf::FrameBuffer frameBuffer;
-        pixel_type* frameBufferData = (pixels.data()) - xstart - (ystart + y) * width;
+        pixel_type* frameBufferData = (pixels.data()) - xstart - (ystart + stripStart) * width;
         frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
                 Imf::Slice(ptype, (char *) &frameBufferData->gray,
                            sizeof(pixel_type) * 1,
@@ -461,23 +500,23 @@ void EXRConverter::Private::decodeData1(Imf::InputFile& file, ExrPaintLayerInfo&
         }
 
         file.setFrameBuffer(frameBuffer);
-        file.readPixels(ystart + y);
+        file.readPixels(ystart + stripStart, ystart + stripStart + numLines - 1);
 
         pixel_type *srcPtr = pixels.data();
-        KisHLineIteratorSP it = layer->paintDevice()->createHLineIteratorNG(0, y, width);
+        KisSequentialIterator it(layer->paintDevice(), QRect(0, stripStart, width, numLines));
         do {
 
             if (hasAlpha) {
                 unmultiplyAlpha<GrayPixelWrapper<_T_> >(srcPtr);
             }
 
-            pixel_type* dstPtr = reinterpret_cast<pixel_type*>(it->rawData());
+            pixel_type* dstPtr = reinterpret_cast<pixel_type*>(it.rawData());
 
             dstPtr->gray = srcPtr->gray;
             dstPtr->alpha = hasAlpha ? srcPtr->alpha : channel_type(1.0);
 
             ++srcPtr;
-        } while (it->nextPixel());
+        } while (it.nextPixel());
     }
 
 }
@@ -898,7 +937,7 @@ class Encoder
 public:
     virtual ~Encoder() {}
     virtual void prepareFrameBuffer(Imf::FrameBuffer*, int line) = 0;
-    virtual void encodeData(int line) = 0;
+    virtual void encodeData(int line, int numLines) = 0;
 
 };
 
@@ -906,10 +945,10 @@ template<typename _T_, int size, int alphaPos>
 class EncoderImpl : public Encoder
 {
 public:
-    EncoderImpl(Imf::OutputFile* _file, const ExrPaintLayerSaveInfo* _info, int width) : file(_file), info(_info), pixels(width), m_width(width) {}
+    EncoderImpl(Imf::OutputFile* _file, const ExrPaintLayerSaveInfo* _info, int width) : file(_file), info(_info), pixels(width * EXR_STRIP_HEIGHT), m_width(width) {}
     ~EncoderImpl() override {}
     void prepareFrameBuffer(Imf::FrameBuffer*, int line) override;
-    void encodeData(int line) override;
+    void encodeData(int line, int numLines) override;
 private:
     typedef ExrPixel_<_T_, size> ExrPixel;
     Imf::OutputFile* file;
@@ -933,12 +972,14 @@ void EncoderImpl<_T_, size, alphaPos>::prepareFrameBuffer(Imf::FrameBuffer* fram
 }
 
 template<typename _T_, int size, int alphaPos>
-void EncoderImpl<_T_, size, alphaPos>::encodeData(int line)
+void EncoderImpl<_T_, size, alphaPos>::encodeData(int line, int numLines)
 {
+    KIS_SAFE_ASSERT_RECOVER_RETURN(numLines <= EXR_STRIP_HEIGHT);
+
     ExrPixel *rgba = pixels.data();
-    KisHLineIteratorSP it = info->layer->paintDevice()->createHLineIteratorNG(0, line, m_width);
+    KisSequentialConstIterator it(info->layer->paintDevice(), QRect(0, line, m_width, numLines));
     do {
-        const _T_* dst = reinterpret_cast < const _T_* >(it->oldRawData());
+        const _T_* dst = reinterpret_cast < const _T_* >(it.oldRawData());
 
         for (int i = 0; i < size; ++i) {
             rgba->data[i] = dst[i];
@@ -949,7 +990,7 @@ void EncoderImpl<_T_, size, alphaPos>::encodeData(int line)
         }
 
         ++rgba;
-    } while (it->nextPixel());
+    } while (it.nextPixel());
 }
 
 Encoder* encoder(Imf::OutputFile& file, const ExrPaintLayerSaveInfo& info, int width)
@@ -999,16 +1040,22 @@ void encodeData(Imf::OutputFile& file, const QList<ExrPaintLayerSaveInfo>& infor
         encoders.push_back(encoder(file, info, width));
     }
 
-    for (int y = 0; y < height; ++y) {
+    for (int y = 0; y < height; y += EXR_STRIP_HEIGHT) {
+        const int numLines = qMin(EXR_STRIP_HEIGHT, height - y);
+
         Imf::FrameBuffer frameBuffer;
         Q_FOREACH (Encoder* encoder, encoders) {
             encoder->prepareFrameBuffer(&frameBuffer, y);
         }
         file.setFrameBuffer(frameBuffer);
-        Q_FOREACH (Encoder* encoder, encoders) {
-            encoder->encodeData(y);
-        }
-        file.writePixels(1);
+
+        // the layers are independent, so they can be fetched in parallel
+        QtConcurrent::blockingMap(encoders,
+            [y, numLines] (Encoder *encoder) {
+                encoder->encodeData(y, numLines);
+            });
+
+        file.writePixels(numLines);
     }
     qDeleteAll(encoders);
 }
@@ -463,6 +463,13 @@ bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString&
                 }
             }
         }
+
+        /**
+         * The frames are stored in separate files, so the tiles the
+         * user shared between the frames (e.g. by duplicating
+         * a keyframe) are loaded as separate copies. Share them again.
+         */
+        frameInterface->deduplicateFrames();
     }
 
     return true;
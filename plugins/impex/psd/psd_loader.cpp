@@ -21,6 +21,10 @@
 
 #include <QFileInfo>
 #include <QStack>
+#include <QFile>
+#include <QBuffer>
+#include <QtConcurrent>
+#include <limits>
 
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
@@ -63,6 +67,95 @@ PSDLoader::~PSDLoader()
 {
 }
 
+namespace {
+
+struct PixelDataJob
+{
+    PixelDataJob() {}
+    PixelDataJob(PSDLayerRecord *_record, KisPaintDeviceSP _device, ChannelInfo *_maskChannel = 0)
+        : record(_record), device(_device), maskChannel(_maskChannel) {}
+
+    PSDLayerRecord *record = 0;
+    KisPaintDeviceSP device;
+
+    /// if not null, the job reads the mask channel instead of the layer's pixel data
+    ChannelInfo *maskChannel = 0;
+
+    bool result = false;
+};
+
+void readPixelData(QIODevice *io, PixelDataJob &job)
+{
+    job.result =
+        job.maskChannel ?
+        job.record->readMask(io, job.device, job.maskChannel) :
+        job.record->readPixelData(io, job.device);
+}
+
+/**
+ * Every layer has its own channel records and paint device, so the layers
+ * can be decompressed independently. When the file can be mapped into
+ * memory, every worker thread reads it through its own QBuffer sharing the
+ * mapped data, so no seeking of the original device happens. Otherwise
+ * every job reads its channels through its own handle of the file.
+ */
+void readPixelDataInParallel(QIODevice *io, QVector<PixelDataJob> &jobs)
+{
+    QFile *file = qobject_cast<QFile*>(io);
+
+    /**
+     * The jobs can open the file on their own only if it has a name
+     */
+    if (!file || file->fileName().isEmpty()) {
+        for (int i = 0; i < jobs.size(); i++) {
+            readPixelData(io, jobs[i]);
+        }
+        return;
+    }
+
+    /**
+     * QByteArray cannot address more than 2 GiB, so the big PSB files
+     * are not mapped. Instead, every job opens the file on its own and
+     * reads its channels from there.
+     */
+    const bool canMapFile = file->size() <= std::numeric_limits<int>::max();
+    uchar *mappedData = canMapFile ? file->map(0, file->size()) : 0;
+
+    if (!mappedData) {
+        const QString fileName = file->fileName();
+
+        QtConcurrent::blockingMap(jobs,
+            [&fileName] (PixelDataJob &job) {
+                QFile jobFile(fileName);
+                if (!jobFile.open(QIODevice::ReadOnly)) {
+                    dbgFile << "failed to open" << fileName << "for reading the pixel data";
+                    job.result = false;
+                    return;
+                }
+
+                readPixelData(&jobFile, job);
+            });
+
+        return;
+    }
+
+    const QByteArray rawData =
+        QByteArray::fromRawData(reinterpret_cast<const char*>(mappedData), int(file->size()));
+
+    QtConcurrent::blockingMap(jobs,
+        [&rawData] (PixelDataJob &job) {
+            QBuffer buffer;
+            buffer.setData(rawData);
+            buffer.open(QIODevice::ReadOnly);
+
+            readPixelData(&buffer, job);
+        });
+
+    file->unmap(mappedData);
+}
+
+}
+
 KisImageBuilder_Result PSDLoader::decode(QIODevice *io)
 {
     // open the file
@@ -197,6 +290,12 @@ KisImageBuilder_Result PSDLoader::decode(QIODevice *io)
     typedef QPair<QDomDocument, KisLayerSP> LayerStyleMapping;
     QVector<LayerStyleMapping> allStylesXml;
 
+    /**
+     * The layers tree is built first, and the pixel data of the layers
+     * is decoded afterwards, when all the paint devices are known.
+     */
+    QVector<PixelDataJob> pixelDataJobs;
+
     // read the channels for the various layers
     for(int i = 0; i < layerSection.nLayers; ++i) {
 
@@ -273,10 +372,8 @@ KisImageBuilder_Result PSDLoader::decode(QIODevice *io)
                 allStylesXml << LayerStyleMapping(styleXml, layer);
             }
 
-            if (!layerRecord->readPixelData(io, layer->paintDevice())) {
-                dbgFile << "failed reading channels for layer: " << layerRecord->layerName << layerRecord->error;
-                return KisImageBuilder_RESULT_FAILURE;
-            }
+            pixelDataJobs << PixelDataJob(layerRecord, layer->paintDevice());
+
             if (!groupStack.isEmpty()) {
                 m_image->addNode(layer, groupStack.top());
             }
@@ -293,9 +390,7 @@ KisImageBuilder_Result PSDLoader::decode(QIODevice *io)
                 KisTransparencyMaskSP mask = new KisTransparencyMask();
                 mask->setName(i18n("Transparency Mask"));
                 mask->initSelection(newLayer);
-                if (!layerRecord->readMask(io, mask->paintDevice(), channelInfo)) {
-                    dbgFile << "failed reading masks for layer: " << layerRecord->layerName << layerRecord->error;
-                }
+                pixelDataJobs << PixelDataJob(layerRecord, mask->paintDevice(), channelInfo);
                 m_image->addNode(mask, newLayer);
             }
         }
@@ -303,6 +398,19 @@ KisImageBuilder_Result PSDLoader::decode(QIODevice *io)
         lastAddedLayer = newLayer;
     }
 
+    readPixelDataInParallel(io, pixelDataJobs);
+
+    Q_FOREACH (const PixelDataJob &job, pixelDataJobs) {
+        if (job.result) continue;
+
+        if (!job.maskChannel) {
+            dbgFile << "failed reading channels for layer: " << job.record->layerName << job.record->error;
+            return KisImageBuilder_RESULT_FAILURE;
+        } else {
+            dbgFile << "failed reading masks for layer: " << job.record->layerName << job.record->error;
+        }
+    }
+
     const QVector<QDomDocument> &embeddedPatterns =
         layerSection.globalInfoSection.embeddedPatterns;
 
@@ -21,6 +21,7 @@
 #include <QtGlobal>
 #include <QMap>
 #include <QIODevice>
+#include <QtConcurrent>
 
 
 #include <KoColorSpace.h>
@@ -543,7 +544,21 @@ void readAlphaMaskChannels(QIODevice *io,
     readCommon(device, io, layerRect, infoRecords, channelSize, &readAlphaMaskPixelCommon, true);
 }
 
-void writeChannelDataRLE(QIODevice *io, const quint8 *plane, const int channelSize, const QRect &rc, const qint64 sizeFieldOffset, const qint64 rleBlockOffset, const bool writeCompressionType)
+QVector<QByteArray> compressChannelDataRLE(const quint8 *plane, const int channelSize, const QRect &rc)
+{
+    QVector<QByteArray> compressedRows;
+    compressedRows.reserve(rc.height());
+
+    quint32 stride = channelSize * rc.width();
+    for (qint32 row = 0; row < rc.height(); ++row) {
+        QByteArray uncompressed = QByteArray::fromRawData((const char*)plane + row * stride, stride);
+        compressedRows << Compression::compress(uncompressed, Compression::RLE);
+    }
+
+    return compressedRows;
+}
+
+void writeCompressedChannelDataRLE(QIODevice *io, const QVector<QByteArray> &compressedRows, const qint64 sizeFieldOffset, const qint64 rleBlockOffset, const bool writeCompressionType)
 {
     typedef KisAslWriterUtils::OffsetStreamPusher<quint32> Pusher;
     QScopedPointer<Pusher> channelBlockSizeExternalTag;
@@ -569,18 +584,15 @@ void writeChannelDataRLE(QIODevice *io, const quint8 *plane, const int channelSi
         }
 
         // write zero's for the channel lengths block
-        for(int i = 0; i < rc.height(); ++i) {
+        for(int i = 0; i < compressedRows.size(); ++i) {
             // XXX: choose size for PSB!
             const quint16 fakeRLEBLockSize = 0;
             SAFE_WRITE_EX(io, fakeRLEBLockSize);
         }
     }
 
-    quint32 stride = channelSize * rc.width();
-    for (qint32 row = 0; row < rc.height(); ++row) {
-
-        QByteArray uncompressed = QByteArray::fromRawData((const char*)plane + row * stride, stride);
-        QByteArray compressed = Compression::compress(uncompressed, Compression::RLE);
+    for (qint32 row = 0; row < compressedRows.size(); ++row) {
+        const QByteArray &compressed = compressedRows[row];
 
         KisAslWriterUtils::OffsetStreamPusher<quint16> rleExternalTag(io, 0, channelRLESizePos + row * sizeof(quint16));
 
@@ -590,6 +602,14 @@ void writeChannelDataRLE(QIODevice *io, const quint8 *plane, const int channelSi
     }
 }
 
+void writeChannelDataRLE(QIODevice *io, const quint8 *plane, const int channelSize, const QRect &rc, const qint64 sizeFieldOffset, const qint64 rleBlockOffset, const bool writeCompressionType)
+{
+    writeCompressedChannelDataRLE(io,
+                                  compressChannelDataRLE(plane, channelSize, rc),
+                                  sizeFieldOffset, rleBlockOffset,
+                                  writeCompressionType);
+}
+
 inline void preparePixelForWrite(quint8 *dataPlane,
                                  int numPixels,
                                  int channelSize,
@@ -688,6 +708,20 @@ void writePixelDataCommon(QIODevice *io,
 
     const int numPixels = rc.width() * rc.height();
 
+    // convert and compress the planes in parallel, the channels don't depend on each other
+
+    QVector<QVector<QByteArray>> compressedPlanes(writingInfoList.size());
+    QVector<int> channelIndexes;
+    for (int i = 0; i < writingInfoList.size(); i++) {
+        channelIndexes << i;
+    }
+
+    QtConcurrent::blockingMap(channelIndexes,
+        [&] (int i) {
+            preparePixelForWrite(planes[i], numPixels, channelSize, writingInfoList[i].channelId, colorMode);
+            compressedPlanes[i] = compressChannelDataRLE(planes[i], channelSize, rc);
+        });
+
     // write down the planes
 
     try {
@@ -695,12 +729,9 @@ void writePixelDataCommon(QIODevice *io,
             const ChannelWritingInfo &info = writingInfoList[i];
 
             dbgFile << "\tWriting channel" << i << "psd channel id" << info.channelId;
-
-            preparePixelForWrite(planes[i], numPixels, channelSize, info.channelId, colorMode);
-
             dbgFile << "\t\tchannel start" << ppVar(io->pos());
 
-            writeChannelDataRLE(io, planes[i], channelSize, rc, info.sizeFieldOffset, info.rleBlockOffset, writeCompressionType);
+            writeCompressedChannelDataRLE(io, compressedPlanes[i], info.sizeFieldOffset, info.rleBlockOffset, writeCompressionType);
         }
 
     } catch (KisAslWriterUtils::ASLWriteException &e) {
@@ -25,6 +25,8 @@
 #include <KoColorSpaceRegistry.h>
 #include <KoColor.h>
 #include <KoColorProfile.h>
+#include <KoColorSpace.h>
+#include <KoCompositeOp.h>
 #include <KoCompositeOpRegistry.h>
 
 #include <kis_brush.h>
@@ -44,10 +46,6 @@ KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPaint
     : KisBrushBasedPaintOp(settings, painter)
     , m_firstRun(true)
     , m_image(image)
-    , m_tempDev(painter->device()->createCompositionSourceDevice())
-    , m_backgroundPainter(new KisPainter(m_tempDev))
-    , m_smudgePainter(new KisPainter(m_tempDev))
-    , m_colorRatePainter(new KisPainter(m_tempDev))
     , m_smudgeRateOption()
     , m_colorRateOption("ColorRate", KisPaintOpOption::GENERAL, false)
     , m_smudgeRadiusOption()
@@ -80,18 +78,11 @@ KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPaint
 
     m_gradient = painter->gradient();
 
-    m_backgroundPainter->setCompositeOp(COMPOSITE_COPY);
-    // Smudge Painter works in default COMPOSITE_OVER mode
-    m_colorRatePainter->setCompositeOp(painter->compositeOp()->id());
-
     m_rotationOption.applyFanCornersInfo(this);
 }
 
 KisColorSmudgeOp::~KisColorSmudgeOp()
 {
-    delete m_backgroundPainter;
-    delete m_colorRatePainter;
-    delete m_smudgePainter;
 }
 
 void KisColorSmudgeOp::updateMask(const KisPaintInformation& info, double scale, double rotation, const QPointF &cursorPoint)
@@ -111,6 +102,64 @@ void KisColorSmudgeOp::updateMask(const KisPaintInformation& info, double scale,
     KIS_ASSERT_RECOVER_NOOP(m_dstDabRect.size() == m_maskDab->bounds().size());
 }
 
+void KisColorSmudgeOp::prepareSmudgeDab(const KoColorSpace *colorSpace)
+{
+    if (!m_smudgeDab || *m_smudgeDab->colorSpace() != *colorSpace) {
+        m_smudgeDab = new KisFixedPaintDevice(colorSpace);
+    }
+
+    m_smudgeDab->setRect(QRect(QPoint(), m_dstDabRect.size()));
+    m_smudgeDab->lazyGrowBufferWithoutInitialization();
+}
+
+void KisColorSmudgeOp::readIntoSmudgeDab(KisPaintDeviceSP src, const QRect &srcRect, const QString &compositeOpId)
+{
+    const KoColorSpace *dabColorSpace = m_smudgeDab->colorSpace();
+    const KoColorSpace *srcColorSpace = src->colorSpace();
+
+    if (compositeOpId == COMPOSITE_COPY && *srcColorSpace == *dabColorSpace) {
+        src->readBytes(m_smudgeDab->data(), srcRect);
+        return;
+    }
+
+    m_sourceBytes.resize(srcRect.width() * srcRect.height() * srcColorSpace->pixelSize());
+    src->readBytes(m_sourceBytes.data(), srcRect);
+
+    KoCompositeOp::ParameterInfo params;
+    params.dstRowStart   = m_smudgeDab->data();
+    params.dstRowStride  = srcRect.width() * dabColorSpace->pixelSize();
+    params.srcRowStart   = m_sourceBytes.constData();
+    params.srcRowStride  = srcRect.width() * srcColorSpace->pixelSize();
+    params.maskRowStart  = 0;
+    params.maskRowStride = 0;
+    params.rows          = srcRect.height();
+    params.cols          = srcRect.width();
+
+    dabColorSpace->bitBlt(srcColorSpace, params, dabColorSpace->compositeOp(compositeOpId),
+                          KoColorConversionTransformation::internalRenderingIntent(),
+                          KoColorConversionTransformation::internalConversionFlags());
+}
+
+void KisColorSmudgeOp::mixColorIntoSmudgeDab(const KoColor &color, const QString &compositeOpId, quint8 opacity)
+{
+    const KoColorSpace *dabColorSpace = m_smudgeDab->colorSpace();
+    const QRect bounds = m_smudgeDab->bounds();
+    KoColor dabColor(color, dabColorSpace);
+
+    KoCompositeOp::ParameterInfo params;
+    params.dstRowStart   = m_smudgeDab->data();
+    params.dstRowStride  = bounds.width() * dabColorSpace->pixelSize();
+    params.srcRowStart   = dabColor.data();
+    params.srcRowStride  = 0; // srcRowStride is set to zero to use the compositeOp with only a single color pixel
+    params.maskRowStart  = 0;
+    params.maskRowStride = 0;
+    params.rows          = bounds.height();
+    params.cols          = bounds.width();
+    params.opacity       = float(opacity) / 255.0f;
+
+    dabColorSpace->compositeOp(compositeOpId)->composite(params);
+}
+
 inline void KisColorSmudgeOp::getTopLeftAligned(const QPointF &pos, const QPointF &hotSpot, qint32 *x, qint32 *y)
 {
     QPointF topLeft = pos - hotSpot;
@@ -204,57 +253,59 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
     QString oldCompositeOpId = painter()->compositeOp()->id();
     qreal   fpOpacity  = (qreal(oldOpacity) / 255.0) * m_opacityOption.getOpacityf(info);
 
-    if (m_image && m_overlayModeOption.isChecked()) {
+    /**
+     * The whole dab is mixed in a single reusable fixed device: the
+     * background (in overlay mode), the smudged pixels and the color
+     * rate are composited right into its buffer, which is then written
+     * onto the canvas in one pass.
+     */
+    prepareSmudgeDab(painter()->device()->compositionSourceColorSpace());
+
+    const bool useOverlayMode = m_image && m_overlayModeOption.isChecked();
+
+    if (useOverlayMode) {
         m_image->blockUpdates();
-        m_backgroundPainter->bitBlt(QPoint(), m_image->projection(), srcDabRect);
+        readIntoSmudgeDab(m_image->projection(), srcDabRect, COMPOSITE_COPY);
         m_image->unblockUpdates();
     }
-    else {
-        // IMPORTANT: clear the temporary painting device to color black with zero opacity:
-        //            it will only clear the extents of the brush.
-        m_tempDev->clear(QRect(QPoint(), m_dstDabRect.size()));
-    }
+
+    // without the background the smudged pixels just replace the buffer contents
+    const QString smudgeCompositeOpId = useOverlayMode ? COMPOSITE_OVER : COMPOSITE_COPY;
 
     if (m_smudgeRateOption.getMode() == KisSmudgeOption::SMEARING_MODE) {
-        m_smudgePainter->bitBlt(QPoint(), painter()->device(), srcDabRect);
+        readIntoSmudgeDab(painter()->device(), srcDabRect, smudgeCompositeOpId);
     } else {
         QPoint pt = (srcDabRect.topLeft() + hotSpot).toPoint();
+        KoColor color = painter()->paintColor();
 
         if (m_smudgeRadiusOption.isChecked()) {
             qreal effectiveSize = 0.5 * (m_dstDabRect.width() + m_dstDabRect.height());
-            m_smudgeRadiusOption.apply(*m_smudgePainter, info, effectiveSize, pt.x(), pt.y(), painter()->device());
-
-            KoColor color2 = m_smudgePainter->paintColor();
-            m_smudgePainter->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color2);
-
+            color = m_smudgeRadiusOption.apply(info, effectiveSize, pt.x(), pt.y(), painter()->device());
         } else {
-            KoColor color = painter()->paintColor();
-
             // get the pixel on the canvas that lies beneath the hot spot
-            // of the dab and fill  the temporary paint device with that color
+            // of the dab and fill the smudge dab with that color
 
             KisCrossDeviceColorPickerInt colorPicker(painter()->device(), color);
             colorPicker.pickColor(pt.x(), pt.y(), color.data());
-
-            m_smudgePainter->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color);
         }
+
+        mixColorIntoSmudgeDab(color, smudgeCompositeOpId, OPACITY_OPAQUE_U8);
     }
 
     // if the user selected the color smudge option,
-    // we will mix some color into the temporary painting device (m_tempDev)
+    // we will mix some color into the smudge dab
     if (m_colorRateOption.isChecked()) {
-        // this will apply the opacity (selected by the user) to copyPainter
-        // (but fit the rate inbetween the range 0.0 to (1.0-SmudgeRate))
+        // the opacity selected by the user is fit
+        // inbetween the range 0.0 to (1.0-SmudgeRate)
         qreal maxColorRate = qMax<qreal>(1.0 - m_smudgeRateOption.getRate(), 0.2);
-        m_colorRateOption.apply(*m_colorRatePainter, info, 0.0, maxColorRate, fpOpacity);
+        quint8 colorRateOpacity = m_colorRateOption.computeOpacity(info, 0.0, maxColorRate, fpOpacity);
 
-        // paint a rectangle with the current color (foreground color)
-        // or a gradient color (if enabled)
-        // into the temporary painting device and use the user selected
-        // composite mode
+        // mix the current color (foreground color) or a gradient
+        // color (if enabled) into the smudge dab using the user
+        // selected composite mode
         KoColor color = painter()->paintColor();
         m_gradientOption.apply(color, m_gradient, info);
-        m_colorRatePainter->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color);
+        mixColorIntoSmudgeDab(color, oldCompositeOpId, colorRateOpacity);
     }
 
     // if color is disabled (only smudge) and "overlay mode" is enabled
@@ -273,12 +324,13 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
     // set opacity calculated by the rate option
     m_smudgeRateOption.apply(*painter(), info, 0.0, 1.0, fpOpacity);
 
-    // then blit the temporary painting device on the canvas at the current brush position
+    // then blit the smudge dab on the canvas at the current brush position
     // the alpha mask (maskDab) will be used here to only blit the pixels that are in the area (shape) of the brush
 
     painter()->setCompositeOp(COMPOSITE_COPY);
-    painter()->bitBltWithFixedSelection(m_dstDabRect.x(), m_dstDabRect.y(), m_tempDev, m_maskDab, m_dstDabRect.width(), m_dstDabRect.height());
-    painter()->renderMirrorMaskSafe(m_dstDabRect, m_tempDev, 0, 0, m_maskDab, !m_dabCache->needSeparateOriginal());
+    painter()->bltFixedWithFixedSelection(m_dstDabRect.x(), m_dstDabRect.y(), m_smudgeDab, m_maskDab, m_dstDabRect.width(), m_dstDabRect.height());
+    // the smudge dab is rebuilt on every pass, so it can be mirrored in-place
+    painter()->renderMirrorMaskSafe(m_dstDabRect, m_smudgeDab, m_maskDab, false, !m_dabCache->needSeparateOriginal());
 
     // restore orginal opacy and composite mode values
     painter()->setOpacity(oldOpacity);
@@ -20,6 +20,7 @@
 #define _KIS_COLORSMUDGEOP_H_
 
 #include <QRect>
+#include <QVector>
 
 #include <kis_brush_based_paintop.h>
 #include <kis_types.h>
@@ -37,6 +38,8 @@
 
 class QPointF;
 class KoAbstractGradient;
+class KoColor;
+class KoColorSpace;
 class KisBrushBasedPaintOpSettings;
 class KisPainter;
 
@@ -55,15 +58,17 @@ private:
     // Sets the m_maskDab _and m_maskDabRect
     void updateMask(const KisPaintInformation& info, double scale, double rotation, const QPointF &cursorPoint);
 
+    void prepareSmudgeDab(const KoColorSpace *colorSpace);
+    void readIntoSmudgeDab(KisPaintDeviceSP src, const QRect &srcRect, const QString &compositeOpId);
+    void mixColorIntoSmudgeDab(const KoColor &color, const QString &compositeOpId, quint8 opacity);
+
     inline void getTopLeftAligned(const QPointF &pos, const QPointF &hotSpot, qint32 *x, qint32 *y);
 
 private:
     bool                      m_firstRun;
     KisImageWSP               m_image;
-    KisPaintDeviceSP          m_tempDev;
-    KisPainter*               m_backgroundPainter;
-    KisPainter*               m_smudgePainter;
-    KisPainter*               m_colorRatePainter;
+    KisFixedPaintDeviceSP     m_smudgeDab;
+    QVector<quint8>           m_sourceBytes;
     const KoAbstractGradient* m_gradient;
     KisPressureSizeOption     m_sizeOption;
     KisPressureOpacityOption  m_opacityOption;
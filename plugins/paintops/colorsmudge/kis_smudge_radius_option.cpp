@@ -48,24 +48,20 @@ KisSmudgeRadiusOption::KisSmudgeRadiusOption():
     setValueRange(0.0,300.0);
 }
 
-void KisSmudgeRadiusOption::apply(KisPainter& painter,
-                                  const KisPaintInformation& info,
-                                  qreal diameter,
-                                  qreal posx,
-                                  qreal posy,
-                                  KisPaintDeviceSP dev) const
+KoColor KisSmudgeRadiusOption::apply(const KisPaintInformation& info,
+                                     qreal diameter,
+                                     qreal posx,
+                                     qreal posy,
+                                     KisPaintDeviceSP dev) const
 {
-    if (!isChecked()) return;
+    KoColor color(dev->colorSpace());
 
-    qreal sliderValue = computeSizeLikeValue(info);
+    qreal sliderValue = isChecked() ? computeSizeLikeValue(info) : 0.0;
 
     int smudgeRadius = ((sliderValue * diameter) * 0.5) / 100.0;
 
-
-    KoColor color = painter.paintColor();
-    if (smudgeRadius == 1) {
+    if (smudgeRadius <= 1) {
         dev->pixel(posx, posy, &color);
-        painter.setPaintColor(color);
     } else {
 
         const KoColorSpace* cs = dev->colorSpace();
@@ -87,8 +83,6 @@ void KisSmudgeRadiusOption::apply(KisPainter& painter,
         int k = 0;
         int j = 0;
         KisRandomConstAccessorSP accessor = dev->createRandomConstAccessorNG(0, 0);
-        KisCrossDeviceColorPickerInt colorPicker(painter.device(), color);
-        colorPicker.pickColor(posx, posy, color.data());
 
         for (int y = 0; y <= smudgeRadius; y = y + loop_increment) {
             for (int x = 0; x <= smudgeRadius; x = x + loop_increment) {
@@ -139,8 +133,7 @@ void KisSmudgeRadiusOption::apply(KisPainter& painter,
 
         }
 
-        KoColor color = KoColor(pixels[0],cs);
-        painter.setPaintColor(color);
+        color = KoColor(pixels[0],cs);
 
         for (int l = 0; l < 2; l++){
             delete[] pixels[l];
@@ -149,7 +142,7 @@ void KisSmudgeRadiusOption::apply(KisPainter& painter,
         delete[] data;
     }
 
-
+    return color;
 }
 
 void KisSmudgeRadiusOption::writeOptionSetting(KisPropertiesConfigurationSP setting) const
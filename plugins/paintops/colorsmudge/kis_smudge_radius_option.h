@@ -22,7 +22,7 @@
 #include <kis_types.h>
 
 class KisPropertiesConfiguration;
-class KisPainter;
+class KoColor;
 
 class KisSmudgeRadiusOption: public KisRateOption
 {
@@ -30,11 +30,10 @@ public:
     KisSmudgeRadiusOption();
 
     /**
-     * Set the opacity of the painter based on the rate
-     * and the curve (if checked)
+     * Sample the color of \p dev around (\p posx, \p posy), averaging
+     * over the smudge radius computed from the rate and the curve
      */
-    void apply(KisPainter& painter,
-               const KisPaintInformation& info,
+    KoColor apply(const KisPaintInformation& info,
                qreal diameter,
                qreal posx,
                qreal posy,
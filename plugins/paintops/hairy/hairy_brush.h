@@ -22,6 +22,7 @@
 #include <QVector>
 #include <QList>
 #include <QTransform>
+#include <QScopedPointer>
 
 #include <KoColor.h>
 
@@ -30,9 +31,7 @@
 
 #include <kis_paint_device.h>
 #include <brushengine/kis_paint_information.h>
-#include <kis_random_accessor_ng.h>
-
-class KoCompositeOp;
+#include <kis_particle_rasterizer.h>
 
 
 class KisHairyProperties
@@ -86,16 +85,8 @@ public:
     void fromDabWithDensity(KisFixedPaintDeviceSP dab, qreal density);
 
 private:
-    /// paints single bristle
+    /// paints single bristle, the ink is queued into the rasterizer
     void addBristleInk(Bristle *bristle,const QPointF &pos, const KoColor &color);
-    /// composite single pixel to dab
-    void plotPixel(int wx, int wy, const KoColor &color);
-    /// check the opacity of dab pixel and if the opacity is less then color, it will copy color to dab
-    void darkenPixel(int wx, int wy, const KoColor &color);
-    /// paint wu particle by copying the color and setup just the opacity, weight is complementary to opacity of the color
-    void paintParticle(QPointF pos, const KoColor& color, qreal weight);
-    /// paint wu particle using composite operation
-    void paintParticle(QPointF pos, const KoColor& color);
     /// similar to sample input color in spray
     void colorifyBristles(KisPaintDeviceSP source, QPointF point);
 
@@ -123,8 +114,8 @@ private:
     QHash<QString, QVariant> m_params;
     // temporary device
     KisPaintDeviceSP m_dab;
-    KisRandomAccessorSP m_dabAccessor;
-    const KoCompositeOp * m_compositeOp;
+    // writes the bristle ink onto the dab tile by tile
+    QScopedPointer<KisParticleRasterizer> m_rasterizer;
     quint32 m_pixelSize;
 
     int m_counter;
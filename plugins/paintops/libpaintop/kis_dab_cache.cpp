@@ -22,6 +22,8 @@
 #include "kis_color_source.h"
 #include "kis_paint_device.h"
 #include "kis_brush.h"
+#include "kis_auto_brush.h"
+#include "kis_dab_cache_storage.h"
 #include <kis_pressure_mirror_option.h>
 #include <kis_pressure_sharpness_option.h>
 #include <kis_texture_option.h>
@@ -31,6 +33,9 @@
 
 #include <kundo2command.h>
 
+#include <QCryptographicHash>
+#include <QDomDocument>
+
 struct PrecisionValues {
     qreal angle;
     qreal sizeFrac;
@@ -47,6 +52,47 @@ static const PrecisionValues precisionLevels[] = {
     {eps,         0, eps,  eps}
 };
 
+/**
+ * On the highest precision level the parameters should match exactly,
+ * which almost never happens in real strokes, so the shared storage is
+ * not used there
+ */
+static const int maxSharedStoragePrecisionLevel = 3;
+
+static inline int quantize(qreal value, qreal step) {
+    return qRound(value / step);
+}
+
+/**
+ * The brushes are recreated for every stroke, so they are identified by
+ * their serialized properties. Returns an empty key if the dabs of the
+ * brush should not be shared.
+ */
+static QByteArray calculateSharedBrushKey(KisBrushSP brush)
+{
+    KisAutoBrush *autoBrush = dynamic_cast<KisAutoBrush*>(brush.data());
+
+    if (autoBrush) {
+        // the randomized dabs should not repeat from stroke to stroke
+        if (autoBrush->randomness() > 0.0 || autoBrush->density() < 1.0) {
+            return QByteArray();
+        }
+    } else if (brush->md5().isEmpty()) {
+        // an unsaved brush, e.g. a custom or a text one
+        return QByteArray();
+    }
+
+    QDomDocument doc;
+    QDomElement element = doc.createElement("Brush");
+    brush->toXML(doc, element);
+    doc.appendChild(element);
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(doc.toByteArray());
+    hash.addData(brush->md5());
+    return hash.result();
+}
+
 struct KisDabCache::SavedDabParameters {
     KoColor color;
     qreal angle;
@@ -83,7 +129,8 @@ struct KisDabCache::Private {
           textureOption(0),
           precisionOption(0),
           subPixelPrecisionDisabled(false),
-          cachedDabParameters(new SavedDabParameters)
+          cachedDabParameters(new SavedDabParameters),
+          sharedBrushKey(calculateSharedBrushKey(brush))
     {}
     KisFixedPaintDeviceSP dab;
     KisFixedPaintDeviceSP dabOriginal;
@@ -98,6 +145,12 @@ struct KisDabCache::Private {
     bool subPixelPrecisionDisabled;
 
     SavedDabParameters *cachedDabParameters;
+
+    QByteArray sharedBrushKey;
+
+    int precisionLevel() const {
+        return precisionOption ? precisionOption->precisionLevel() - 1 : 3;
+    }
 };
 
 
@@ -229,9 +282,7 @@ KisFixedPaintDeviceSP KisDabCache::tryFetchFromCache(const SavedDabParameters &p
         const KisPaintInformation& info,
         QRect *dstDabRect)
 {
-    int precisionLevel = m_d->precisionOption ? m_d->precisionOption->precisionLevel() - 1 : 3;
-
-    if (!params.compare(*m_d->cachedDabParameters, precisionLevel)) {
+    if (!params.compare(*m_d->cachedDabParameters, m_d->precisionLevel())) {
         return 0;
     }
 
@@ -248,6 +299,31 @@ KisFixedPaintDeviceSP KisDabCache::tryFetchFromCache(const SavedDabParameters &p
     return m_d->dab;
 }
 
+inline
+KisDabCacheStorage::Key KisDabCache::sharedStorageKey(const KoColorSpace *cs,
+        const SavedDabParameters &params)
+{
+    const PrecisionValues &prec = precisionLevels[m_d->precisionLevel()];
+
+    KisDabCacheStorage::Key key;
+    key.brushKey = m_d->sharedBrushKey;
+    key.dabColorSpace = cs;
+    key.colorColorSpace = params.color.colorSpace();
+    key.color = QByteArray(reinterpret_cast<const char*>(params.color.data()),
+                           params.color.colorSpace()->pixelSize());
+    key.width = params.width;
+    key.height = params.height;
+    key.index = params.index;
+    key.angle = quantize(params.angle, prec.angle);
+    key.subPixelX = quantize(params.subPixelX, prec.subPixel);
+    key.subPixelY = quantize(params.subPixelY, prec.subPixel);
+    key.softnessFactor = quantize(params.softnessFactor, prec.softnessFactor);
+    key.horizontalMirror = params.mirrorProperties.horizontalMirror;
+    key.verticalMirror = params.mirrorProperties.verticalMirror;
+
+    return key;
+}
+
 qreal positiveFraction(qreal x) {
     qint32 unused = 0;
     qreal fraction = 0.0;
@@ -359,17 +435,45 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
         if (cachedDab) return cachedDab;
     }
 
-    if (m_d->brush->brushType() == IMAGE || m_d->brush->brushType() == PIPE_IMAGE) {
+    const bool isImageBrush =
+        m_d->brush->brushType() == IMAGE || m_d->brush->brushType() == PIPE_IMAGE;
+
+    const bool useSharedStorage =
+        cachingIsPossible && !isImageBrush &&
+        !m_d->sharedBrushKey.isEmpty() &&
+        m_d->precisionLevel() <= maxSharedStoragePrecisionLevel;
+
+    KisDabCacheStorage::Key storageKey;
+    bool fetchedFromStorage = false;
+
+    if (isImageBrush) {
         m_d->dab = m_d->brush->paintDevice(cs, shape, info,
                                            position.subPixel.x(),
                                            position.subPixel.y());
     }
     else if (cachingIsPossible) {
         *m_d->cachedDabParameters = newParams;
-        m_d->brush->mask(m_d->dab, paintColor, shape,
-                         info,
-                         position.subPixel.x(), position.subPixel.y(),
-                         softnessFactor);
+
+        if (useSharedStorage) {
+            storageKey = sharedStorageKey(cs, newParams);
+            KisFixedPaintDeviceSP storedDab =
+                KisDabCacheStorage::instance()->fetchDab(storageKey);
+
+            if (storedDab) {
+                // the data is shared until the postprocessing modifies it
+                *m_d->dab = *storedDab;
+                *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, m_d->dab->bounds().size());
+                m_d->brush->notifyCachedDabPainted(info);
+                fetchedFromStorage = true;
+            }
+        }
+
+        if (!fetchedFromStorage) {
+            m_d->brush->mask(m_d->dab, paintColor, shape,
+                             info,
+                             position.subPixel.x(), position.subPixel.y(),
+                             softnessFactor);
+        }
     }
     else {
         if (!m_d->colorSourceDevice || *cs != *m_d->colorSourceDevice->colorSpace()) {
@@ -389,11 +493,15 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
                          softnessFactor);
     }
 
-    if (!mirrorProperties.isEmpty()) {
+    if (!mirrorProperties.isEmpty() && !fetchedFromStorage) {
         m_d->dab->mirror(mirrorProperties.horizontalMirror,
                          mirrorProperties.verticalMirror);
     }
 
+    if (useSharedStorage && !fetchedFromStorage) {
+        KisDabCacheStorage::instance()->storeDab(storageKey, m_d->dab);
+    }
+
     if (needSeparateOriginal()) {
         if (!m_d->dabOriginal || *cs != *m_d->dabOriginal->colorSpace()) {
             m_d->dabOriginal = new KisFixedPaintDevice(cs);
@@ -402,7 +510,7 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
         *m_d->dabOriginal = *m_d->dab;
     }
 
-    postProcessDab(m_d->dab, position.rect.topLeft(), info);
+    postProcessDab(m_d->dab, dstDabRect->topLeft(), info);
 
     return m_d->dab;
 }
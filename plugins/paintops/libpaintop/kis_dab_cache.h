@@ -21,6 +21,7 @@
 
 #include "kritapaintop_export.h"
 #include "kis_brush.h"
+#include "kis_dab_cache_storage.h"
 
 class KisColorSource;
 class KisPressureSharpnessOption;
@@ -48,6 +49,10 @@ struct MirrorProperties;
  *  level.
  *
  *  The texturing and mirroring problems are solved.
+ *
+ *  Apart from the last dab, the generated mask dabs are also kept in
+ *  KisDabCacheStorage, which is shared by all the strokes, so repetitive
+ *  strokes done with the same preset do not generate the masks again.
  */
 class PAINTOP_EXPORT KisDabCache
 {
@@ -111,6 +116,9 @@ private:
             const KisPaintInformation& info,
             QRect *dstDabRect);
 
+    inline KisDabCacheStorage::Key sharedStorageKey(const KoColorSpace *cs,
+            const SavedDabParameters &params);
+
     inline KisFixedPaintDeviceSP fetchDabCommon(const KoColorSpace *cs,
             const KisColorSource *colorSource,
             const KoColor& color,
@@ -0,0 +1,235 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_dab_cache_storage.h"
+
+#include <QCache>
+#include <QGlobalStatic>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <kis_fixed_paint_device.h>
+
+Q_GLOBAL_STATIC(KisDabCacheStorage, s_instance)
+
+namespace {
+
+/**
+ * Big enough for a few hundreds of usual (~100px) dabs, or for a
+ * couple of huge ones
+ */
+const qint64 defaultMemoryLimit = 32 * 1024 * 1024;
+
+/**
+ * QCache counts the cost in ints, so the dabs are measured in KiB
+ */
+inline int costInKiB(qint64 bytes) {
+    return qMax(1, int((bytes + 1023) / 1024));
+}
+
+inline uint combineHash(uint seed, uint value) {
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+struct Entry {
+    Entry(KisFixedPaintDeviceSP _dab) : dab(_dab) {}
+    KisFixedPaintDeviceSP dab;
+};
+
+}
+
+KisDabCacheStorage::Key::Key()
+    : dabColorSpace(0),
+      colorColorSpace(0),
+      width(0),
+      height(0),
+      index(0),
+      angle(0),
+      subPixelX(0),
+      subPixelY(0),
+      softnessFactor(0),
+      horizontalMirror(false),
+      verticalMirror(false)
+{
+}
+
+bool KisDabCacheStorage::Key::operator==(const Key &rhs) const
+{
+    return width == rhs.width &&
+        height == rhs.height &&
+        index == rhs.index &&
+        angle == rhs.angle &&
+        subPixelX == rhs.subPixelX &&
+        subPixelY == rhs.subPixelY &&
+        softnessFactor == rhs.softnessFactor &&
+        horizontalMirror == rhs.horizontalMirror &&
+        verticalMirror == rhs.verticalMirror &&
+        dabColorSpace == rhs.dabColorSpace &&
+        colorColorSpace == rhs.colorColorSpace &&
+        color == rhs.color &&
+        brushKey == rhs.brushKey;
+}
+
+uint qHash(const KisDabCacheStorage::Key &key, uint seed)
+{
+    uint hash = qHash(key.brushKey, seed);
+    hash = combineHash(hash, qHash(key.color));
+    hash = combineHash(hash, qHash(key.dabColorSpace));
+    hash = combineHash(hash, qHash(key.colorColorSpace));
+    hash = combineHash(hash, qHash(key.width));
+    hash = combineHash(hash, qHash(key.height));
+    hash = combineHash(hash, qHash(key.index));
+    hash = combineHash(hash, qHash(key.angle));
+    hash = combineHash(hash, qHash(key.subPixelX));
+    hash = combineHash(hash, qHash(key.subPixelY));
+    hash = combineHash(hash, qHash(key.softnessFactor));
+    hash = combineHash(hash, uint(key.horizontalMirror) | (uint(key.verticalMirror) << 1));
+    return hash;
+}
+
+KisDabCacheStorage::Statistics::Statistics()
+    : hits(0),
+      misses(0),
+      evictions(0),
+      numDabs(0),
+      memoryUsage(0)
+{
+}
+
+qreal KisDabCacheStorage::Statistics::hitRate() const
+{
+    const qint64 total = hits + misses;
+    return total ? qreal(hits) / total : 0.0;
+}
+
+struct KisDabCacheStorage::Private
+{
+    Private()
+        : dabs(costInKiB(defaultMemoryLimit)),
+          memoryLimit(defaultMemoryLimit),
+          hits(0),
+          misses(0),
+          evictions(0)
+    {
+    }
+
+    mutable QMutex mutex;
+
+    // QCache evicts the least recently used entries itself
+    QCache<Key, Entry> dabs;
+    qint64 memoryLimit;
+
+    qint64 hits;
+    qint64 misses;
+    qint64 evictions;
+};
+
+KisDabCacheStorage::KisDabCacheStorage()
+    : m_d(new Private)
+{
+}
+
+KisDabCacheStorage::~KisDabCacheStorage()
+{
+}
+
+KisDabCacheStorage* KisDabCacheStorage::instance()
+{
+    return s_instance;
+}
+
+KisFixedPaintDeviceSP KisDabCacheStorage::fetchDab(const Key &key)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    Entry *entry = m_d->dabs.object(key);
+
+    if (!entry) {
+        m_d->misses++;
+        return 0;
+    }
+
+    m_d->hits++;
+    return entry->dab;
+}
+
+void KisDabCacheStorage::storeDab(const Key &key, KisFixedPaintDeviceSP dab)
+{
+    // the data is implicitly shared, so the copy is cheap
+    KisFixedPaintDeviceSP copy = new KisFixedPaintDevice(*dab);
+    const int cost = costInKiB(copy->bounds().width() * copy->bounds().height() * copy->pixelSize());
+
+    QMutexLocker l(&m_d->mutex);
+
+    const bool replacesEntry = m_d->dabs.contains(key);
+    const int oldSize = m_d->dabs.size();
+
+    // QCache deletes the entry itself if it is too big to be stored
+    if (!m_d->dabs.insert(key, new Entry(copy), cost)) {
+        return;
+    }
+
+    const int expectedSize = oldSize + (replacesEntry ? 0 : 1);
+    m_d->evictions += expectedSize - m_d->dabs.size();
+}
+
+void KisDabCacheStorage::setMemoryLimit(qint64 limit)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    const int oldSize = m_d->dabs.size();
+
+    m_d->memoryLimit = limit;
+    m_d->dabs.setMaxCost(costInKiB(limit));
+
+    m_d->evictions += oldSize - m_d->dabs.size();
+}
+
+qint64 KisDabCacheStorage::memoryLimit() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->memoryLimit;
+}
+
+KisDabCacheStorage::Statistics KisDabCacheStorage::statistics() const
+{
+    QMutexLocker l(&m_d->mutex);
+
+    Statistics stats;
+    stats.hits = m_d->hits;
+    stats.misses = m_d->misses;
+    stats.evictions = m_d->evictions;
+    stats.numDabs = m_d->dabs.size();
+    stats.memoryUsage = qint64(m_d->dabs.totalCost()) * 1024;
+
+    return stats;
+}
+
+void KisDabCacheStorage::resetStatistics()
+{
+    QMutexLocker l(&m_d->mutex);
+
+    m_d->hits = 0;
+    m_d->misses = 0;
+    m_d->evictions = 0;
+}
+
+void KisDabCacheStorage::clear()
+{
+    QMutexLocker l(&m_d->mutex);
+    m_d->dabs.clear();
+}
@@ -0,0 +1,122 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_DAB_CACHE_STORAGE_H
+#define __KIS_DAB_CACHE_STORAGE_H
+
+#include <QByteArray>
+#include <QScopedPointer>
+
+#include "kritapaintop_export.h"
+#include <kis_types.h>
+
+class KoColorSpace;
+
+
+/**
+ * @brief The KisDabCacheStorage class keeps the dabs generated by the
+ * brush-based paintops between the strokes
+ *
+ * KisDabCache can reuse only the last dab, and only inside one stroke.
+ * Repetitive strokes done with the same preset (hatching, stippling)
+ * generate exactly the same dabs over and over again, so the generated
+ * dabs are also put into this storage, which is shared by all the
+ * paintops. The dabs are looked up by a key with quantized parameters,
+ * so a hit skips the mask generation completely.
+ *
+ * The storage is bounded by memoryLimit(), the least recently used dabs
+ * are evicted first. The statistics of the storage can be used for
+ * tuning the limit and the quantization.
+ *
+ * The class is thread-safe.
+ */
+class PAINTOP_EXPORT KisDabCacheStorage
+{
+public:
+    struct PAINTOP_EXPORT Key {
+        Key();
+
+        QByteArray brushKey;
+        const KoColorSpace *dabColorSpace;
+        const KoColorSpace *colorColorSpace;
+        QByteArray color;
+        int width;
+        int height;
+        int index;
+
+        // the quantized values
+        int angle;
+        int subPixelX;
+        int subPixelY;
+        int softnessFactor;
+
+        bool horizontalMirror;
+        bool verticalMirror;
+
+        bool operator==(const Key &rhs) const;
+    };
+
+    struct PAINTOP_EXPORT Statistics {
+        Statistics();
+
+        qint64 hits;
+        qint64 misses;
+        qint64 evictions;
+        int numDabs;
+        qint64 memoryUsage;
+
+        qreal hitRate() const;
+    };
+
+public:
+    KisDabCacheStorage();
+    ~KisDabCacheStorage();
+
+    static KisDabCacheStorage* instance();
+
+    /**
+     * @return the dab stored for \p key or a null pointer if there is
+     * no such dab. The returned device shares the data with the stored
+     * one, so the caller should copy it (which is cheap, the data is
+     * implicitly shared) before modifying.
+     */
+    KisFixedPaintDeviceSP fetchDab(const Key &key);
+
+    /**
+     * Puts a copy of \p dab into the storage. The least recently used
+     * dabs are evicted if the storage exceeds the memory limit.
+     */
+    void storeDab(const Key &key, KisFixedPaintDeviceSP dab);
+
+    /**
+     * The limit in bytes. Default is 32 MiB.
+     */
+    void setMemoryLimit(qint64 limit);
+    qint64 memoryLimit() const;
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+    void clear();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+PAINTOP_EXPORT uint qHash(const KisDabCacheStorage::Key &key, uint seed = 0);
+
+#endif /* __KIS_DAB_CACHE_STORAGE_H */
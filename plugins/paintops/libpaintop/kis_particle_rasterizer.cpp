@@ -0,0 +1,295 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_particle_rasterizer.h"
+
+#include <QHash>
+#include <QPoint>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoCompositeOp.h>
+#include <KoCompositeOpRegistry.h>
+
+#include <kis_assert.h>
+#include <kis_paint_device.h>
+#include <kis_random_accessor_ng.h>
+
+
+namespace {
+
+/**
+ * The size of the bins matches the size of the tiles of the data
+ * manager. If the device is offset, the bins may straddle the tiles,
+ * then the bin falls back to the per-pixel path.
+ */
+const int binSizeShift = 6;
+const int binSize = 1 << binSizeShift;
+
+/**
+ * Splatting a bin costs a task switch, so the bins are splatted
+ * in parallel only when there are enough pixels to amortize it
+ */
+const int minPixelsForParallelRasterization = 4096;
+
+struct Bin {
+    int x;
+    int y;
+    QVector<QPoint> positions;
+    QVector<quint8> colors;
+};
+
+inline quint64 binKey(int x, int y) {
+    return (quint64(quint32(x >> binSizeShift)) << 32) | quint32(y >> binSizeShift);
+}
+
+}
+
+struct KisParticleRasterizer::Private
+{
+    Private(const KoColorSpace *_colorSpace)
+        : colorSpace(_colorSpace),
+          pixelSize(_colorSpace->pixelSize()),
+          mode(OVERWRITE),
+          compositeOp(_colorSpace->compositeOp(COMPOSITE_OVER)),
+          pixelCount(0),
+          lastBinKey(0),
+          lastBin(-1)
+    {
+    }
+
+    const KoColorSpace *colorSpace;
+    const int pixelSize;
+    Mode mode;
+    const KoCompositeOp *compositeOp;
+
+    QVector<Bin> bins;
+    QHash<quint64, int> binIndexes;
+    int pixelCount;
+
+    // particles come in spatially coherent runs, so the lookup
+    // of the last bin saves most of the hash queries
+    quint64 lastBinKey;
+    int lastBin;
+
+    Bin& binForPixel(int x, int y);
+    inline void splatPixel(quint8 *dst, const quint8 *color) const;
+    void splatBin(KisPaintDeviceSP dev, const Bin &bin) const;
+};
+
+Bin& KisParticleRasterizer::Private::binForPixel(int x, int y)
+{
+    const quint64 key = binKey(x, y);
+
+    if (lastBin < 0 || key != lastBinKey) {
+        QHash<quint64, int>::const_iterator it = binIndexes.constFind(key);
+
+        if (it != binIndexes.constEnd()) {
+            lastBin = it.value();
+        } else {
+            Bin bin;
+            bin.x = (x >> binSizeShift) << binSizeShift;
+            bin.y = (y >> binSizeShift) << binSizeShift;
+
+            lastBin = bins.size();
+            bins.append(bin);
+            binIndexes.insert(key, lastBin);
+        }
+        lastBinKey = key;
+    }
+
+    return bins[lastBin];
+}
+
+inline void KisParticleRasterizer::Private::splatPixel(quint8 *dst, const quint8 *color) const
+{
+    switch (mode) {
+    case OVERWRITE:
+        memcpy(dst, color, pixelSize);
+        break;
+    case COMPOSITE:
+        compositeOp->composite(dst, pixelSize, color, pixelSize, 0, 0, 1, 1, OPACITY_OPAQUE_U8);
+        break;
+    case KEEP_MORE_OPAQUE:
+        if (colorSpace->opacityU8(dst) < colorSpace->opacityU8(color)) {
+            memcpy(dst, color, pixelSize);
+        }
+        break;
+    case ACCUMULATE_OPACITY: {
+        const quint8 opacity =
+            quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8,
+                                   colorSpace->opacityU8(color) + colorSpace->opacityU8(dst),
+                                   OPACITY_OPAQUE_U8));
+        memcpy(dst, color, pixelSize);
+        colorSpace->setOpacity(dst, opacity, 1);
+        break;
+    }
+    }
+}
+
+void KisParticleRasterizer::Private::splatBin(KisPaintDeviceSP dev, const Bin &bin) const
+{
+    KisRandomAccessorSP accessor = dev->createRandomAccessorNG(bin.x, bin.y);
+    accessor->moveTo(bin.x, bin.y);
+
+    const int numPixels = bin.positions.size();
+    const QPoint *position = bin.positions.constData();
+    const quint8 *color = bin.colors.constData();
+
+    if (accessor->numContiguousColumns(bin.x) >= binSize &&
+        accessor->numContiguousRows(bin.y) >= binSize) {
+
+        quint8 *base = accessor->rawData();
+        const int rowStride = accessor->rowStride(bin.x, bin.y);
+
+        for (int i = 0; i < numPixels; i++, position++, color += pixelSize) {
+            quint8 *dst = base +
+                (position->y() - bin.y) * rowStride +
+                (position->x() - bin.x) * pixelSize;
+
+            splatPixel(dst, color);
+        }
+    } else {
+        for (int i = 0; i < numPixels; i++, position++, color += pixelSize) {
+            accessor->moveTo(position->x(), position->y());
+            splatPixel(accessor->rawData(), color);
+        }
+    }
+}
+
+KisParticleRasterizer::KisParticleRasterizer(const KoColorSpace *colorSpace)
+    : m_d(new Private(colorSpace))
+{
+}
+
+KisParticleRasterizer::~KisParticleRasterizer()
+{
+}
+
+const KoColorSpace* KisParticleRasterizer::colorSpace() const
+{
+    return m_d->colorSpace;
+}
+
+void KisParticleRasterizer::setMode(Mode mode)
+{
+    m_d->mode = mode;
+}
+
+KisParticleRasterizer::Mode KisParticleRasterizer::mode() const
+{
+    return m_d->mode;
+}
+
+void KisParticleRasterizer::setCompositeOp(const KoCompositeOp *op)
+{
+    m_d->compositeOp = op;
+}
+
+const KoCompositeOp* KisParticleRasterizer::compositeOp() const
+{
+    return m_d->compositeOp;
+}
+
+void KisParticleRasterizer::addPixel(int x, int y, const quint8 *color)
+{
+    Bin &bin = m_d->binForPixel(x, y);
+
+    bin.positions.append(QPoint(x, y));
+
+    const int offset = bin.colors.size();
+    bin.colors.resize(offset + m_d->pixelSize);
+    memcpy(bin.colors.data() + offset, color, m_d->pixelSize);
+
+    m_d->pixelCount++;
+}
+
+void KisParticleRasterizer::addPixel(int x, int y, const KoColor &color)
+{
+    addPixel(x, y, color.data());
+}
+
+void KisParticleRasterizer::addWuParticle(qreal x, qreal y, const KoColor &color)
+{
+    // opacity top left, right, bottom left, right
+    const quint8 opacity = color.opacityU8();
+
+    const int ipx = int(x);
+    const int ipy = int(y);
+    const qreal fx = x - ipx;
+    const qreal fy = y - ipy;
+
+    const quint8 btl = qRound((1.0 - fx) * (1.0 - fy) * opacity);
+    const quint8 btr = qRound((fx)  * (1.0 - fy) * opacity);
+    const quint8 bbl = qRound((1.0 - fx) * (fy)  * opacity);
+    const quint8 bbr = qRound((fx)  * (fy)  * opacity);
+
+    KoColor pcolor(color);
+
+    pcolor.setOpacity(btl);
+    addPixel(ipx, ipy, pcolor.data());
+
+    pcolor.setOpacity(btr);
+    addPixel(ipx + 1, ipy, pcolor.data());
+
+    pcolor.setOpacity(bbl);
+    addPixel(ipx, ipy + 1, pcolor.data());
+
+    pcolor.setOpacity(bbr);
+    addPixel(ipx + 1, ipy + 1, pcolor.data());
+}
+
+int KisParticleRasterizer::pixelCount() const
+{
+    return m_d->pixelCount;
+}
+
+bool KisParticleRasterizer::isEmpty() const
+{
+    return !m_d->pixelCount;
+}
+
+void KisParticleRasterizer::rasterize(KisPaintDeviceSP dev)
+{
+    KIS_SAFE_ASSERT_RECOVER(*dev->colorSpace() == *m_d->colorSpace) {
+        clear();
+        return;
+    }
+
+    if (m_d->bins.size() > 1 && m_d->pixelCount >= minPixelsForParallelRasterization) {
+        const Private *d = m_d.data();
+        QtConcurrent::blockingMap(m_d->bins,
+            [d, dev] (const Bin &bin) {
+                d->splatBin(dev, bin);
+            });
+    } else {
+        Q_FOREACH (const Bin &bin, m_d->bins) {
+            m_d->splatBin(dev, bin);
+        }
+    }
+
+    clear();
+}
+
+void KisParticleRasterizer::clear()
+{
+    m_d->bins.clear();
+    m_d->binIndexes.clear();
+    m_d->pixelCount = 0;
+    m_d->lastBin = -1;
+}
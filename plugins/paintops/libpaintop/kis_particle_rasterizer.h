@@ -0,0 +1,104 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_PARTICLE_RASTERIZER_H
+#define __KIS_PARTICLE_RASTERIZER_H
+
+#include <QScopedPointer>
+#include <QtGlobal>
+
+#include "kritapaintop_export.h"
+#include <kis_types.h>
+
+class KoColor;
+class KoColorSpace;
+class KoCompositeOp;
+
+
+/**
+ * @brief The KisParticleRasterizer class collects single-pixel particles
+ * and writes them onto a paint device tile by tile
+ *
+ * Particle-based paintops (spray, hairy) used to write every pixel of a
+ * dab through a random accessor, which means a tile lookup and locking
+ * for each of the (possibly hundreds of thousands) pixels. The rasterizer
+ * instead bins the particles by tile and splats each bin with direct
+ * pointer access, fetching the tile only once. Bins do not share pixels,
+ * so they are splatted in parallel when there are enough particles.
+ *
+ * The order of the pixels inside a bin is preserved, so order-dependent
+ * modes (e.g. COMPOSITE) give exactly the same result as the sequential
+ * per-pixel code.
+ */
+class PAINTOP_EXPORT KisParticleRasterizer
+{
+public:
+    enum Mode {
+        OVERWRITE,          ///< the color replaces the pixel
+        COMPOSITE,          ///< the color is composited over the pixel with compositeOp()
+        KEEP_MORE_OPAQUE,   ///< the color replaces the pixel only if it is more opaque
+        ACCUMULATE_OPACITY  ///< the color replaces the pixel, the opacities are summed up
+    };
+
+public:
+    KisParticleRasterizer(const KoColorSpace *colorSpace);
+    ~KisParticleRasterizer();
+
+    const KoColorSpace* colorSpace() const;
+
+    void setMode(Mode mode);
+    Mode mode() const;
+
+    /**
+     * Sets the composite op used in COMPOSITE mode. It should belong
+     * to colorSpace(). Default is COMPOSITE_OVER.
+     */
+    void setCompositeOp(const KoCompositeOp *op);
+    const KoCompositeOp* compositeOp() const;
+
+    /**
+     * Adds a single pixel particle. \p color should be in colorSpace()
+     */
+    void addPixel(int x, int y, const quint8 *color);
+    void addPixel(int x, int y, const KoColor &color);
+
+    /**
+     * Adds a Wu particle: the color is spread over four pixels
+     * and its opacity is weighted with the subpixel position.
+     * \p color should be in colorSpace()
+     */
+    void addWuParticle(qreal x, qreal y, const KoColor &color);
+
+    /**
+     * @return the number of pixels added since the last rasterize()
+     */
+    int pixelCount() const;
+    bool isEmpty() const;
+
+    /**
+     * Writes all the collected pixels onto \p dev and clears the
+     * rasterizer. \p dev must be in colorSpace()
+     */
+    void rasterize(KisPaintDeviceSP dev);
+
+    void clear();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_PARTICLE_RASTERIZER_H */
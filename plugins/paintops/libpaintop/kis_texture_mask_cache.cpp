@@ -0,0 +1,218 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_texture_mask_cache.h"
+
+#include <QGlobalStatic>
+#include <QImage>
+#include <QLinkedList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTransform>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <resources/KoPattern.h>
+
+#include "kis_algebra_2d.h"
+#include "kis_global.h"
+
+Q_GLOBAL_STATIC(KisTextureMaskCache, s_instance)
+
+namespace {
+
+/**
+ * A few patterns at a couple of levels of detail are usually in use,
+ * the masks are small, so the limit just prevents unbounded growth
+ * when the user scrolls through the pattern chooser
+ */
+const int maxCachedMasks = 16;
+
+struct CacheEntry {
+    QByteArray patternKey;
+    KisTextureMaskCache::Parameters params;
+    KisTextureMaskSP mask;
+};
+
+QByteArray patternKey(const KoPattern *pattern)
+{
+    QByteArray key = pattern->md5();
+
+    if (key.isEmpty()) {
+        // the pattern was never saved, identify it by the pointer
+        const quintptr address = reinterpret_cast<quintptr>(pattern);
+        key = QByteArray(reinterpret_cast<const char*>(&address), sizeof(address));
+    }
+
+    return key;
+}
+
+}
+
+KisTextureMaskCache::Parameters::Parameters()
+    : scale(1.0),
+      brightness(0.0),
+      contrast(1.0),
+      invert(false),
+      cutoffLeft(0),
+      cutoffRight(255),
+      cutoffPolicy(0)
+{
+}
+
+bool KisTextureMaskCache::Parameters::operator==(const Parameters &rhs) const
+{
+    return qFuzzyCompare(scale, rhs.scale) &&
+        qFuzzyCompare(brightness + 1.0, rhs.brightness + 1.0) &&
+        qFuzzyCompare(contrast, rhs.contrast) &&
+        invert == rhs.invert &&
+        cutoffLeft == rhs.cutoffLeft &&
+        cutoffRight == rhs.cutoffRight &&
+        cutoffPolicy == rhs.cutoffPolicy;
+}
+
+struct KisTextureMaskCache::Private
+{
+    QMutex mutex;
+
+    // the most recently used entries are in the front
+    QLinkedList<CacheEntry> entries;
+};
+
+KisTextureMaskCache::KisTextureMaskCache()
+    : m_d(new Private)
+{
+}
+
+KisTextureMaskCache::~KisTextureMaskCache()
+{
+}
+
+KisTextureMaskCache* KisTextureMaskCache::instance()
+{
+    return s_instance;
+}
+
+KisTextureMaskSP KisTextureMaskCache::fetchMask(const KoPattern *pattern, const Parameters &params)
+{
+    if (!pattern) return KisTextureMaskSP();
+
+    const QByteArray key = patternKey(pattern);
+
+    {
+        QMutexLocker l(&m_d->mutex);
+
+        for (auto it = m_d->entries.begin(); it != m_d->entries.end(); ++it) {
+            if (it->patternKey == key && it->params == params) {
+                CacheEntry entry = *it;
+                m_d->entries.erase(it);
+                m_d->entries.prepend(entry);
+                return entry.mask;
+            }
+        }
+    }
+
+    /**
+     * The mask is generated without holding the lock, so the other
+     * strokes are not blocked. If two threads miss the same entry,
+     * the mask will be generated twice, which is harmless.
+     */
+    CacheEntry entry;
+    entry.patternKey = key;
+    entry.params = params;
+    entry.mask = createMask(pattern, params);
+
+    QMutexLocker l(&m_d->mutex);
+
+    m_d->entries.prepend(entry);
+    while (m_d->entries.size() > maxCachedMasks) {
+        m_d->entries.removeLast();
+    }
+
+    return entry.mask;
+}
+
+KisTextureMaskSP KisTextureMaskCache::createMask(const KoPattern *pattern, const Parameters &params)
+{
+    QImage image = pattern->pattern();
+
+    if ((image.format() != QImage::Format_RGB32) |
+        (image.format() != QImage::Format_ARGB32)) {
+
+        image = image.convertToFormat(QImage::Format_ARGB32);
+    }
+
+    if (!qFuzzyCompare(params.scale, 0.0)) {
+        QTransform tf;
+        tf.scale(params.scale, params.scale);
+        QRect rc = KisAlgebra2D::ensureRectNotSmaller(tf.mapRect(image.rect()), QSize(2,2));
+        image = image.scaled(rc.size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    const QRgb* pixel = reinterpret_cast<const QRgb*>(image.constBits());
+    const int width = image.width();
+    const int height = image.height();
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->alpha8();
+
+    QSharedPointer<KisTextureMask> mask(new KisTextureMask);
+    mask->width = width;
+    mask->height = height;
+    mask->data.resize(width * height);
+
+    quint8 *dst = mask->data.data();
+
+    for (int i = 0; i < width * height; i++, pixel++, dst++) {
+        const QRgb currentPixel = *pixel;
+
+        const int red = qRed(currentPixel);
+        const int green = qGreen(currentPixel);
+        const int blue = qBlue(currentPixel);
+        float alpha = qAlpha(currentPixel) / 255.0;
+
+        const int grayValue = (red * 11 + green * 16 + blue * 5) / 32;
+        float maskValue = (grayValue / 255.0) * alpha + (1 - alpha);
+
+        maskValue = maskValue - params.brightness;
+
+        maskValue = ((maskValue - 0.5) * params.contrast) + 0.5;
+
+        if (maskValue > 1.0) {maskValue = 1;}
+        else if (maskValue < 0) {maskValue = 0;}
+
+        if (params.invert) {
+            maskValue = 1 - maskValue;
+        }
+
+        if (params.cutoffPolicy == 1 && (maskValue < (params.cutoffLeft / 255.0) || maskValue > (params.cutoffRight / 255.0))) {
+            // mask out the dab if it's outside the pattern's cuttoff points
+            maskValue = OPACITY_TRANSPARENT_F;
+        }
+        else if (params.cutoffPolicy == 2 && (maskValue < (params.cutoffLeft / 255.0) || maskValue > (params.cutoffRight / 255.0))) {
+            maskValue = OPACITY_OPAQUE_F;
+        }
+
+        cs->setOpacity(dst, maskValue, 1);
+    }
+
+    return mask;
+}
+
+void KisTextureMaskCache::clear()
+{
+    QMutexLocker l(&m_d->mutex);
+    m_d->entries.clear();
+}
@@ -0,0 +1,100 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_TEXTURE_MASK_CACHE_H
+#define __KIS_TEXTURE_MASK_CACHE_H
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "kritapaintop_export.h"
+
+class KoPattern;
+
+
+/**
+ * A pattern converted into an 8-bit alpha mask with all the texture
+ * adjustments already applied. The mask is stored contiguously, row by
+ * row, and is meant to be tiled over the image.
+ */
+struct PAINTOP_EXPORT KisTextureMask
+{
+    int width;
+    int height;
+    QVector<quint8> data;
+
+    inline const quint8* row(int y) const {
+        return data.constData() + y * width;
+    }
+};
+
+typedef QSharedPointer<const KisTextureMask> KisTextureMaskSP;
+
+
+/**
+ * @brief The KisTextureMaskCache class keeps the recently used texture
+ * masks, so that the paintops created for every stroke (and for every
+ * level of detail) do not have to resample and adjust the pattern again.
+ *
+ * Every level of detail is a separate entry with its own pre-filtered
+ * (smoothly downscaled) mask, that is, the levels of the mipmap are
+ * built lazily when the canvas first switches to them.
+ *
+ * The cache is shared by all the strokes and is thread-safe.
+ */
+class PAINTOP_EXPORT KisTextureMaskCache
+{
+public:
+    struct Parameters {
+        Parameters();
+
+        qreal scale;
+        qreal brightness;
+        qreal contrast;
+        bool invert;
+        int cutoffLeft;
+        int cutoffRight;
+        int cutoffPolicy;
+
+        bool operator==(const Parameters &rhs) const;
+    };
+
+public:
+    KisTextureMaskCache();
+    ~KisTextureMaskCache();
+
+    static KisTextureMaskCache* instance();
+
+    /**
+     * @return the mask for \p pattern adjusted according to \p params,
+     * the mask is generated if it is not present in the cache yet
+     */
+    KisTextureMaskSP fetchMask(const KoPattern *pattern, const Parameters &params);
+
+    /**
+     * Generates the mask without looking into the cache
+     */
+    static KisTextureMaskSP createMask(const KoPattern *pattern, const Parameters &params);
+
+    void clear();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_TEXTURE_MASK_CACHE_H */
@@ -42,9 +42,7 @@
 #include <kis_multipliers_double_slider_spinbox.h>
 #include <resources/KoPattern.h>
 #include <kis_paint_device.h>
-#include <kis_fill_painter.h>
 #include <kis_painter.h>
-#include <kis_iterator_ng.h>
 #include <kis_fixed_paint_device.h>
 #include <kis_gradient_slider.h>
 #include "kis_embedded_pattern_manager.h"
@@ -307,71 +305,16 @@ void KisTextureProperties::recalculateMask()
 {
     if (!m_pattern) return;
 
-    m_mask = 0;
+    KisTextureMaskCache::Parameters params;
+    params.scale = m_scale * KisLodTransform::lodToScale(m_levelOfDetail);
+    params.brightness = m_brightness;
+    params.contrast = m_contrast;
+    params.invert = m_invert;
+    params.cutoffLeft = m_cutoffLeft;
+    params.cutoffRight = m_cutoffRight;
+    params.cutoffPolicy = m_cutoffPolicy;
 
-    QImage mask = m_pattern->pattern();
-
-    if ((mask.format() != QImage::Format_RGB32) |
-        (mask.format() != QImage::Format_ARGB32)) {
-
-        mask = mask.convertToFormat(QImage::Format_ARGB32);
-    }
-
-    qreal scale = m_scale * KisLodTransform::lodToScale(m_levelOfDetail);
-
-    if (!qFuzzyCompare(scale, 0.0)) {
-        QTransform tf;
-        tf.scale(scale, scale);
-        QRect rc = KisAlgebra2D::ensureRectNotSmaller(tf.mapRect(mask.rect()), QSize(2,2));
-        mask = mask.scaled(rc.size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    }
-    const QRgb* pixel = reinterpret_cast<const QRgb*>(mask.constBits());
-    int width = mask.width();
-    int height = mask.height();
-
-    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->alpha8();
-    m_mask = new KisPaintDevice(cs);
-
-    KisHLineIteratorSP iter = m_mask->createHLineIteratorNG(0, 0, width);
-
-    for (int row = 0; row < height; ++row) {
-        for (int col = 0; col < width; ++col) {
-            const QRgb currentPixel = pixel[row * width + col];
-
-            const int red = qRed(currentPixel);
-            const int green = qGreen(currentPixel);
-            const int blue = qBlue(currentPixel);
-            float alpha = qAlpha(currentPixel) / 255.0;
-
-            const int grayValue = (red * 11 + green * 16 + blue * 5) / 32;
-            float maskValue = (grayValue / 255.0) * alpha + (1 - alpha);
-
-            maskValue = maskValue - m_brightness;
-
-            maskValue = ((maskValue - 0.5)*m_contrast)+0.5;
-
-            if (maskValue > 1.0) {maskValue = 1;}
-            else if (maskValue < 0) {maskValue = 0;}
-
-            if (m_invert) {
-                maskValue = 1 - maskValue;
-            }
-
-            if (m_cutoffPolicy == 1 && (maskValue < (m_cutoffLeft / 255.0) || maskValue > (m_cutoffRight / 255.0))) {
-                // mask out the dab if it's outside the pattern's cuttoff points
-                maskValue = OPACITY_TRANSPARENT_F;
-            }
-            else if (m_cutoffPolicy == 2 && (maskValue < (m_cutoffLeft / 255.0) || maskValue > (m_cutoffRight / 255.0))) {
-                maskValue = OPACITY_OPAQUE_F;
-            }
-
-            cs->setOpacity(iter->rawData(), maskValue, 1);
-            iter->nextPixel();
-        }
-        iter->nextRow();
-    }
-
-    m_maskBounds = QRect(0, 0, width, height);
+    m_mask = KisTextureMaskCache::instance()->fetchMask(m_pattern, params);
 }
 
 
@@ -410,41 +353,83 @@ void KisTextureProperties::fillProperties(const KisPropertiesConfigurationSP set
 
 void KisTextureProperties::apply(KisFixedPaintDeviceSP dab, const QPoint &offset, const KisPaintInformation & info)
 {
-    if (!m_enabled) return;
+    if (!m_enabled || !m_mask) return;
 
-    KisPaintDeviceSP fillDevice = new KisPaintDevice(KoColorSpaceRegistry::instance()->alpha8());
-    QRect rect = dab->bounds();
+    const QRect rect = dab->bounds();
+    const int maskWidth = m_mask->width;
+    const int maskHeight = m_mask->height;
 
-    int x = offset.x() % m_maskBounds.width() - m_offsetX;
-    int y = offset.y() % m_maskBounds.height() - m_offsetY;
+    int x = offset.x() % maskWidth - m_offsetX;
+    int y = offset.y() % maskHeight - m_offsetY;
 
-    KisFillPainter fillPainter(fillDevice);
-    fillPainter.fillRect(x - 1, y - 1, rect.width() + 2, rect.height() + 2, m_mask, m_maskBounds);
-    fillPainter.end();
+    // the pattern is tiled from the origin of the image
+    x = x >= 0 ? x % maskWidth : maskWidth - ((-x - 1) % maskWidth + 1);
+    y = y >= 0 ? y % maskHeight : maskHeight - ((-y - 1) % maskHeight + 1);
 
     qreal pressure = m_strengthOption.apply(info);
-    quint8 *dabData = dab->data();
 
-    KisHLineIteratorSP iter = fillDevice->createHLineIteratorNG(x, y, rect.width());
+    /**
+     * The strength does not change within a dab, so the adjusted
+     * mask value is looked up in a table instead of being computed
+     * for every pixel
+     */
+    quint8 lookupTable[256];
+
+    if (m_texturingMode == MULTIPLY) {
+        for (int i = 0; i < 256; i++) {
+            lookupTable[i] = quint8(i * pressure);
+        }
+    } else {
+        int pressureOffset = (1.0 - pressure) * 255;
+
+        for (int i = 0; i < 256; i++) {
+            lookupTable[i] = quint8(qBound(0, i + pressureOffset, 255));
+        }
+    }
+
+    // copy the tiled rows of the cached mask into a dab-sized buffer
+    m_dabMask.resize(rect.width() * rect.height());
+    quint8 *dstPtr = m_dabMask.data();
+
     for (int row = 0; row < rect.height(); ++row) {
-        for (int col = 0; col < rect.width(); ++col) {
-            if (m_texturingMode == MULTIPLY) {
-                dab->colorSpace()->multiplyAlpha(dabData, quint8(*iter->oldRawData() * pressure), 1);
-            }
-            else {
-                int pressureOffset = (1.0 - pressure) * 255;
+        const quint8 *maskRow = m_mask->row((y + row) % maskHeight);
+
+        int maskX = x;
+        int colsLeft = rect.width();
 
-                qint16 maskA = *iter->oldRawData() + pressureOffset;
-                quint8 dabA = dab->colorSpace()->opacityU8(dabData);
+        while (colsLeft > 0) {
+            const int cols = qMin(colsLeft, maskWidth - maskX);
+            const quint8 *srcPtr = maskRow + maskX;
 
-                dabA = qMax(0, (qint16)dabA - maskA);
-                dab->colorSpace()->setOpacity(dabData, dabA, 1);
+            for (int i = 0; i < cols; i++) {
+                dstPtr[i] = lookupTable[srcPtr[i]];
             }
 
-            iter->nextPixel();
-            dabData += dab->pixelSize();
+            dstPtr += cols;
+            colsLeft -= cols;
+            maskX = 0;
         }
-        iter->nextRow();
     }
-}
 
+    const KoColorSpace *cs = dab->colorSpace();
+    const int numPixels = rect.width() * rect.height();
+
+    if (m_texturingMode == MULTIPLY) {
+        cs->applyAlphaU8Mask(dab->data(), m_dabMask.constData(), numPixels);
+    }
+    else {
+        quint8 *dabData = dab->data();
+        const quint8 *maskPtr = m_dabMask.constData();
+        const int pixelSize = dab->pixelSize();
+
+        for (int i = 0; i < numPixels; i++) {
+            qint16 maskA = maskPtr[i];
+            quint8 dabA = cs->opacityU8(dabData);
+
+            dabA = qMax(0, (qint16)dabA - maskA);
+            cs->setOpacity(dabData, dabA, 1);
+
+            dabData += pixelSize;
+        }
+    }
+}
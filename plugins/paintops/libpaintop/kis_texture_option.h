@@ -26,8 +26,10 @@
 #include <kis_types.h>
 #include "kis_paintop_option.h"
 #include "kis_pressure_texture_strength_option.h"
+#include "kis_texture_mask_cache.h"
 
 #include <QRect>
+#include <QVector>
 
 class KisTextureOptionWidget;
 class KoPattern;
@@ -97,8 +99,8 @@ private:
 
 private:
     KisPressureTextureStrengthOption m_strengthOption;
-    QRect m_maskBounds; // this can be different from the extent if we mask out too many pixels in a big mask!
-    KisPaintDeviceSP m_mask;
+    KisTextureMaskSP m_mask;
+    QVector<quint8> m_dabMask;
     void recalculateMask();
 };
 
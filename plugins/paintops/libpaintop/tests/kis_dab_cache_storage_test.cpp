@@ -0,0 +1,126 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_dab_cache_storage_test.h"
+
+#include <QTest>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <kis_fixed_paint_device.h>
+#include <kis_dab_cache_storage.h>
+
+namespace {
+
+KisFixedPaintDeviceSP createDab(int size)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+    dab->setRect(QRect(0, 0, size, size));
+    dab->initialize();
+
+    return dab;
+}
+
+KisDabCacheStorage::Key createKey(int size, int angle)
+{
+    KisDabCacheStorage::Key key;
+    key.brushKey = "brush";
+    key.dabColorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    key.colorColorSpace = key.dabColorSpace;
+    key.color = QByteArray(4, '\xff');
+    key.width = size;
+    key.height = size;
+    key.angle = angle;
+
+    return key;
+}
+
+}
+
+void KisDabCacheStorageTest::testFetchAndStore()
+{
+    KisDabCacheStorage storage;
+
+    KisDabCacheStorage::Key key = createKey(16, 0);
+    QVERIFY(!storage.fetchDab(key));
+
+    KisFixedPaintDeviceSP dab = createDab(16);
+    dab->data()[0] = 42;
+    storage.storeDab(key, dab);
+
+    // the stored dab is a copy, the original may be reused
+    dab->data()[0] = 13;
+
+    KisFixedPaintDeviceSP storedDab = storage.fetchDab(key);
+    QVERIFY(storedDab);
+    QCOMPARE(storedDab->bounds(), QRect(0, 0, 16, 16));
+    QCOMPARE(int(storedDab->data()[0]), 42);
+
+    QVERIFY(!storage.fetchDab(createKey(16, 1)));
+
+    KisDabCacheStorage::Key otherBrushKey = key;
+    otherBrushKey.brushKey = "other brush";
+    QVERIFY(!storage.fetchDab(otherBrushKey));
+
+    KisDabCacheStorage::Statistics stats = storage.statistics();
+    QCOMPARE(stats.hits, qint64(1));
+    QCOMPARE(stats.misses, qint64(3));
+    QCOMPARE(stats.evictions, qint64(0));
+    QCOMPARE(stats.numDabs, 1);
+    QCOMPARE(stats.hitRate(), 0.25);
+
+    storage.resetStatistics();
+    QCOMPARE(storage.statistics().hits, qint64(0));
+    QCOMPARE(storage.statistics().numDabs, 1);
+
+    storage.clear();
+    QVERIFY(!storage.fetchDab(key));
+}
+
+void KisDabCacheStorageTest::testEviction()
+{
+    KisDabCacheStorage storage;
+
+    // 64x64 rgba dab takes 16 KiB
+    storage.setMemoryLimit(3 * 16 * 1024);
+
+    for (int i = 0; i < 3; i++) {
+        storage.storeDab(createKey(64, i), createDab(64));
+    }
+
+    QCOMPARE(storage.statistics().numDabs, 3);
+    QCOMPARE(storage.statistics().memoryUsage, qint64(3 * 16 * 1024));
+
+    // make the first dab the most recently used one
+    QVERIFY(storage.fetchDab(createKey(64, 0)));
+
+    storage.storeDab(createKey(64, 3), createDab(64));
+
+    QCOMPARE(storage.statistics().numDabs, 3);
+    QCOMPARE(storage.statistics().evictions, qint64(1));
+
+    QVERIFY(storage.fetchDab(createKey(64, 0)));
+    QVERIFY(!storage.fetchDab(createKey(64, 1)));
+    QVERIFY(storage.fetchDab(createKey(64, 2)));
+    QVERIFY(storage.fetchDab(createKey(64, 3)));
+
+    storage.setMemoryLimit(16 * 1024);
+    QCOMPARE(storage.statistics().numDabs, 1);
+}
+
+QTEST_MAIN(KisDabCacheStorageTest)
@@ -0,0 +1,161 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_particle_rasterizer_test.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoCompositeOp.h>
+#include <KoCompositeOpRegistry.h>
+
+#include <kis_paint_device.h>
+#include <kis_random_accessor_ng.h>
+#include <kis_particle_rasterizer.h>
+
+Q_DECLARE_METATYPE(KisParticleRasterizer::Mode)
+
+namespace {
+
+struct Particle {
+    QPointF pos;
+    KoColor color;
+};
+
+void referenceSplat(KisRandomAccessorSP accessor, KisParticleRasterizer::Mode mode,
+                    int x, int y, const KoColor &color)
+{
+    const KoColorSpace *cs = color.colorSpace();
+    const int pixelSize = cs->pixelSize();
+
+    accessor->moveTo(x, y);
+    quint8 *dst = accessor->rawData();
+
+    switch (mode) {
+    case KisParticleRasterizer::OVERWRITE:
+        memcpy(dst, color.data(), pixelSize);
+        break;
+    case KisParticleRasterizer::COMPOSITE:
+        cs->compositeOp(COMPOSITE_OVER)->composite(dst, pixelSize, color.data(), pixelSize, 0, 0, 1, 1, OPACITY_OPAQUE_U8);
+        break;
+    case KisParticleRasterizer::KEEP_MORE_OPAQUE:
+        if (cs->opacityU8(dst) < color.opacityU8()) {
+            memcpy(dst, color.data(), pixelSize);
+        }
+        break;
+    case KisParticleRasterizer::ACCUMULATE_OPACITY: {
+        const quint8 opacity = quint8(qMin(255, color.opacityU8() + cs->opacityU8(dst)));
+        memcpy(dst, color.data(), pixelSize);
+        cs->setOpacity(dst, opacity, 1);
+        break;
+    }
+    }
+}
+
+}
+
+void KisParticleRasterizerTest::testModes_data()
+{
+    QTest::addColumn<KisParticleRasterizer::Mode>("mode");
+    QTest::addColumn<int>("numParticles");
+    QTest::addColumn<QPoint>("deviceOffset");
+
+    QTest::newRow("overwrite") << KisParticleRasterizer::OVERWRITE << 300 << QPoint();
+    QTest::newRow("composite") << KisParticleRasterizer::COMPOSITE << 300 << QPoint();
+    QTest::newRow("keep-more-opaque") << KisParticleRasterizer::KEEP_MORE_OPAQUE << 300 << QPoint();
+    QTest::newRow("accumulate") << KisParticleRasterizer::ACCUMULATE_OPACITY << 300 << QPoint();
+
+    // enough pixels to use the parallel path
+    QTest::newRow("composite-parallel") << KisParticleRasterizer::COMPOSITE << 20000 << QPoint();
+    QTest::newRow("accumulate-parallel") << KisParticleRasterizer::ACCUMULATE_OPACITY << 20000 << QPoint();
+
+    // the bins straddle the tiles of an offset device
+    QTest::newRow("composite-offset") << KisParticleRasterizer::COMPOSITE << 20000 << QPoint(13, 27);
+}
+
+void KisParticleRasterizerTest::testModes()
+{
+    QFETCH(KisParticleRasterizer::Mode, mode);
+    QFETCH(int, numParticles);
+    QFETCH(QPoint, deviceOffset);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect area(-100, -100, 400, 300);
+
+    qsrand(1);
+
+    QVector<Particle> particles;
+    for (int i = 0; i < numParticles; i++) {
+        Particle p;
+        p.pos = QPointF(area.x() + (qrand() % (area.width() * 16)) / 16.0,
+                        area.y() + (qrand() % (area.height() * 16)) / 16.0);
+        p.color = KoColor(QColor(qrand() % 256, qrand() % 256, qrand() % 256, qrand() % 256), cs);
+        particles.append(p);
+    }
+
+    KisPaintDeviceSP refDev = new KisPaintDevice(cs);
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    refDev->moveTo(deviceOffset);
+    dev->moveTo(deviceOffset);
+
+    KisRandomAccessorSP accessor = refDev->createRandomAccessorNG(0, 0);
+    KisParticleRasterizer rasterizer(cs);
+    rasterizer.setMode(mode);
+
+    Q_FOREACH (const Particle &p, particles) {
+        // half of the particles are wu-ones
+        if (int(p.pos.x() * 16) % 2) {
+            KoColor color(p.color);
+            const qreal opacity = color.opacityU8();
+
+            const int ipx = int(p.pos.x());
+            const int ipy = int(p.pos.y());
+            const qreal fx = p.pos.x() - ipx;
+            const qreal fy = p.pos.y() - ipy;
+
+            color.setOpacity(quint8(qRound((1.0 - fx) * (1.0 - fy) * opacity)));
+            referenceSplat(accessor, mode, ipx, ipy, color);
+            color.setOpacity(quint8(qRound(fx * (1.0 - fy) * opacity)));
+            referenceSplat(accessor, mode, ipx + 1, ipy, color);
+            color.setOpacity(quint8(qRound((1.0 - fx) * fy * opacity)));
+            referenceSplat(accessor, mode, ipx, ipy + 1, color);
+            color.setOpacity(quint8(qRound(fx * fy * opacity)));
+            referenceSplat(accessor, mode, ipx + 1, ipy + 1, color);
+
+            rasterizer.addWuParticle(p.pos.x(), p.pos.y(), p.color);
+        } else {
+            referenceSplat(accessor, mode, qRound(p.pos.x()), qRound(p.pos.y()), p.color);
+            rasterizer.addPixel(qRound(p.pos.x()), qRound(p.pos.y()), p.color);
+        }
+    }
+
+    QVERIFY(!rasterizer.isEmpty());
+    rasterizer.rasterize(dev);
+    QVERIFY(rasterizer.isEmpty());
+
+    const QRect rc = area.adjusted(-1, -1, 2, 2);
+    QVector<quint8> refBytes(rc.width() * rc.height() * cs->pixelSize());
+    QVector<quint8> bytes(refBytes.size());
+
+    refDev->readBytes(refBytes.data(), rc);
+    dev->readBytes(bytes.data(), rc);
+
+    QVERIFY(refBytes == bytes);
+}
+
+QTEST_MAIN(KisParticleRasterizerTest)
@@ -0,0 +1,101 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_texture_mask_cache_test.h"
+
+#include <QTest>
+#include <QImage>
+
+#include <resources/KoPattern.h>
+#include <kis_texture_mask_cache.h>
+
+namespace {
+
+QImage createPatternImage()
+{
+    QImage image(8, 4, QImage::Format_ARGB32);
+    image.fill(Qt::white);
+
+    for (int x = 0; x < image.width(); x++) {
+        image.setPixel(x, 0, qRgba(0, 0, 0, 255));
+        image.setPixel(x, 1, qRgba(128, 128, 128, 255));
+    }
+
+    return image;
+}
+
+}
+
+void KisTextureMaskCacheTest::testCreateMask()
+{
+    KoPattern pattern(createPatternImage(), "test", "");
+
+    KisTextureMaskCache::Parameters params;
+    KisTextureMaskSP mask = KisTextureMaskCache::createMask(&pattern, params);
+
+    QVERIFY(mask);
+    QCOMPARE(mask->width, 8);
+    QCOMPARE(mask->height, 4);
+    QCOMPARE(mask->data.size(), 32);
+
+    QCOMPARE(int(mask->row(0)[3]), 0);
+    QVERIFY(qAbs(int(mask->row(1)[3]) - 128) <= 1);
+    QCOMPARE(int(mask->row(3)[3]), 255);
+
+    params.invert = true;
+    mask = KisTextureMaskCache::createMask(&pattern, params);
+
+    QCOMPARE(int(mask->row(0)[3]), 255);
+    QCOMPARE(int(mask->row(3)[3]), 0);
+
+    params.invert = false;
+    params.scale = 0.5;
+    mask = KisTextureMaskCache::createMask(&pattern, params);
+
+    QCOMPARE(mask->width, 4);
+    QCOMPARE(mask->height, 2);
+}
+
+void KisTextureMaskCacheTest::testFetchMask()
+{
+    KoPattern pattern(createPatternImage(), "test", "");
+    KisTextureMaskCache cache;
+
+    KisTextureMaskCache::Parameters params;
+    KisTextureMaskSP mask1 = cache.fetchMask(&pattern, params);
+    KisTextureMaskSP mask2 = cache.fetchMask(&pattern, params);
+
+    QVERIFY(mask1);
+    QCOMPARE(mask1.data(), mask2.data());
+
+    params.brightness = 0.2;
+    KisTextureMaskSP mask3 = cache.fetchMask(&pattern, params);
+    QVERIFY(mask3.data() != mask1.data());
+
+    params.brightness = 0.0;
+    params.scale = 0.5;
+    KisTextureMaskSP mask4 = cache.fetchMask(&pattern, params);
+    QVERIFY(mask4.data() != mask1.data());
+
+    cache.clear();
+
+    params.scale = 1.0;
+    KisTextureMaskSP mask5 = cache.fetchMask(&pattern, params);
+    QVERIFY(mask5.data() != mask1.data());
+    QVERIFY(mask5->data == mask1->data);
+}
+
+QTEST_MAIN(KisTextureMaskCacheTest)
@@ -32,7 +32,9 @@
 
 
 #include <QImage>
+#include <QScopedPointer>
 #include <kis_brush.h>
+#include <kis_particle_rasterizer.h>
 
 class KisPaintInformation;
 
@@ -73,11 +75,14 @@ private:
     KisBrushSP m_brush;
     KisFixedPaintDeviceSP m_fixedDab;
 
+    // writes the pixel and wu particles onto the dab tile by tile
+    QScopedPointer<KisParticleRasterizer> m_rasterizer;
+
 private:
     /// rotation in radians according the settings (gauss distribution, uniform distribution or fixed angle)
     qreal rotationAngle(KisRandomSourceSP randomSource);
-    /// Paints Wu Particle
-    void paintParticle(KisRandomAccessorSP &writeAccessor, const KoColor &color, qreal rx, qreal ry);
+    /// Queues Wu Particle into the rasterizer
+    void paintParticle(const KoColor &color, qreal rx, qreal ry);
     void paintCircle(KisPainter * painter, qreal x, qreal y, qreal radius);
     void paintEllipse(KisPainter * painter, qreal x, qreal y, qreal a, qreal b, qreal angle);
     void paintRectangle(KisPainter * painter, qreal x, qreal y, qreal width, qreal height, qreal angle);
@@ -31,6 +31,11 @@
 #include <random>
 #include <iostream>
 #include <functional>
+#include <algorithm>
+#include <numeric>
+
+#include <QtConcurrent>
+#include <QAtomicInt>
 
 
 #include "kis_paint_device.h"
@@ -56,8 +61,11 @@ const int MAX_DIST = 65535;
 const quint8 MASK_SET = 255;
 const quint8 MASK_CLEAR = 0;
 
+//the longest jump of the propagation step of the NN-field minimization
+const int MAX_JUMP_STEP = 16;
+
 class MaskedImage; //forward decl for the forward decl below
-template <typename T> float distance_impl(const MaskedImage& my, int x, int y, const MaskedImage& other, int xo, int yo);
+template <typename T> float distance_impl(const MaskedImage& my, int x, int y, const MaskedImage& other, int xo, int yo, int count, float maskedDistance);
 
 
 class ImageView
@@ -211,7 +219,7 @@ class MaskedImage : public KisShared
 {
 private:
 
-    template <typename T> friend float distance_impl(const MaskedImage& my, int x, int y, const MaskedImage& other, int xo, int yo);
+    template <typename T> friend float distance_impl(const MaskedImage& my, int x, int y, const MaskedImage& other, int xo, int yo, int count, float maskedDistance);
 
     QRect imageSize;
     int nChannels;
@@ -248,7 +256,9 @@ private:
     MaskedImage() {}
 
 public:
-    std::function< float(const MaskedImage&, int, int, const MaskedImage& , int , int ) > distance;
+    //sum of the distances between \p count pixels of a row starting at (x, y) and
+    //the pixels of a row of other image starting at (xo, yo)
+    std::function< float(const MaskedImage&, int, int, const MaskedImage& , int , int, int, float ) > distance;
 
     void toPaintDevice(KisPaintDeviceSP imageDev, QRect rect)
     {
@@ -480,19 +490,37 @@ public:
 
 //Generic version of the distance function. produces distance between colors in the range [0, MAX_DIST]. This
 //is a fast distance computation. More accurate, but very slow implementation is to use color space operations.
-template <typename T> float distance_impl(const MaskedImage& my, int x, int y, const MaskedImage& other, int xo, int yo)
+//The distance is calculated for a run of pixels of a row at once, so the function is called once per row of
+//a patch. A pair of pixels where either of them is masked adds maskedDistance.
+template <typename T> float distance_impl(const MaskedImage& my, int x, int y, const MaskedImage& other, int xo, int yo, int count, float maskedDistance)
 {
-    float dsq = 0;
-    quint32 nchannels = my.channelCount();
-    quint8* v1 = my.imageData(x, y);
-    quint8* v2 = other.imageData(xo, yo);
+    const int nchannels = my.channelCount();
+    const float norm = (float)KoColorSpaceMathsTraits<T>::unitValue * (float)KoColorSpaceMathsTraits<T>::unitValue / MAX_DIST;
+
+    const T* v1 = reinterpret_cast<const T*>(my.imageData(x, y));
+    const T* v2 = reinterpret_cast<const T*>(other.imageData(xo, yo));
+    const quint8* m1 = my.maskData(x, y);
+    const quint8* m2 = other.maskData(xo, yo);
+
+    float sum = 0;
 
-    for (quint32 chan = 0; chan < nchannels; chan++) {
-        //It's very important not to lose precision in the next line
-        float v = ((float)(*((T*)v1 + chan)) - (float)(*((T*)v2 + chan)));
-        dsq += v * v;
+    for (int i = 0; i < count; i++, v1 += nchannels, v2 += nchannels) {
+        //cannot use masked pixels as a valid source of information
+        if (m1[i] > MASK_CLEAR || m2[i] > MASK_CLEAR) {
+            sum += maskedDistance;
+            continue;
+        }
+
+        float dsq = 0;
+        for (int chan = 0; chan < nchannels; chan++) {
+            //It's very important not to lose precision in the next line
+            float v = ((float)v1[chan] - (float)v2[chan]);
+            dsq += v * v;
+        }
+        sum += dsq / norm;
     }
-    return dsq / ( (float)KoColorSpaceMathsTraits<T>::unitValue * (float)KoColorSpaceMathsTraits<T>::unitValue / MAX_DIST );
+
+    return sum;
 }
 
 
@@ -612,130 +640,159 @@ public:
     }
 
     //multi-pass NN-field minimization (see "PatchMatch" paper referenced above - page 4)
+    //
+    //The scanline propagation of the paper is inherently sequential, so the links are
+    //propagated with jump flooding instead: on every step each link is compared with the
+    //links of the four neighbours "step" pixels away, taken from the previous state of
+    //the field. The links do not depend on each other within a step, so the columns of
+    //the field are processed in parallel. The random search is done on the last step.
     void minimize(int pass)
     {
-        int min_x = 0;
-        int min_y = 0;
-        int max_x = imSize.width() - 1;
-        int max_y = imSize.height() - 1;
+        const int W = imSize.width();
+        const int H = imSize.height();
+
+        int maxStep = 1;
+        while (maxStep * 2 <= std::min(MAX_JUMP_STEP, std::max(W, H) / 4)) {
+            maxStep *= 2;
+        }
+
+        NNArray_type previous(boost::extents[W][H]);
+
+        QVector<int> columns(W);
+        std::iota(columns.begin(), columns.end(), 0);
 
         for (int i = 0; i < pass; i++) {
-            //scanline order
-            for (int y = min_y; y < max_y; y++)
-                for (int x = min_x; x <= max_x; x++)
-                    if (field[x][y].distance > 0)
-                        minimizeLink(x, y, 1);
-
-            //reverse scanline order
-            for (int y = max_y; y >= min_y; y--)
-                for (int x = max_x; x >= min_x; x--)
-                    if (field[x][y].distance > 0)
-                        minimizeLink(x, y, -1);
+            QAtomicInt numImproved;
+
+            for (int step = maxStep; step >= 1; step /= 2) {
+                previous = field;
+                const bool randomSearch = step == 1;
+
+                QtConcurrent::blockingMap(columns, [&, step, randomSearch, i] (int x) {
+                    std::minstd_rand generator(quint32(x) * 2654435761U ^ quint32(i * 1024 + step));
+                    int improved = 0;
+
+                    // field[x] is contiguous in y
+                    for (int y = 0; y < H; y++) {
+                        if (field[x][y].distance > 0 &&
+                            minimizeLink(x, y, step, previous, randomSearch, generator)) {
+
+                            improved++;
+                        }
+                    }
+
+                    numImproved.fetchAndAddRelaxed(improved);
+                });
+            }
+
+            //the field has converged
+            if (!numImproved.load()) break;
         }
     }
 
-    void minimizeLink(int x, int y, int dir)
+    //returns true if the link has been improved
+    bool minimizeLink(int x, int y, int step, const NNArray_type &previous, bool randomSearch, std::minstd_rand &generator)
     {
-        int xp, yp, dp;
+        const int W = imSize.width();
+        const int H = imSize.height();
+        const int neighbours[4][2] = {{-step, 0}, {step, 0}, {0, -step}, {0, step}};
 
-        //Propagation Left/Right
-        if (x - dir > 0 && x - dir < imSize.width()) {
-            xp = field[x - dir][y].x + dir;
-            yp = field[x - dir][y].y;
-            dp = distance(x, y, xp, yp);
-            if (dp < field[x][y].distance) {
-                field[x][y].x = xp;
-                field[x][y].y = yp;
-                field[x][y].distance = dp;
-            }
-        }
+        NNPixel &link = field[x][y];
+        bool improved = false;
+
+        //Propagation from the neighbours
+        for (int n = 0; n < 4; n++) {
+            const int dx = neighbours[n][0];
+            const int dy = neighbours[n][1];
+
+            const int xn = x + dx;
+            const int yn = y + dy;
+            if (xn < 0 || xn >= W || yn < 0 || yn >= H)
+                continue;
+
+            const int xp = previous[xn][yn].x - dx;
+            const int yp = previous[xn][yn].y - dy;
+            if (xp == link.x && yp == link.y)
+                continue;
 
-        //Propagation Up/Down
-        if (y - dir > 0 && y - dir < imSize.height()) {
-            xp = field[x][y - dir].x;
-            yp = field[x][y - dir].y + dir;
-            dp = distance(x, y, xp, yp);
-            if (dp < field[x][y].distance) {
-                field[x][y].x = xp;
-                field[x][y].y = yp;
-                field[x][y].distance = dp;
+            const int dp = distance(x, y, xp, yp, link.distance);
+            if (dp < link.distance) {
+                link.x = xp;
+                link.y = yp;
+                link.distance = dp;
+                improved = true;
             }
         }
 
         //Random search
-        int wi = std::max(output->size().width(), output->size().height());
-        int xpi = field[x][y].x;
-        int ypi = field[x][y].y;
-        while (wi > 0) {
-            xp = xpi + randomInt(2 * wi) - wi;
-            yp = ypi + randomInt(2 * wi) - wi;
-            xp = std::max(0, std::min(output->size().width() - 1, xp));
-            yp = std::max(0, std::min(output->size().height() - 1, yp));
-
-            dp = distance(x, y, xp, yp);
-            if (dp < field[x][y].distance) {
-                field[x][y].x = xp;
-                field[x][y].y = yp;
-                field[x][y].distance = dp;
+        if (randomSearch) {
+            int wi = std::max(output->size().width(), output->size().height());
+            const int xpi = link.x;
+            const int ypi = link.y;
+
+            while (wi > 0) {
+                int xp = xpi + int(generator() % (2 * wi)) - wi;
+                int yp = ypi + int(generator() % (2 * wi)) - wi;
+                xp = std::max(0, std::min(output->size().width() - 1, xp));
+                yp = std::max(0, std::min(output->size().height() - 1, yp));
+
+                const int dp = distance(x, y, xp, yp, link.distance);
+                if (dp < link.distance) {
+                    link.x = xp;
+                    link.y = yp;
+                    link.distance = dp;
+                    improved = true;
+                }
+                wi /= 2;
             }
-            wi /= 2;
         }
+
+        return improved;
     }
 
-    //compute distance between two patches
-    int distance(int x, int y, int xp, int yp)
+    //compute distance between two patches. The computation is terminated as soon as
+    //the distance is known to be not less than maxDistance, then maxDistance is returned
+    int distance(int x, int y, int xp, int yp, int maxDistance = MAX_DIST)
     {
+        const int patchWidth = 2 * patchSize + 1;
+        const float ssdmax = nColors * 255 * 255;
+        const float wsum = ssdmax * patchWidth * patchWidth;
+        const float cutoff = (maxDistance + 1) * (wsum / MAX_DIST);
+
+        const int inputWidth = input->size().width();
+        const int inputHeight = input->size().height();
+        const int outputWidth = output->size().width();
+        const int outputHeight = output->size().height();
+
+        //the pixels outside either of the images are not a valid source of information
+        const int dxMin = std::max(-patchSize, std::max(-x, -xp));
+        const int dxMax = std::min(patchSize, std::min(inputWidth - 1 - x, outputWidth - 1 - xp));
+        const int validCount = std::max(0, dxMax - dxMin + 1);
+        const float outsideRowDistance = (patchWidth - validCount) * ssdmax;
+
         float distance = 0;
-        float wsum = 0;
-        float ssdmax = nColors * 255 * 255;
 
-        //for each pixel in the source patch
+        //for each row of the source patch
         for (int dy = -patchSize; dy <= patchSize; dy++) {
-            for (int dx = -patchSize; dx <= patchSize; dx++) {
-                wsum += ssdmax;
-                int xks = x + dx;
-                int yks = y + dy;
-
-                if (xks < 0 || xks >= input->size().width()) {
-                    distance += ssdmax;
-                    continue;
-                }
-
-                if (yks < 0 || yks >= input->size().height()) {
-                    distance += ssdmax;
-                    continue;
-                }
-
-                //cannot use masked pixels as a valid source of information
-                if (input->isMasked(xks, yks)) {
-                    distance += ssdmax;
-                    continue;
-                }
-
-                //corresponding pixel in target patch
-                int xkt = xp + dx;
-                int ykt = yp + dy;
-                if (xkt < 0 || xkt >= output->size().width()) {
-                    distance += ssdmax;
-                    continue;
-                }
-                if (ykt < 0 || ykt >= output->size().height()) {
-                    distance += ssdmax;
-                    continue;
-                }
+            const int yks = y + dy;
+            const int ykt = yp + dy;
 
-                //cannot use masked pixels as a valid source of information
-                if (output->isMasked(xkt, ykt)) {
-                    distance += ssdmax;
-                    continue;
-                }
+            if (!validCount ||
+                yks < 0 || yks >= inputHeight ||
+                ykt < 0 || ykt >= outputHeight) {
 
+                distance += patchWidth * ssdmax;
+            } else {
                 //SSD distance between pixels
-                float ssd = input->distance(*input, xks, yks, *output, xkt, ykt);
-                distance += ssd;
+                distance += outsideRowDistance;
+                distance += input->distance(*input, x + dxMin, yks, *output, xp + dxMin, ykt, validCount, ssdmax);
+            }
 
+            if (distance >= cutoff) {
+                return maxDistance;
             }
         }
+
         return (int)(MAX_DIST * (distance / wsum));
     }
 
@@ -841,7 +898,10 @@ MaskedImageSP NearestNeighborField::ExpectationMaximization(NearestNeighborField
             newtarget = nullptr;
         }
 
-        for (int x = 0; x < target->size().width(); ++x) {
+        QVector<int> columns(target->size().width());
+        std::iota(columns.begin(), columns.end(), 0);
+
+        QtConcurrent::blockingMap(columns, [&] (int x) {
             for (int y = 0; y < target->size().height(); ++y) {
                 if (!source->containsMasked(x, y, radius)) {
                     nnf_TargetToSource->field[x][y].x = x;
@@ -849,7 +909,7 @@ MaskedImageSP NearestNeighborField::ExpectationMaximization(NearestNeighborField
                     nnf_TargetToSource->field[x][y].distance = 0;
                 }
             }
-        }
+        });
 
         //minimize the NNF
         nnf_TargetToSource->minimize(iterNNF);
@@ -895,12 +955,18 @@ void NearestNeighborField::ExpectationStep(NearestNeighborFieldSP nnf, MaskedIma
     int H_source = source->size().height();
     int W_source = source->size().width();
 
-    std::vector< quint8* > pixels;
-    std::vector< float > weights;
-    pixels.reserve(R * R);
-    weights.reserve(R * R);
-    for (int x = 0 ; x < W_target ; ++x) {
-        for (int y = 0 ; y < H_target; ++y) {
+    //every pixel of the target is written by one task only, the images
+    //are row-major, so the rows are processed in parallel
+    QVector<int> rows(H_target);
+    std::iota(rows.begin(), rows.end(), 0);
+
+    QtConcurrent::blockingMap(rows, [&] (int y) {
+        std::vector< quint8* > pixels;
+        std::vector< float > weights;
+        pixels.reserve(R * R);
+        weights.reserve(R * R);
+
+        for (int x = 0 ; x < W_target ; ++x) {
             float wsum = 0;
             pixels.clear();
             weights.clear();
@@ -912,8 +978,8 @@ void NearestNeighborField::ExpectationStep(NearestNeighborFieldSP nnf, MaskedIma
                 weights.push_back(1.f);
                 target->mixColors(pixels, weights, 1.f, target->getImagePixel(x, y));
             } else {
-                for (int dx = -R ; dx <= R; ++dx) {
-                    for (int dy = -R ; dy <= R ; ++dy) {
+                for (int dy = -R ; dy <= R ; ++dy) {
+                    for (int dx = -R ; dx <= R; ++dx) {
                         // xpt,ypt = center pixel of the target patch
                         int xpt = x + dx;
                         int ypt = y + dy;
@@ -962,7 +1028,7 @@ void NearestNeighborField::ExpectationStep(NearestNeighborFieldSP nnf, MaskedIma
                 target->mixColors(pixels, weights, wsum, target->getImagePixel(x, y));
             }
         }
-    }
+    });
 }
 
 QRect getMaskBoundingBox(KisPaintDeviceSP maskDev)
@@ -0,0 +1,68 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_inpaint_benchmark.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_paint_device.h>
+#include "testutil.h"
+
+// defined in kis_inpaint.cpp
+QRect patchImage(KisPaintDeviceSP imageDev, KisPaintDeviceSP maskDev, int radius, int accuracy);
+
+
+void KisInpaintBenchmark::initTestCase()
+{
+    QImage image(TestUtil::fetchDataFileLazy("hakonepa.png"));
+    QVERIFY(!image.isNull());
+
+    m_device = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+    m_device->convertFromQImage(image, 0, 0, 0);
+}
+
+void KisInpaintBenchmark::benchmarkPatch(const QRect &maskRect, int patchRadius, int accuracy)
+{
+    const KoColorSpace *alpha8 = KoColorSpaceRegistry::instance()->alpha8();
+
+    KisPaintDeviceSP mask = new KisPaintDevice(alpha8);
+    KoColor maskColor(alpha8);
+    maskColor.setOpacity(OPACITY_OPAQUE_U8);
+    mask->fill(maskRect, maskColor);
+
+    // the image is modified in place
+    KisPaintDeviceSP dev = new KisPaintDevice(*m_device);
+
+    QBENCHMARK_ONCE {
+        patchImage(dev, mask, patchRadius, accuracy);
+    }
+}
+
+void KisInpaintBenchmark::benchmarkSmallPatch()
+{
+    benchmarkPatch(QRect(200, 150, 40, 40), 4, 50);
+}
+
+void KisInpaintBenchmark::benchmarkLargePatch()
+{
+    benchmarkPatch(QRect(100, 100, 160, 120), 4, 50);
+}
+
+QTEST_MAIN(KisInpaintBenchmark)